@@ -1,5 +1,7 @@
 ﻿#version 460
 
+#include "../common/material_info.glsl"
+
 layout (location = 0) in vec3 vertex_position;
 layout (location = 1) in vec3 vertex_normal;
 
@@ -13,13 +15,7 @@ uniform struct LightInfo
     vec3 Ls;
 } u_light;
 
-uniform struct MaterialInfo
-{
-    vec3 Ka;
-    vec3 Kd;
-    vec3 Ks;
-    float shininess;
-} u_material;
+uniform MaterialInfo u_material;
 
 uniform mat4 u_view_model_matrix;
 uniform mat3 u_normal_matrix;
@@ -5,20 +5,30 @@ layout (location = 1) in vec3 vertex_normal;
 
 layout (location = 0) out vec3 color;
 
-uniform struct LightInfo
+struct LightInfo
 {
     vec4 position_in_view;
     vec3 La;
     vec3 L;
-} u_lights[5];
+};
 
-uniform struct MaterialInfo
+struct MaterialInfo
 {
     vec3 Ka;
     vec3 Kd;
     vec3 Ks;
     float shininess;
-} u_material;
+};
+
+layout (std140) uniform LightBlock
+{
+    LightInfo u_lights[5];
+};
+
+layout (std140) uniform MaterialBlock
+{
+    MaterialInfo u_material;
+};
 
 uniform mat4 u_view_model_matrix;
 uniform mat3 u_normal_matrix;
@@ -1,5 +1,7 @@
 ﻿#version 460
 
+#include "../common/material_info.glsl"
+
 layout (location = 0) in vec3 position_in_view;
 layout (location = 1) in vec3 normal_in_view;
 
@@ -12,13 +14,7 @@ uniform struct LightInfo
     vec3 L;
 } u_light;
 
-uniform struct MaterialInfo
-{
-    vec3 Ka;
-    vec3 Kd;
-    vec3 Ks;
-    float shininess;
-} u_material;
+uniform MaterialInfo u_material;
 
 vec3 CalculateBlinnPhongModel(vec3 position, vec3 normal)
 {
@@ -2,6 +2,8 @@
 
 layout (location = 0) in vec3 position_in_view;
 layout (location = 1) in vec3 normal_in_view;
+layout (location = 2) flat in vec3 material_color;
+layout (location = 3) flat in vec2 material_params;
 
 layout (location = 0) out vec4 fragment_color;
 
@@ -11,25 +13,27 @@ uniform struct LightInfo
     vec3 L;
 } u_lights[3];
 
-uniform struct MaterialInfo
+struct MaterialInfo
 {
     float roughness;
     bool is_metal;
     vec3 color;
-} u_material;
+};
+
+MaterialInfo material;
 
 const float PI = 3.14159265358979323846;
 
 float CalculateGXXDistriubtion(float n_dot_h)
 {
-    float alpha2 = u_material.roughness * u_material.roughness * u_material.roughness * u_material.roughness;
+    float alpha2 = material.roughness * material.roughness * material.roughness * material.roughness;
     float d = (n_dot_h * n_dot_h) * (alpha2 - 1) + 1;
     return alpha2 / (PI * d * d);
 }
 
 float CalculateGeometrySmith(float dot_product)
 {
-    float k = (u_material.roughness + 1.0) * (u_material.roughness + 1.0) / 8.0;
+    float k = (material.roughness + 1.0) * (material.roughness + 1.0) / 8.0;
     float denom = dot_product * (1.0 - k) + k;
     return 1.0 / denom;
 }
@@ -37,9 +41,9 @@ float CalculateGeometrySmith(float dot_product)
 vec3 CalculateSchlickFresnel(float l_dot_h)
 {
     vec3 f0 = vec3(0.04);
-    if (u_material.is_metal)
+    if (material.is_metal)
     {
-        f0 = u_material.color;
+        f0 = material.color;
     }
     return f0 + (1 - f0) * pow(1.0 - l_dot_h, 5);
 }
@@ -47,9 +51,9 @@ vec3 CalculateSchlickFresnel(float l_dot_h)
 vec3 CalculateMicrofacetModel(int light_index, vec3 position, vec3 normal)
 {
     vec3 diffuse_brdf = vec3(0.0);
-    if (!u_material.is_metal)
+    if (!material.is_metal)
     {
-        diffuse_brdf = u_material.color;
+        diffuse_brdf = material.color;
     }
 
     vec3 l = vec3(0.0);
@@ -80,6 +84,8 @@ vec3 CalculateMicrofacetModel(int light_index, vec3 position, vec3 normal)
 
 void main()
 {
+    material = MaterialInfo(material_params.x, material_params.y != 0.0, material_color);
+
     vec3 sum = vec3(0.0);
     vec3 normal = normalize(normal_in_view);
     for(int i = 0; i < 3; ++i)
@@ -1,19 +1,51 @@
 ﻿#version 460
 
+#include "../common/instance_data.glsl"
+
 layout (location = 0) in vec3 vertex_position;
 layout (location = 1) in vec3 vertex_normal;
 
 layout (location = 0) out vec3 position_in_view;
 layout (location = 1) out vec3 normal_in_view;
+layout (location = 2) flat out vec3 material_color;
+layout (location = 3) flat out vec2 material_params;
 
 uniform mat4 u_view_model_matrix;
 uniform mat3 u_normal_matrix;
 uniform mat4 u_mvp_matrix;
 
+uniform struct MaterialInfo
+{
+    float roughness;
+    bool is_metal;
+    vec3 color;
+} u_material;
+
+// 实例化绘制时变换和材质来自实例缓冲: color.rgb 是颜色, params.x 是粗糙度, params.y 非 0 表示金属
+uniform bool u_instanced = false;
+uniform mat4 u_view_matrix;
+uniform mat4 u_projection_matrix;
+
 void main()
 {
-    position_in_view = (u_view_model_matrix * vec4(vertex_position, 1.0)).xyz;
-    normal_in_view = normalize(u_normal_matrix * vertex_normal);
+    mat4 view_model_matrix = u_view_model_matrix;
+    mat3 normal_matrix = u_normal_matrix;
+    mat4 mvp_matrix = u_mvp_matrix;
+    material_color = u_material.color;
+    material_params = vec2(u_material.roughness, u_material.is_metal ? 1.0 : 0.0);
+
+    if (u_instanced)
+    {
+        InstanceData instance = GetInstance();
+        view_model_matrix = u_view_matrix * instance.model_matrix;
+        normal_matrix = mat3(u_view_matrix) * mat3(instance.normal_matrix);
+        mvp_matrix = u_projection_matrix * view_model_matrix;
+        material_color = instance.color.rgb;
+        material_params = instance.params.xy;
+    }
+
+    position_in_view = (view_model_matrix * vec4(vertex_position, 1.0)).xyz;
+    normal_in_view = normalize(normal_matrix * vertex_normal);
 
-    gl_Position = u_mvp_matrix * vec4(vertex_position, 1.0);
+    gl_Position = mvp_matrix * vec4(vertex_position, 1.0);
 }
\ No newline at end of file
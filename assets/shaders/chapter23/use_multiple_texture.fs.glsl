@@ -1,5 +1,7 @@
 ﻿#version 460
 
+#include "../common/light_info.glsl"
+
 layout (location = 0) in vec3 position_in_view;
 layout (location = 1) in vec3 normal_in_view;
 layout (location = 2) in vec2 uv_in_view;
@@ -9,12 +11,7 @@ layout (location = 0) out vec4 fragment_color;
 layout (binding = 0) uniform sampler2D u_brick_texture;
 layout (binding = 1) uniform sampler2D u_moss_texture;
 
-uniform struct LightInfo
-{
-    vec4 position_in_view;
-    vec3 L;
-    vec3 La;
-} u_light;
+uniform LightInfo u_light;
 
 uniform struct MaterialInfo
 {
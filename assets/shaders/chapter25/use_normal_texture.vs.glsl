@@ -1,5 +1,7 @@
 ﻿#version 460
 
+#include "../common/light_info.glsl"
+
 layout (location = 0) in vec3 vertex_position;
 layout (location = 1) in vec3 vertex_normal;
 layout (location = 2) in vec2 vertex_uv;
@@ -9,19 +11,17 @@ layout (location = 0) out vec3 light_direction;
 layout (location = 1) out vec2 uv_in_view;
 layout (location = 2) out vec3 view_direction;
 
-uniform struct LightInfo
-{
-    vec4 position_in_view;
-    vec3 L;
-    vec3 La;
-} u_light;
+uniform LightInfo u_light;
 
+// 位置以 half 存储并按包围盒量化到 [-1, 1], 先还原到模型空间再做其它变换
+uniform mat4 u_dequantize_matrix;
 uniform mat4 u_view_model_matrix;
 uniform mat3 u_normal_matrix;
 uniform mat4 u_mvp_matrix;
 
 void main()
 {
+    vec4 position = u_dequantize_matrix * vec4(vertex_position, 1.0);
     uv_in_view = vertex_uv;
 
     vec3 normal = normalize(u_normal_matrix * vertex_normal);
@@ -35,9 +35,9 @@ void main()
         tangent.z, bi_tangent.z, normal.z
     );
 
-    vec3 position_in_view = (u_view_model_matrix * vec4(vertex_position, 1.0)).xyz;
-    light_direction = to_object_local * (u_light.position_in_view.xyz - vertex_position);
+    vec3 position_in_view = (u_view_model_matrix * position).xyz;
+    light_direction = to_object_local * (u_light.position_in_view.xyz - position.xyz);
     view_direction = to_object_local * normalize(-position_in_view);
 
-    gl_Position = u_mvp_matrix * vec4(vertex_position, 1.0);
+    gl_Position = u_mvp_matrix * position;
 }
\ No newline at end of file
@@ -1,5 +1,7 @@
 ﻿#version 460
 
+#include "../common/light_info.glsl"
+
 layout (location = 0) in vec3 light_direction;
 layout (location = 1) in vec2 uv_in_view;
 layout (location = 2) in vec3 view_direction;
@@ -10,12 +12,7 @@ layout (binding = 0) uniform sampler2D u_color_texture;
 layout (binding = 1) uniform sampler2D u_normal_texture;
 layout (binding = 2) uniform sampler2D u_height_texture;
 
-uniform struct LightInfo
-{
-    vec4 position_in_view;
-    vec3 L;
-    vec3 La;
-} u_light;
+uniform LightInfo u_light;
 
 uniform struct MaterialInfo
 {
@@ -1,5 +1,7 @@
 ﻿#version 460
 
+#include "../common/light_info.glsl"
+
 layout (location = 0) in vec3 vertex_position;
 layout (location = 1) in vec3 vertex_normal;
 layout (location = 2) in vec2 vertex_uv;
@@ -9,12 +11,7 @@ layout (location = 0) out vec3 light_direction;
 layout (location = 1) out vec2 uv_in_view;
 layout (location = 2) out vec3 view_direction;
 
-uniform struct LightInfo
-{
-    vec4 position_in_view;
-    vec3 L;
-    vec3 La;
-} u_light;
+uniform LightInfo u_light;
 
 uniform mat4 u_view_model_matrix;
 uniform mat3 u_normal_matrix;
@@ -1,5 +1,8 @@
 ﻿#version 460
 
+#include "../common/light_info.glsl"
+#include "../common/material_info.glsl"
+
 layout (location = 0) in vec4 view_position;
 layout (location = 1) in vec3 view_normal;
 layout (location = 2) in vec4 projector_uv;
@@ -8,20 +11,9 @@ layout (location = 0) out vec4 fragment_color;
 
 layout (binding = 0) uniform sampler2D u_projector_texture;
 
-uniform struct LightInfo
-{
-    vec4 position_in_view;
-    vec3 L;
-    vec3 La;
-} u_light;
+uniform LightInfo u_light;
 
-uniform struct MaterialInfo
-{
-    vec3 Ka;
-    vec3 Kd;
-    vec3 Ks;
-    float shininess;
-} u_material;
+uniform MaterialInfo u_material;
 
 vec3 CalculateBlinnPhong(vec3 position, vec3 normal)
 {
@@ -1,5 +1,8 @@
 ﻿#version 460
 
+#include "../common/light_info.glsl"
+#include "../common/material_info.glsl"
+
 layout (location = 0) in vec3 position_in_view;
 layout (location = 1) in vec3 normal_in_view;
 
@@ -10,20 +13,9 @@ layout (binding = 0) uniform sampler2D u_render_texture;
 uniform float u_edge_threshold;
 uniform int u_pass;
 
-uniform struct LightInfo
-{
-  vec4 position_in_view;
-  vec3 L;
-  vec3 La;
-} u_light;
+uniform LightInfo u_light;
 
-uniform struct MaterialInfo
-{
-  vec3 Ka;
-  vec3 Kd;
-  vec3 Ks;
-  float shininess;
-} u_material;
+uniform MaterialInfo u_material;
 
 const vec3 lum = vec3(0.2126, 0.7152, 0.0722);
 
@@ -1,5 +1,8 @@
 ﻿#version 460
 
+#include "../common/light_info.glsl"
+#include "../common/material_info.glsl"
+
 layout (location = 0) in vec3 position_in_view;
 layout (location = 1) in vec3 normal_in_view;
 
@@ -7,23 +10,14 @@ layout (location = 0) out vec4 fragment_color;
 
 layout (binding = 0) uniform sampler2D u_render_texture;
 
+#if !defined(PASS) && !defined(USE_SUBROUTINE)
 uniform int u_pass;
+#endif
 uniform float u_weights[5];
 
-uniform struct LightInfo
-{
-  vec4 position_in_view;
-  vec3 L;
-  vec3 La;
-} u_light;
+uniform LightInfo u_light;
 
-uniform struct MaterialInfo
-{
-  vec3 Ka;
-  vec3 Kd;
-  vec3 Ks;
-  float shininess;
-} u_material;
+uniform MaterialInfo u_material;
 
 vec3 CalculateBlinnPhong(vec3 position, vec3 normal)
 {
@@ -44,11 +38,20 @@ vec3 CalculateBlinnPhong(vec3 position, vec3 normal)
     return ambient_color + u_light.L * (diffuse_color + specular_color);
 }
 
+#if defined(USE_SUBROUTINE)
+subroutine vec4 RenderPassType();
+subroutine uniform RenderPassType u_render_pass;
+
+subroutine(RenderPassType)
+#endif
 vec4 Pass1()
 {
     return vec4(CalculateBlinnPhong(position_in_view, normalize(normal_in_view)), 1.0);
 }
 
+#if defined(USE_SUBROUTINE)
+subroutine(RenderPassType)
+#endif
 vec4 Pass2()
 {
     ivec2 pixel_uv = ivec2(gl_FragCoord.xy);
@@ -64,6 +67,9 @@ vec4 Pass2()
     return sum;
 }
 
+#if defined(USE_SUBROUTINE)
+subroutine(RenderPassType)
+#endif
 vec4 Pass3()
 {
     ivec2 pixel_uv = ivec2(gl_FragCoord.xy);
@@ -81,18 +87,29 @@ vec4 Pass3()
 
 void main()
 {
-    if(u_pass == 1)
+#if defined(USE_SUBROUTINE)
+    fragment_color = u_render_pass();
+#else
+#if defined(PASS)
+    // PASS 由宏定义注入, 其余分支在编译期被剔除
+    const int pass = PASS;
+#else
+    int pass = u_pass;
+#endif
+
+    if(pass == 1)
     {
         fragment_color = Pass1();
     }
 
-    if(u_pass == 2)
+    if(pass == 2)
     {
         fragment_color = Pass2();
     }
 
-    if(u_pass == 3)
+    if(pass == 3)
     {
         fragment_color = Pass3();
     }
+#endif
 }
\ No newline at end of file
@@ -1,5 +1,8 @@
 ﻿#version 460
 
+#include "../common/light_info.glsl"
+#include "../common/material_info.glsl"
+
 layout (location = 0) in vec3 position_in_view;
 layout (location = 1) in vec3 normal_in_view;
 layout (location = 2) in vec2 uv_in_view;
@@ -12,20 +15,9 @@ layout (binding = 0) uniform sampler2D u_render_texture;
 uniform int u_pass;
 uniform float u_ave_lum;
 
-uniform struct LightInfo
-{
-  vec4 position_in_view;
-  vec3 L;
-  vec3 La;
-} u_lights[3];
+uniform LightInfo u_lights[3];
 
-uniform struct MaterialInfo
-{
-  vec3 Ka;
-  vec3 Kd;
-  vec3 Ks;
-  float shininess;
-} u_material;
+uniform MaterialInfo u_material;
 
 uniform mat3 u_rgb2xyz = mat3
 (
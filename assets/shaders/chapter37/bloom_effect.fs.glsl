@@ -1,5 +1,8 @@
 ﻿#version 460
 
+#include "../common/light_info.glsl"
+#include "../common/material_info.glsl"
+
 layout (location = 0) in vec3 position_in_view;
 layout (location = 1) in vec3 normal_in_view;
 layout (location = 2) in vec2 uv_in_view;
@@ -16,20 +19,9 @@ uniform float u_pixel_offsets[10] = float[](0.0, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7
 uniform float u_weights[10];
 uniform float u_ave_lum;
 
-uniform struct LightInfo
-{
-  vec4 position_in_view;
-  vec3 L;
-  vec3 La;
-} u_lights[3];
+uniform LightInfo u_lights[3];
 
-uniform struct MaterialInfo
-{
-  vec3 Ka;
-  vec3 Kd;
-  vec3 Ks;
-  float shininess;
-} u_material;
+uniform MaterialInfo u_material;
 
 uniform mat3 u_rgb2xyz = mat3
 (
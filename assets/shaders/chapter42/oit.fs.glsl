@@ -6,6 +6,7 @@ layout (early_fragment_tests) in;
 
 layout (location = 0) in vec3 position_in_view;
 layout (location = 1) in vec3 normal_in_view;
+layout (location = 2) flat in vec4 material_Kd;
 
 layout (location = 0) out vec4 fragment_color;
 
@@ -18,7 +19,6 @@ struct NodeType
 
 uniform vec4 u_light_position;
 uniform vec3 u_light_intensity;
-uniform vec4 u_Kd;
 uniform vec4 u_Ka;
 uniform uint u_max_nodes;
 
@@ -36,7 +36,7 @@ vec3 CalculateDiffuse()
 {
     vec3 s = normalize(u_light_position.xyz - position_in_view);
     vec3 n = normalize(normal_in_view);
-    return u_light_intensity * (u_Ka.rgb + u_Kd.rgb * max(dot(s, n), 0.0));
+    return u_light_intensity * (u_Ka.rgb + material_Kd.rgb * max(dot(s, n), 0.0));
 }
 
 subroutine(RenderPassType)
@@ -60,7 +60,7 @@ void Pass1()
         // Here we set the color and depth of this new node to the color
         // and depth of the fragment.  The next pointer, points to the
         // previous head of the list.
-        b_nodes[node_index].color = vec4(CalculateDiffuse(), u_Kd.a);
+        b_nodes[node_index].color = vec4(CalculateDiffuse(), material_Kd.a);
         b_nodes[node_index].depth = gl_FragCoord.z;
         b_nodes[node_index].next = prev_head;
     }
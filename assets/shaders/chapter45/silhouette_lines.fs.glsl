@@ -1,5 +1,7 @@
 ﻿#version 460
 
+#include "../common/material_info.glsl"
+
 in vec3 g_normal;
 in vec3 g_position;
 flat in int g_is_edge;
@@ -12,13 +14,7 @@ uniform struct LightInfo
     vec3 intensity;
 } u_light;
 
-uniform struct MaterialInfo
-{
-    vec3 Ka;
-    vec3 Kd;
-    vec3 Ks;
-    float shininess;
-} u_material;
+uniform MaterialInfo u_material;
 
 uniform vec4 u_line_color;
 
@@ -0,0 +1,18 @@
+﻿// 每个实例的数据, 与 glsl_shader::InstanceData 一致
+struct InstanceData
+{
+    mat4 model_matrix;
+    mat4 normal_matrix;
+    vec4 color;
+    vec4 params;
+};
+
+layout (std430, binding = 1) readonly buffer InstanceBuffer
+{
+    InstanceData b_instances[];
+};
+
+InstanceData GetInstance()
+{
+    return b_instances[gl_BaseInstance + gl_InstanceID];
+}
@@ -0,0 +1,7 @@
+﻿// 视图空间中的点光源, L 为漫反射和镜面反射的光强, La 为环境光强
+struct LightInfo
+{
+    vec4 position_in_view;
+    vec3 L;
+    vec3 La;
+};
@@ -0,0 +1,8 @@
+﻿// Phong 模型的材质参数
+struct MaterialInfo
+{
+    vec3 Ka;
+    vec3 Kd;
+    vec3 Ks;
+    float shininess;
+};
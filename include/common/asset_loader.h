@@ -0,0 +1,101 @@
+﻿#ifndef __GLSL_SHADER_COMMON_ASSET_LOADER_H__
+#define __GLSL_SHADER_COMMON_ASSET_LOADER_H__
+
+#include "common/thread_pool.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+
+namespace glsl_shader
+{
+    // 异步加载资源: 文件读取和解码在线程池中执行, GL 上传在渲染线程每帧调用 Update() 时按时间预算分批完成,
+    // 第一帧不需要等待资源加载; 结果通过 std::shared_future 返回, 解码或上传中的异常也由 future 传出
+    class AssetLoader
+    {
+    public:
+        explicit AssetLoader(ThreadPool& pool = ThreadPool::GetShared());
+        AssetLoader(const AssetLoader&) = delete;
+        // 等待已经开始的解码任务结束, 还没有上传的资源被丢弃, 对应的 future 得到 broken_promise
+        ~AssetLoader();
+
+        AssetLoader& operator = (const AssetLoader&) = delete;
+
+        // decode 在线程池中执行, 返回一个产生结果的上传函数, 上传函数在渲染线程的 Update() 中执行
+        template <typename T, typename Decode>
+        std::shared_future<T> Load(Decode&& decode);
+
+        // 在渲染线程中调用, 执行等待中的上传直到用完 budget_ms, 至少执行一个; 返回执行的上传数量
+        size_t Update(double budget_ms = 2.0);
+        // 在渲染线程中调用, 阻塞到所有已提交的资源都上传完成
+        void Finish();
+
+        // 还在解码或等待上传的资源数量
+        size_t GetPendingCount() const;
+        bool IsIdle() const;
+
+    private:
+        void PushUpload(std::function<void()> upload);
+        void FinishDecode();
+
+    private:
+        ThreadPool& m_pool;
+        std::deque<std::function<void()>> m_uploads;
+        size_t m_decoding_count;
+        mutable std::mutex m_mutex;
+        std::condition_variable m_condition;
+    };
+
+    template <typename T>
+    bool IsReady(const std::shared_future<T>& future)
+    {
+        return future.valid() && future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+
+    template <typename T, typename Decode>
+    std::shared_future<T> AssetLoader::Load(Decode&& decode)
+    {
+        std::shared_ptr<std::promise<T>> promise = std::make_shared<std::promise<T>>();
+        std::shared_future<T> future = promise->get_future().share();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_decoding_count;
+        }
+
+        // std::function 要求可复制, decode 放在 shared_ptr 里
+        std::shared_ptr<std::decay_t<Decode>> decode_function = std::make_shared<std::decay_t<Decode>>(std::forward<Decode>(decode));
+        m_pool.Submit([this, promise, decode_function]()
+        {
+            try
+            {
+                std::function<T()> upload = (*decode_function)();
+                PushUpload([promise, upload]()
+                {
+                    try
+                    {
+                        promise->set_value(upload());
+                    }
+                    catch (...)
+                    {
+                        promise->set_exception(std::current_exception());
+                    }
+                });
+            }
+            catch (...)
+            {
+                promise->set_exception(std::current_exception());
+            }
+            FinishDecode();
+        });
+
+        return future;
+    }
+}
+
+#endif // !__GLSL_SHADER_COMMON_ASSET_LOADER_H__
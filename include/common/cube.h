@@ -8,11 +8,13 @@ namespace glsl_shader
     class Cube
     {
     public:
-        Cube(float size = 1.0f);
+        Cube(float size = 1.0f, const VertexFormat& format = VertexFormat());
         ~Cube();
 
         void Render();
 
+        const TriangleMesh& GetMesh() const;
+
     private:
         TriangleMesh m_mesh;
     };
@@ -0,0 +1,40 @@
+﻿#ifndef __GLSL_SHADER_COMMON_FNV_HASH_H__
+#define __GLSL_SHADER_COMMON_FNV_HASH_H__
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+namespace glsl_shader
+{
+    // 64 位 FNV-1a 哈希, 用于缓存键和文件变化检测, 不能用于安全相关的场合
+    static const std::uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+    static const std::uint64_t FNV_PRIME = 1099511628211ULL;
+
+    // 把 size 个字节逐个累加到 hash 中, hash 初始值为 FNV_OFFSET_BASIS
+    inline void HashBytes(std::uint64_t& hash, const void* data, size_t size)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= FNV_PRIME;
+        }
+    }
+
+    // 每次取 8 个字节累加, 比逐字节快很多, 结果与 HashBytes 不同, 只用来判断大文件是否变化
+    inline void HashWords(std::uint64_t& hash, const void* data, size_t size)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        size_t word_count = size / sizeof(std::uint64_t);
+        for (size_t i = 0; i < word_count; ++i)
+        {
+            std::uint64_t word = 0;
+            std::memcpy(&word, bytes + i * sizeof(std::uint64_t), sizeof(word));
+            hash = (hash ^ word) * FNV_PRIME;
+        }
+        HashBytes(hash, bytes + word_count * sizeof(std::uint64_t), size - word_count * sizeof(std::uint64_t));
+    }
+}
+
+#endif // !__GLSL_SHADER_COMMON_FNV_HASH_H__
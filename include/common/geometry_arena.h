@@ -0,0 +1,62 @@
+﻿#ifndef __GLSL_SHADER_COMMON_GEOMETRY_ARENA_H__
+#define __GLSL_SHADER_COMMON_GEOMETRY_ARENA_H__
+
+#include "common/triangle_mesh.h"
+
+namespace glsl_shader
+{
+    // 所有网格共用的一个顶点缓冲和一个索引缓冲, 网格是其中的一段, 用 glDrawElementsBaseVertex 绘制
+    // 用 GetVertexFormat() 创建的 TriangleMesh 会分配到这里, 几何缓冲需要比其中的网格活得更久.
+    // 空间只追加不回收: 网格 Terminate 时不归还它的一段, 只有 Terminate 或重新 Init 整个几何缓冲才会释放
+    class GeometryArena
+    {
+    public:
+        GeometryArena();
+        GeometryArena(const GeometryArena&) = delete;
+        ~GeometryArena();
+
+        GeometryArena& operator = (const GeometryArena&) = delete;
+
+        // vertex_capacity 和 index_capacity 分别是顶点和索引的个数, 格式总是交错的
+        void Init(size_t vertex_capacity, size_t index_capacity, const VertexFormat& format = VertexFormat::Compact());
+        void Terminate();
+
+        // 追加一段顶点和索引, 没有初始化或空间不足时抛出 std::runtime_error
+        void Allocate
+        (
+            const void* vertices,
+            size_t vertex_count,
+            const GLuint* indices,
+            size_t index_count,
+            GLint& base_vertex,
+            GLuint& first_index
+        );
+
+        void Bind() const;
+        void Unbind() const;
+
+        GLuint GetVAO() const;
+        GLuint GetVertexBuffer() const;
+        GLuint GetIndexBuffer() const;
+        // 返回的格式指向这个几何缓冲, 传给 TriangleMesh 和各种形状时网格会分配到这里
+        const VertexFormat& GetVertexFormat() const;
+        GLsizei GetVertexSize() const;
+        size_t GetVertexCount() const;
+        size_t GetIndexCount() const;
+        size_t GetVertexCapacity() const;
+        size_t GetIndexCapacity() const;
+
+    private:
+        GLuint m_vao;
+        GLuint m_vertex_buffer;
+        GLuint m_index_buffer;
+        VertexFormat m_format;
+        GLsizei m_vertex_size;
+        size_t m_vertex_capacity;
+        size_t m_index_capacity;
+        size_t m_vertex_count;
+        size_t m_index_count;
+    };
+}
+
+#endif // !__GLSL_SHADER_COMMON_GEOMETRY_ARENA_H__
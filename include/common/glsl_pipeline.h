@@ -0,0 +1,71 @@
+﻿#ifndef __GLSL_SHADER_COMMON_GLSL_PIPELINE_H__
+#define __GLSL_SHADER_COMMON_GLSL_PIPELINE_H__
+
+#include "common/glsl_program.h"
+
+#include <map>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <filesystem>
+#include <cstdint>
+
+namespace glsl_shader
+{
+    // 程序管线对象, 由多个可分离程序的阶段组合而成, 切换组合不需要重新链接
+    class GLSLPipeline
+    {
+    public:
+        GLSLPipeline();
+        GLSLPipeline(const GLSLPipeline&) = delete;
+        ~GLSLPipeline();
+
+        GLSLPipeline& operator = (const GLSLPipeline&) = delete;
+
+        // 使用程序中的所有阶段, 程序必须是已链接的可分离程序
+        void UseProgramStages(GLSLProgram& program);
+        void UseProgramStages(GLbitfield stages, GLSLProgram& program);
+
+        void Validate();
+
+        // 只调用一次 glBindProgramPipeline, 通过 glUseProgram 使用的程序优先于管线, 需要先 glUseProgram(0)
+        void Bind();
+
+        GLuint GetHandle() const;
+
+    public:
+        static GLbitfield GetStageBit(ShaderType shader_type);
+
+    private:
+        GLuint m_handle;
+    };
+
+    // 可分离阶段程序和管线的缓存: 每个阶段文件只编译链接一次,
+    // N 个顶点阶段和 M 个片段阶段组合时只需要 N + M 次链接, 管线在第一次使用时组装
+    class PipelineCache
+    {
+    public:
+        PipelineCache();
+        PipelineCache(const PipelineCache&) = delete;
+        ~PipelineCache();
+
+        PipelineCache& operator = (const PipelineCache&) = delete;
+
+        // 返回阶段句柄, 相同的文件和宏定义返回同一个句柄
+        size_t AddStage(const std::filesystem::path& shader_file_path, const ShaderDefines& defines = ShaderDefines());
+        GLSLProgram& GetStage(size_t stage);
+
+        GLSLPipeline& GetPipeline(const std::vector<size_t>& stages);
+
+        size_t GetStageCount() const;
+        size_t GetPipelineCount() const;
+
+    private:
+        std::vector<std::unique_ptr<GLSLProgram>> m_stages;
+        std::unordered_map<std::uint64_t, size_t> m_stage_indices;
+        std::unordered_map<std::uint64_t, size_t> m_stage_indices_by_path;
+        std::map<std::vector<size_t>, std::unique_ptr<GLSLPipeline>> m_pipelines;
+    };
+}
+
+#endif // !__GLSL_SHADER_COMMON_GLSL_PIPELINE_H__
@@ -6,12 +6,29 @@
 #include "glm/glm.hpp"
 
 #include <string>
+#include <vector>
+#include <map>
 #include <unordered_map>
 #include <stdexcept>
 #include <filesystem>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <set>
+#include <string_view>
+
+// GL_KHR_parallel_shader_compile 的枚举值, glad 生成时未包含该扩展
+#ifndef GL_MAX_SHADER_COMPILER_THREADS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#endif
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
 
 namespace glsl_shader
 {
+    class ProgramCache;
+
     class GLSLProgramException : public std::runtime_error
     {
     public:
@@ -19,6 +36,9 @@ namespace glsl_shader
         virtual ~GLSLProgramException() = default;
     };
 
+    // 预处理宏定义, 名称 -> 值, 使用有序 map 保证相同的宏集合得到相同的源代码
+    typedef std::map<std::string, std::string> ShaderDefines;
+
     enum class ShaderType : unsigned int
     {
         Vertex          = GL_VERTEX_SHADER,
@@ -29,26 +49,93 @@ namespace glsl_shader
         Compute         = GL_COMPUTE_SHADER,
     };
 
+    // 在链接后解析一次的 uniform 位置, 通过模板参数区分类型, 上传时不再需要字符串查找
+    template <typename T>
+    class UniformHandle
+    {
+    public:
+        UniformHandle()
+            : m_location(-1)
+        {
+
+        }
+
+        explicit UniformHandle(GLint location)
+            : m_location(location)
+        {
+
+        }
+
+        GLint GetLocation() const
+        {
+            return m_location;
+        }
+
+        bool IsValid() const
+        {
+            return m_location >= 0;
+        }
+
+    private:
+        GLint m_location;
+    };
+
+    // 统计 uniform 上传次数: 实际调用驱动的次数和因值未变化而跳过的次数
+    struct UniformUploadStats
+    {
+        unsigned long long issued = 0;
+        unsigned long long skipped = 0;
+    };
+
     class GLSLProgram
     {
     public:
         GLSLProgram();
         GLSLProgram(const GLSLProgram&) = delete;
+        GLSLProgram(GLSLProgram&& other) noexcept;
         ~GLSLProgram();
 
         GLSLProgram& operator = (const GLSLProgram&) = delete;
+        GLSLProgram& operator = (GLSLProgram&& other) noexcept;
+
+        // 设置编译时注入到每个着色器阶段的宏定义, 需要在 CompileShader 之前调用
+        void SetDefines(const ShaderDefines& defines);
+        const ShaderDefines& GetDefines() const;
+
+        // 可分离程序可以通过程序管线与其它阶段的程序组合, 需要在 Link 之前调用
+        void SetSeparable(bool is_separable);
+        bool IsSeparable() const;
 
         void CompileShader(const std::filesystem::path& shader_file_path);
+        // 支持 #include "file", 路径相对于包含它的文件, 同一个文件只包含一次
         void CompileShader(const std::filesystem::path& shader_file_path, ShaderType shader_type);
         void CompileShader(const std::string& source, ShaderType shader_type);
 
         void Link();
+
+        // 从记录的着色器文件重新编译链接出新的程序对象, 链接成功后才替换当前程序并保留 uniform 的值,
+        // 失败时抛出异常, 当前程序保持不变. 替换后 uniform 位置可能变化, 之前获取的 UniformHandle 需要重新获取
+        void Reload();
+        const std::vector<std::pair<std::filesystem::path, ShaderType>>& GetShaderFiles() const;
+        // 编译时实际读取的所有文件, 包括着色器文件和展开 #include 时解析到的文件
+        const std::set<std::filesystem::path>& GetShaderDependencies() const;
+        // 所有已添加阶段的类型, 包括从字符串编译的阶段, 链接后仍然保留
+        const std::vector<ShaderType>& GetShaderStages() const;
+
+        // 将 Link() 拆分为提交和等待两步, 以便多个程序的编译可以同时进行
+        void SubmitLink();
+        bool IsLinkComplete();
+        void FinishLink();
+
         void Validate();
         void Use();
 
         int GetHandle();
         bool IsLinked();
 
+        // 所有阶段源代码(已注入宏定义)及绑定关系的哈希, 在 Link() 之前有效
+        std::uint64_t GetSourceHash() const;
+
         void BindAttribLocation(GLuint location, const char* name);
         void BindFragDataLocation(GLuint location, const char* name);
 
@@ -63,6 +150,32 @@ namespace glsl_shader
         void SetUniform(const char* name, int value);
         void SetUniform(const char* name, GLuint value);
 
+        template <typename T>
+        UniformHandle<T> GetUniformHandle(const char* name)
+        {
+            return UniformHandle<T>(GetUniformLocation(name));
+        }
+
+        void SetUniform(const UniformHandle<glm::vec2>& handle, const glm::vec2& value);
+        void SetUniform(const UniformHandle<glm::vec3>& handle, const glm::vec3& value);
+        void SetUniform(const UniformHandle<glm::vec4>& handle, const glm::vec4& value);
+        void SetUniform(const UniformHandle<glm::mat3>& handle, const glm::mat3& value);
+        void SetUniform(const UniformHandle<glm::mat4>& handle, const glm::mat4& value);
+        void SetUniform(const UniformHandle<float>& handle, float value);
+        void SetUniform(const UniformHandle<bool>& handle, bool value);
+        void SetUniform(const UniformHandle<int>& handle, int value);
+        void SetUniform(const UniformHandle<GLuint>& handle, GLuint value);
+
+        unsigned long long GetLookupsSaved() const;
+        void ResetLookupsSaved();
+
+        // 每帧开始时调用 ResetUniformUploadStats, 即可得到每帧的统计
+        UniformUploadStats GetUniformUploadStats() const;
+        void ResetUniformUploadStats();
+
+        // 直接通过 glUniform* 修改过 uniform 后需要调用, 使影子数据失效
+        void InvalidateUniformShadow();
+
         GLuint GetSubroutineIndex(ShaderType shader_type, const char* name);
         void SetSubroutineIndex(ShaderType shader_type, int count, GLuint* indices);
 
@@ -74,15 +187,77 @@ namespace glsl_shader
     private:
         GLint GetUniformLocation(const char* name);
         void DetachAndDeleteShaderObjects();
-        bool FileExists(const std::string& filename);
+        // 程序对象推迟到第一次需要 GL 时才创建, CompileShader 只读取和预处理源代码
+        void CreateHandle();
+        void CompileShader(const std::filesystem::path& shader_file_path, ShaderType shader_type, bool use_source_loader);
+        std::filesystem::path GetBinaryCachePath();
+        bool LoadBinaryCache(const std::filesystem::path& cache_path);
+        void SaveBinaryCache(const std::filesystem::path& cache_path);
+        std::string GetCompileErrors();
+        bool ShouldUpload(GLint location, const void* data, size_t size);
+        void CopyUniformState(GLSLProgram& target);
 
     public:
         static const char* GetTypeString(GLenum type);
+        static size_t GetTypeSize(GLenum type);
+
+        // 设置程序二进制缓存目录, 传入空路径则关闭缓存. 默认是可执行文件旁边的 shader_cache,
+        // 相对路径以可执行文件所在目录为根, 不受启动时工作目录的影响
+        static void SetBinaryCacheDirectory(const std::filesystem::path& directory);
+        static const std::filesystem::path& GetBinaryCacheDirectory();
+
+        static bool IsParallelCompileSupported();
+
+        // 着色器源文件的加载方法, 返回 false 时从磁盘读取. 返回的内容不会被复制, 需要在程序链接前保持有效
+        typedef std::function<bool(const std::filesystem::path&, std::string_view&)> SourceLoader;
+        static void SetSourceLoader(SourceLoader source_loader);
+
+    private:
+        friend class ProgramCache;
+
+        // 提供共享的着色器对象, 为空时程序自己创建和删除着色器对象
+        typedef std::function<GLuint(ShaderType, const std::vector<std::string_view>&)> ShaderProvider;
+
+        // 一个阶段的源代码由多个片段组成(文件内容, 被包含的文件, 宏定义),
+        // 片段直接指向着色器包的映射或 storage 中持有的字符串, 整体传给 glShaderSource
+        struct StageSource
+        {
+            ShaderType type;
+            std::vector<std::string_view> segments;
+            std::vector<std::shared_ptr<const std::string>> storage;
+        };
+
+        void AppendSource(const std::filesystem::path& shader_file_path, StageSource& stage, std::set<std::filesystem::path>& included, bool use_source_loader);
+        void AddStageSource(StageSource&& stage);
+        void CompileAndAttachStage(const StageSource& stage);
+
+        struct UniformShadow
+        {
+            size_t offset = 0;
+            size_t size = 0;
+            bool is_valid = false;
+        };
 
     private:
         GLuint m_handle;
         bool m_is_linked;
         std::unordered_map<std::string, int> m_uniform_locations;
+        unsigned long long m_lookups_saved;
+        std::vector<StageSource> m_stage_sources;
+        std::vector<ShaderType> m_shader_stages;
+        std::uint64_t m_source_hash;
+        bool m_is_link_pending;
+        bool m_is_separable;
+        std::filesystem::path m_binary_cache_path;
+        ShaderDefines m_defines;
+        std::vector<UniformShadow> m_uniform_shadows;
+        std::vector<unsigned char> m_uniform_shadow_data;
+        UniformUploadStats m_upload_stats;
+        std::vector<std::pair<std::filesystem::path, ShaderType>> m_shader_files;
+        std::set<std::filesystem::path> m_shader_dependencies;
+        std::vector<std::pair<GLuint, std::string>> m_attrib_bindings;
+        std::vector<std::pair<GLuint, std::string>> m_frag_data_bindings;
+        ShaderProvider m_shader_provider;
     };
 }
 
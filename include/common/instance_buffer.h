@@ -0,0 +1,50 @@
+﻿#ifndef __GLSL_SHADER_COMMON_INSTANCE_BUFFER_H__
+#define __GLSL_SHADER_COMMON_INSTANCE_BUFFER_H__
+
+#include "glad/gl.h"
+
+#include "glm/glm.hpp"
+
+#include <vector>
+
+namespace glsl_shader
+{
+    // 与 assets/shaders/common/instance_data.glsl 中的 std430 结构一致
+    struct InstanceData
+    {
+        glm::mat4 model_matrix;
+        glm::mat4 normal_matrix;    // 模型矩阵左上角 3x3 的逆转置
+        glm::vec4 color;            // 材质颜色, 含义由着色器决定
+        glm::vec4 params;           // 材质参数, 含义由着色器决定
+    };
+
+    // 保存每个实例的变换和材质的 SSBO, 配合 TriangleMesh::RenderInstanced 使用
+    class InstanceBuffer
+    {
+    public:
+        InstanceBuffer();
+        ~InstanceBuffer();
+
+        void Init(GLuint binding = 1);
+        void Terminate();
+
+        void Clear();
+        // 返回实例在缓冲中的序号
+        GLuint Add(const glm::mat4& model_matrix, const glm::vec4& color = glm::vec4(1.0f), const glm::vec4& params = glm::vec4(0.0f));
+        // 把实例数据上传到显存, 容量不够时重新分配
+        void Upload();
+        void Bind() const;
+
+        GLsizei GetCount() const;
+        GLuint GetBinding() const;
+        GLuint GetBuffer() const;
+
+    private:
+        GLuint m_buffer;
+        GLuint m_binding;
+        size_t m_capacity;
+        std::vector<InstanceData> m_instances;
+    };
+}
+
+#endif // !__GLSL_SHADER_COMMON_INSTANCE_BUFFER_H__
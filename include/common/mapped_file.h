@@ -0,0 +1,40 @@
+﻿#ifndef __GLSL_SHADER_COMMON_MAPPED_FILE_H__
+#define __GLSL_SHADER_COMMON_MAPPED_FILE_H__
+
+#include <filesystem>
+#include <string_view>
+
+namespace glsl_shader
+{
+    // 把整个文件只读映射到内存, 关闭前 GetData() 返回的内存一直有效
+    class MappedFile
+    {
+    public:
+        MappedFile();
+        MappedFile(const MappedFile&) = delete;
+        ~MappedFile();
+
+        MappedFile& operator = (const MappedFile&) = delete;
+
+        // 文件不存在或为空时返回 false
+        bool Open(const std::filesystem::path& file_path);
+        void Close();
+
+        bool IsOpen() const;
+        const char* GetData() const;
+        size_t GetSize() const;
+        std::string_view GetView() const;
+
+    private:
+        const char* m_data;
+        size_t m_size;
+#ifdef _WIN32
+        void* m_file;
+        void* m_mapping;
+#else
+        int m_file;
+#endif
+    };
+}
+
+#endif // !__GLSL_SHADER_COMMON_MAPPED_FILE_H__
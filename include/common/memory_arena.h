@@ -0,0 +1,62 @@
+﻿#ifndef __GLSL_SHADER_COMMON_MEMORY_ARENA_H__
+#define __GLSL_SHADER_COMMON_MEMORY_ARENA_H__
+
+#include <cstddef>
+#include <memory_resource>
+
+namespace glsl_shader
+{
+    // 分配统计, 几个 MemoryArena 共用一份时得到它们合计的峰值
+    struct MemoryArenaStatistics
+    {
+        size_t allocation_count;    // 分配请求的次数
+        size_t block_count;         // 向系统申请内存块的次数
+        size_t reserved_bytes;      // 当前持有的内存块字节数
+        size_t peak_bytes;          // reserved_bytes 的最大值
+    };
+
+    // 单调分配器: 从内存块中顺序切出, 单个对象的释放不做任何事, Release() 时一次归还所有内存块;
+    // 可以作为 std::pmr 容器的 memory_resource, 不是线程安全的
+    class MemoryArena : public std::pmr::memory_resource
+    {
+    public:
+        // block_size 是第一块的大小, 之后每块翻倍, 超过单块上限的请求单独占一块;
+        // statistics 为空时使用自己的统计
+        explicit MemoryArena(size_t block_size = 64 * 1024, MemoryArenaStatistics* statistics = nullptr);
+        MemoryArena(const MemoryArena&) = delete;
+        ~MemoryArena();
+
+        MemoryArena& operator = (const MemoryArena&) = delete;
+
+        void* Allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+        // 之前分配的内存全部失效
+        void Release();
+
+        // 本分配器当前持有的内存块字节数
+        size_t GetReservedBytes() const;
+        const MemoryArenaStatistics& GetStatistics() const;
+
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    private:
+        struct Block
+        {
+            Block* next;
+            size_t size;
+        };
+
+        Block* m_blocks;
+        char* m_current;
+        char* m_end;
+        size_t m_block_size;
+        size_t m_next_block_size;
+        size_t m_reserved_bytes;
+        MemoryArenaStatistics m_own_statistics;
+        MemoryArenaStatistics* m_statistics;
+    };
+}
+
+#endif // !__GLSL_SHADER_COMMON_MEMORY_ARENA_H__
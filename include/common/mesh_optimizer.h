@@ -0,0 +1,57 @@
+﻿#ifndef __GLSL_SHADER_COMMON_MESH_OPTIMIZER_H__
+#define __GLSL_SHADER_COMMON_MESH_OPTIMIZER_H__
+
+#include "glad/gl.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace glsl_shader
+{
+    // 用 FIFO 顶点缓存模拟得到的统计
+    struct VertexCacheStatistics
+    {
+        size_t vertices_transformed;    // 顶点着色器执行次数
+        float acmr;                     // 每个三角形的平均缓存未命中次数
+        float atvr;                     // 顶点着色器执行次数与顶点数之比, 理想值为 1
+    };
+
+    // 三角形列表的索引和顶点重排, 顺序为: 顶点缓存 -> 过度绘制 -> 顶点读取
+    class MeshOptimizer
+    {
+    public:
+        static const unsigned int CACHE_SIZE = 16;
+
+        static VertexCacheStatistics AnalyzeVertexCache(const std::vector<GLuint>& indices, size_t vertex_count, unsigned int cache_size = CACHE_SIZE);
+
+        // Tipsify 顶点缓存重排
+        static void OptimizeVertexCache(std::vector<GLuint>& indices, size_t vertex_count, unsigned int cache_size = CACHE_SIZE);
+
+        // 与视角无关的过度绘制重排: 把三角形分簇, 朝外的簇先画; threshold 是允许的 ACMR 损失比例
+        static void OptimizeOverdraw(std::vector<GLuint>& indices, const std::vector<GLfloat>& positions, float threshold = 1.05f, unsigned int cache_size = CACHE_SIZE);
+
+        // 按索引中第一次出现的顺序重排顶点, 没有用到的顶点放在最后, 索引超出顶点数量时抛出 std::out_of_range
+        static void OptimizeVertexFetch
+        (
+            std::vector<GLuint>& indices,
+            std::vector<GLfloat>& positions,
+            std::vector<GLfloat>& normals,
+            std::vector<GLfloat>* uvs = nullptr,
+            std::vector<GLfloat>* tangents = nullptr
+        );
+
+        // 依次执行三个步骤, before 和 after 不为空时返回优化前后的顶点缓存统计
+        static void Optimize
+        (
+            std::vector<GLuint>& indices,
+            std::vector<GLfloat>& positions,
+            std::vector<GLfloat>& normals,
+            std::vector<GLfloat>* uvs = nullptr,
+            std::vector<GLfloat>* tangents = nullptr,
+            VertexCacheStatistics* before = nullptr,
+            VertexCacheStatistics* after = nullptr
+        );
+    };
+}
+
+#endif // !__GLSL_SHADER_COMMON_MESH_OPTIMIZER_H__
@@ -3,17 +3,34 @@
 
 #include "common/triangle_mesh.h"
 #include "common/bounding_box.h"
+#include "common/memory_arena.h"
+#include "common/asset_loader.h"
 
 #include "glm/glm.hpp"
 
 #include <vector>
 #include <string>
+#include <future>
 #include <memory>
+#include <memory_resource>
+#include <cstdint>
 
 namespace glsl_shader
 {
+    class ThreadPool;
+    class MappedFile;
+
     class ObjMesh
     {
+    public:
+        // 模型没有法线时生成顶点法线, 相邻三角形法线的加权方式
+        enum class NormalWeighting
+        {
+            Uniform,        // 每个三角形的权重相同
+            Area,           // 按三角形面积加权
+            Angle           // 按三角形在该顶点处的内角加权
+        };
+
     public:
         ObjMesh();
         ~ObjMesh();
@@ -24,14 +41,45 @@ namespace glsl_shader
             std::vector<GLfloat>* positions,
             std::vector<GLfloat>* normals,
             std::vector<GLfloat>* uvs = nullptr,
-            std::vector<GLfloat>* tangents = nullptr
+            std::vector<GLfloat>* tangents = nullptr,
+            const VertexFormat& format = VertexFormat()
         );
         void Terminate();
         void Render() const;
+        void RenderInstanced(GLsizei instance_count, GLuint base_instance = 0) const;
+
+        const TriangleMesh& GetMesh() const;
 
     public:
-        static std::unique_ptr<ObjMesh> Load(const char* filename, bool center = false, bool gen_tangents = false);
-        static std::unique_ptr<ObjMesh> LoadWithAdjacency(const char* filename, bool center = false);
+        // 加载结果会缓存到源文件旁边的 .meshcache 文件, 源文件内容和加载选项不变时直接映射缓存上传;
+        // 文件无法打开时抛出 std::runtime_error, LoadAsync 返回的 future 在 get() 时重新抛出
+        static std::unique_ptr<ObjMesh> Load(const char* filename, bool center = false, bool gen_tangents = false, const VertexFormat& format = VertexFormat());
+        // 与 Load 相同, 读取缓存或解析在 loader 的线程池中进行, 上传在渲染线程调用 loader.Update() 时完成
+        static std::shared_future<std::shared_ptr<ObjMesh>> LoadAsync
+        (
+            AssetLoader& loader,
+            const char* filename,
+            bool center = false,
+            bool gen_tangents = false,
+            const VertexFormat& format = VertexFormat()
+        );
+        static std::unique_ptr<ObjMesh> LoadWithAdjacency(const char* filename, bool center = false, const VertexFormat& format = VertexFormat());
+        // 内存受限时使用: 先扫描文件统计数量, 解析, 去重和上传用的数据都从 MemoryArena 一次分配, 上传后立即释放;
+        // 顺序解析, 不运行 MeshOptimizer (format.optimize 被忽略); statistics 不为空时输出分配统计
+        static std::unique_ptr<ObjMesh> LoadCompact
+        (
+            const char* filename,
+            bool center = false,
+            bool gen_tangents = false,
+            const VertexFormat& format = VertexFormat(),
+            MemoryArenaStatistics* statistics = nullptr
+        );
+        // 分别用 1 到 max_thread_count 个线程解析文件并输出耗时和吞吐量, max_thread_count 为 0 时使用 CPU 核心数
+        static void BenchmarkParse(const char* filename, unsigned int max_thread_count = 0);
+        // 用逐对比较的参考实现检查邻接索引, 串行和并行构建的结果都与参考实现逐个索引相同时返回 true, 不需要 GL 上下文
+        static bool CheckAdjacency(const char* filename);
+        // 之后加载的模型使用的法线加权方式, 默认为 Uniform
+        static void SetNormalWeighting(NormalWeighting weighting);
 
     private:
         struct MeshData
@@ -44,42 +92,101 @@ namespace glsl_shader
 
             void Clear();
             void Center(BoundingBox& bounding_box);
-            void ConvertFacesToAdjancencyFormat();
+            // 转换为 GL_TRIANGLES_ADJACENCY 格式, 边界边的相邻顶点取三角形自身的对边顶点
+            void ConvertFacesToAdjancencyFormat(ThreadPool* pool = nullptr);
+            // 逐对比较所有三角形的 O(n²) 实现, 输出与上面的版本逐个索引相同, 只用于 CheckAdjacency
+            void ConvertFacesToAdjancencyFormatReference();
+            MeshView GetView() const;
+        };
+
+        // LoadCompact 使用的 MeshData, 数组从 MemoryArena 分配
+        struct CompactMeshData
+        {
+            std::pmr::vector<GLfloat> positions;
+            std::pmr::vector<GLfloat> normals;
+            std::pmr::vector<GLfloat> uvs;
+            std::pmr::vector<GLuint> faces;
+            std::pmr::vector<GLfloat> tangents;
+
+            explicit CompactMeshData(std::pmr::memory_resource* resource);
+
+            void Clear();
+            void Center(BoundingBox& bounding_box);
+            MeshView GetView() const;
         };
 
         struct ObjMeshData
         {
             struct ObjVertex
             {
+                enum RelativeFlag : unsigned char
+                {
+                    RELATIVE_POSITION = 1,
+                    RELATIVE_NORMAL = 2,
+                    RELATIVE_UV = 4
+                };
+
                 int position_index;
                 int normal_index;
                 int uv_index;
+                unsigned char relative_mask;    // 哪些索引是由负数索引按块内数量解析的
 
                 ObjVertex();
-                ObjVertex(std::string& vertex_string, ObjMeshData* mesh);
-                std::string ToString();
+                // 解析面的一个顶点 "v", "v/vt", "v//vn" 或 "v/vt/vn", 成功时 p 移到顶点之后
+                bool Parse(const char*& p, const char* end, const ObjMeshData& mesh);
             };
 
-            std::vector <glm::vec3> positions;
-            std::vector <glm::vec3> normals;
-            std::vector <glm::vec2> uvs;
-            std::vector <ObjVertex> faces;
-            std::vector <glm::vec4> tangents;
+            // 所有数组和生成时的临时数组都从构造时的 memory_resource 分配
+            std::pmr::vector <glm::vec3> positions;
+            std::pmr::vector <glm::vec3> normals;
+            std::pmr::vector <glm::vec2> uvs;
+            std::pmr::vector <ObjVertex> faces;
+            std::pmr::vector <glm::vec4> tangents;
+
+            explicit ObjMeshData(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
 
-            ObjMeshData();
+            // pool 不为空并且模型足够大时分段并行生成, 结果与顺序生成在浮点舍入误差内一致;
+            // 文件中没有法线时所有面顶点使用生成的法线, 只有部分面顶点带法线时缺少的使用生成的法线
+            void GenerateNormalsIfNeeded(NormalWeighting weighting = NormalWeighting::Uniform, ThreadPool* pool = nullptr);
+            void GenerateTangents(ThreadPool* pool = nullptr);
+            // 返回文件的字节数, 文件无法打开时抛出 std::runtime_error; pool 不为空时把文件按行分块并行解析, 结果与顺序解析相同;
+            // reserve 为 true 时先扫描一遍统计各类元素的数量, 按准确的容量预留后顺序解析
+            size_t Load(const char* filename, BoundingBox& bounding_box, ThreadPool* pool = nullptr, bool reserve = false);
+            void ParseChunk(const char* begin, const char* end, BoundingBox& bounding_box);
+            // 只有部分面顶点带纹理坐标时, 缺少的指向追加在末尾的 (0, 0), Load 在解析后调用
+            void FillMissingUvs();
+            // Data 是 MeshData 或 CompactMeshData, 输出数组按去重后的顶点数一次分配
+            template <typename Data>
+            void ToMesh(Data& data);
+        };
 
-            void GenerateNormalsIfNeeded();
-            void GenerateTangents();
-            void Load(const char* filename, BoundingBox& bounding_box);
-            void ToMesh(MeshData& data);
+        // 网格缓存的键, 源文件内容或影响网格数据的选项变化时缓存失效
+        struct CacheKey
+        {
+            std::uint64_t source_size;
+            std::uint64_t source_hash;
+            std::uint32_t flags;
         };
 
+        // 源文件无法打开时返回 false
+        static bool MakeCacheKey(const char* filename, std::uint32_t flags, CacheKey& key, std::string& cache_path);
+        bool LoadCache(const std::string& cache_path, const CacheKey& key, const VertexFormat& format);
+        // 缓存有效时映射缓存文件并让 view 指向其中的数据, 同时读取包围盒
+        bool MapCache(const std::string& cache_path, const CacheKey& key, MappedFile& cache_file, MeshView& view);
+        void SaveCache(const std::string& cache_path, const CacheKey& key, const MeshView& view) const;
+
+        // Load 分成不需要 GL 的 Prepare 和需要 GL 上下文的 Upload, LoadAsync 在工作线程中调用 Prepare
+        struct PreparedMesh;
+        void Prepare(const char* filename, bool center, bool gen_tangents, const VertexFormat& format, PreparedMesh& prepared);
+        void Upload(PreparedMesh& prepared);
+
     private:
         bool m_is_draw_adj;
         BoundingBox m_bounding_box;
-        GLuint m_vao;
-        GLuint m_vertex_count;
-        std::vector<GLuint> m_buffers;
+        TriangleMesh m_mesh;
+
+    private:
+        static NormalWeighting s_normal_weighting;
     };
 }
 
@@ -8,11 +8,13 @@ namespace glsl_shader
     class Plane
     {
     public:
-        Plane(float xsize, float zsize, int xdivs, int zdivs, float smax = 1.0f, float tmax = 1.0f);
+        Plane(float xsize, float zsize, int xdivs, int zdivs, float smax = 1.0f, float tmax = 1.0f, const VertexFormat& format = VertexFormat());
         ~Plane();
 
         void Render();
 
+        const TriangleMesh& GetMesh() const;
+
     private:
         TriangleMesh m_mesh;
     };
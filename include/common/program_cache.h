@@ -0,0 +1,58 @@
+﻿#ifndef __GLSL_SHADER_COMMON_PROGRAM_CACHE_H__
+#define __GLSL_SHADER_COMMON_PROGRAM_CACHE_H__
+
+#include "common/glsl_program.h"
+
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+namespace glsl_shader
+{
+    struct ProgramCacheStats
+    {
+        unsigned long long program_hits = 0;
+        unsigned long long program_misses = 0;
+        unsigned long long shader_hits = 0;
+        unsigned long long shader_misses = 0;
+    };
+
+    // 按阶段源代码和宏定义去重的程序缓存, 相同的程序只链接一次,
+    // 不同程序之间相同的阶段(例如多个片段着色器共用的顶点着色器)只编译一次.
+    // 同一组文件和宏定义再次请求时直接返回, 源文件的修改通过 GLSLProgram::Reload 生效
+    class ProgramCache
+    {
+    public:
+        ProgramCache();
+        ProgramCache(const ProgramCache&) = delete;
+        ~ProgramCache();
+
+        ProgramCache& operator = (const ProgramCache&) = delete;
+
+        std::shared_ptr<GLSLProgram> GetProgram(const std::vector<std::filesystem::path>& shader_file_paths, const ShaderDefines& defines = ShaderDefines());
+
+        // 释放缓存的程序和着色器对象, 外部仍持有的程序不受影响
+        void Clear();
+
+        ProgramCacheStats GetStats() const;
+        size_t GetProgramCount() const;
+        size_t GetShaderCount() const;
+
+    private:
+        GLuint AcquireShader(ShaderType shader_type, const std::vector<std::string_view>& segments);
+
+    private:
+        // 键保存完整的路径和宏定义或完整的源代码, 而不只是哈希, 哈希冲突时不会返回错误的程序
+        std::unordered_map<std::string, std::shared_ptr<GLSLProgram>> m_programs;
+        std::unordered_map<std::string, std::shared_ptr<GLSLProgram>> m_programs_by_path;
+        std::unordered_map<std::string, GLuint> m_shaders;
+        // 正在链接的程序新编译的着色器, 链接失败时从 m_shaders 中删除
+        std::vector<std::string> m_new_shader_keys;
+        ProgramCacheStats m_stats;
+    };
+}
+
+#endif // !__GLSL_SHADER_COMMON_PROGRAM_CACHE_H__
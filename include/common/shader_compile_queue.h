@@ -0,0 +1,30 @@
+﻿#ifndef __GLSL_SHADER_COMMON_SHADER_COMPILE_QUEUE_H__
+#define __GLSL_SHADER_COMMON_SHADER_COMPILE_QUEUE_H__
+
+#include "common/glsl_program.h"
+
+#include <vector>
+
+namespace glsl_shader
+{
+    // 一次性提交多个着色器程序的所有阶段, 在唯一的等待点统一读取编译和链接结果
+    class ShaderCompileQueue
+    {
+    public:
+        ShaderCompileQueue();
+        ~ShaderCompileQueue();
+
+        void Add(GLSLProgram& program);
+        void Submit();
+        void Join();
+
+    public:
+        // 设置驱动的编译线程数, 需要传入获取函数地址的方法(如 glfwGetProcAddress)
+        static void SetMaxShaderCompilerThreads(GLADloadfunc load, GLuint count);
+
+    private:
+        std::vector<GLSLProgram*> m_programs;
+    };
+}
+
+#endif // !__GLSL_SHADER_COMMON_SHADER_COMPILE_QUEUE_H__
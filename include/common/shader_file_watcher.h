@@ -0,0 +1,54 @@
+﻿#ifndef __GLSL_SHADER_COMMON_SHADER_FILE_WATCHER_H__
+#define __GLSL_SHADER_COMMON_SHADER_FILE_WATCHER_H__
+
+#include "common/glsl_program.h"
+
+#include <set>
+#include <map>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <filesystem>
+
+namespace glsl_shader
+{
+    // 在后台线程中监视着色器程序的源文件及其 #include 的文件(Linux 下使用 inotify, 其它平台轮询修改时间),
+    // 文件变化后由 Poll() 在 GL 线程中重新编译链接, 链接成功才替换程序
+    class ShaderFileWatcher
+    {
+    public:
+        ShaderFileWatcher();
+        ShaderFileWatcher(const ShaderFileWatcher&) = delete;
+        ~ShaderFileWatcher();
+
+        ShaderFileWatcher& operator = (const ShaderFileWatcher&) = delete;
+
+        void Watch(GLSLProgram& program);
+        void Unwatch(GLSLProgram& program);
+
+        void Start();
+        void Stop();
+
+        // 每帧在 GL 线程中调用, 返回成功重新加载的程序数量
+        int Poll();
+
+    private:
+        void Run();
+        void RunNotify();
+        void RunPolling();
+        // 需要持有 m_mutex 调用
+        void AddFiles(const GLSLProgram& program);
+        void MarkChanged(const std::filesystem::path& file_path);
+
+    private:
+        std::vector<GLSLProgram*> m_programs;
+        std::set<std::filesystem::path> m_files;
+        std::set<std::filesystem::path> m_changed_files;
+        std::mutex m_mutex;
+        std::thread m_thread;
+        std::atomic<bool> m_is_running;
+    };
+}
+
+#endif // !__GLSL_SHADER_COMMON_SHADER_FILE_WATCHER_H__
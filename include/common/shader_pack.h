@@ -0,0 +1,52 @@
+﻿#ifndef __GLSL_SHADER_COMMON_SHADER_PACK_H__
+#define __GLSL_SHADER_COMMON_SHADER_PACK_H__
+
+#include "common/glsl_program.h"
+#include "common/mapped_file.h"
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <filesystem>
+#include <cstdint>
+
+namespace glsl_shader
+{
+    // 把一个目录下的所有 GLSL 源文件(包括被 #include 的文件)打包为一个文件, 运行时整体映射到内存,
+    // 着色器源代码直接从映射中交给 glShaderSource, 不需要逐个打开和复制文件
+    class ShaderPack
+    {
+    public:
+        ShaderPack();
+        ShaderPack(const ShaderPack&) = delete;
+        ~ShaderPack();
+
+        ShaderPack& operator = (const ShaderPack&) = delete;
+
+        // source_directory 是打包时的源目录, 文件以相对于它的路径作为键
+        bool Open(const std::filesystem::path& pack_path, const std::filesystem::path& source_directory);
+        void Close();
+
+        bool Find(const std::filesystem::path& shader_file_path, std::string_view& source) const;
+
+        // 遍历源目录计算清单哈希并与打包时记录的比较, 能发现新增和删除的文件, 不读取文件内容
+        bool IsStale() const;
+
+        // 设置为 GLSLProgram 的源文件加载方法, 包中不存在的文件仍从磁盘读取
+        void Install();
+
+        size_t GetFileCount() const;
+
+    public:
+        static void Build(const std::filesystem::path& source_directory, const std::filesystem::path& pack_path);
+
+    private:
+        std::filesystem::path m_source_directory;
+        std::unordered_map<std::string, std::string_view> m_entries;
+        std::uint64_t m_manifest_hash;
+        MappedFile m_file;
+        bool m_is_installed;
+    };
+}
+
+#endif // !__GLSL_SHADER_COMMON_SHADER_PACK_H__
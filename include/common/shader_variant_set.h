@@ -0,0 +1,55 @@
+﻿#ifndef __GLSL_SHADER_COMMON_SHADER_VARIANT_SET_H__
+#define __GLSL_SHADER_COMMON_SHADER_VARIANT_SET_H__
+
+#include "common/glsl_program.h"
+#include "common/program_cache.h"
+
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <filesystem>
+
+namespace glsl_shader
+{
+    // 同一组着色器文件按不同宏定义编译出的特化程序集合, 变体在第一次使用时才编译
+    class ShaderVariantSet
+    {
+    public:
+        ShaderVariantSet();
+        ShaderVariantSet(const std::vector<std::filesystem::path>& shader_file_paths);
+        ShaderVariantSet(const ShaderVariantSet&) = delete;
+        ~ShaderVariantSet();
+
+        ShaderVariantSet& operator = (const ShaderVariantSet&) = delete;
+
+        void AddShader(const std::filesystem::path& shader_file_path);
+
+        // 设置后变体通过 ProgramCache 构建, 变体之间相同的阶段只编译一次
+        void SetProgramCache(ProgramCache* program_cache);
+
+        // 句柄只登记宏集合, 不触发编译, 渲染时通过句柄取程序不需要拼接字符串
+        size_t GetVariantHandle(const ShaderDefines& defines);
+        GLSLProgram& GetVariant(size_t handle);
+        GLSLProgram& GetVariant(const ShaderDefines& defines);
+
+        size_t GetVariantCount() const;
+        size_t GetBuiltVariantCount() const;
+
+    public:
+        static std::string GetDefinesKey(const ShaderDefines& defines);
+
+    private:
+        struct Variant
+        {
+            ShaderDefines defines;
+            std::shared_ptr<GLSLProgram> program;
+        };
+
+        std::vector<std::filesystem::path> m_shader_file_paths;
+        std::vector<Variant> m_variants;
+        std::unordered_map<std::string, size_t> m_variant_indices;
+        ProgramCache* m_program_cache;
+    };
+}
+
+#endif // !__GLSL_SHADER_COMMON_SHADER_VARIANT_SET_H__
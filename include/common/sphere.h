@@ -8,11 +8,13 @@ namespace glsl_shader
     class Sphere
     {
     public:
-        Sphere(float radius, GLuint slices_count, GLuint stacks_count);
+        Sphere(float radius, GLuint slices_count, GLuint stacks_count, const VertexFormat& format = VertexFormat());
         ~Sphere();
 
         void Render();
 
+        const TriangleMesh& GetMesh() const;
+
     private:
         TriangleMesh m_mesh;
     };
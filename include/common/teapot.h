@@ -2,20 +2,40 @@
 #define __GLSL_SHADER_COMMON_TEAPOR_H__
 
 #include "common/triangle_mesh.h"
+#include "common/asset_loader.h"
 
 #include "glm/glm.hpp"
 
+#include <future>
+#include <memory>
+
 namespace glsl_shader
 {
     class Teapot
     {
     public:
-        Teapot(int grid, const glm::mat4& transform);
+        Teapot(int grid, const glm::mat4& transform, const VertexFormat& format = VertexFormat());
         ~Teapot();
 
         void Render();
 
+        const TriangleMesh& GetMesh() const;
+
+    public:
+        // 顶点在 loader 的线程池中生成, 在渲染线程调用 loader.Update() 时上传
+        static std::shared_future<std::shared_ptr<Teapot>> LoadAsync
+        (
+            AssetLoader& loader,
+            int grid,
+            const glm::mat4& transform,
+            const VertexFormat& format = VertexFormat()
+        );
+
     private:
+        Teapot();
+
+        // 只生成顶点和索引, 不需要 GL 上下文
+        void Generate(int grid, const glm::mat4& transform, bool strips, MeshArrays& arrays);
         void GeneratePatches
         (
             std::vector<GLfloat>& positions,
@@ -56,6 +76,8 @@ namespace glsl_shader
             const glm::mat3& reflect,
             bool invert_normal
         );
+        // 用三角形带替换 BuildPatch 生成的三角形列表索引
+        void BuildPatchStrips(std::vector<GLuint>& indices, int patch_count, int grid);
         void GetPatch(int patch_num, glm::vec3 patch[][4], bool reverse_v);
         void ComputeBasisFunctions(std::vector<GLfloat>& buffer, std::vector<GLfloat>& derivative_buffer, int grid);
         glm::vec3 Evaluate(int grid_u, int grid_v, std::vector<GLfloat>& buffer, glm::vec3 patch[][4]);
@@ -3,16 +3,45 @@
 
 #include "glad/gl.h"
 
+#include "common/asset_loader.h"
+
+#include <future>
 #include <string>
 
 namespace glsl_shader
 {
+    // 二维纹理的加载方式, 默认值生成完整的 mipmap 链, 使用三线性加各向异性过滤
+    struct TextureFormat
+    {
+        enum class MipmapSource
+        {
+            None,           // 只有一级, GL_LINEAR 过滤
+            Cpu,            // 解码后在线程池上逐级 2x2 下采样 (奇数尺寸用 3 个像素加权), srgb 为 true 时在线性空间中平均
+            Gpu             // 上传第 0 级后调用 glGenerateMipmap, 由驱动决定滤波方式
+        };
+
+        MipmapSource mipmaps;
+        bool srgb;                      // RGB 按 sRGB 编码, alpha 总是线性的; 法线, 高度等数据纹理应为 false
+        GLfloat max_anisotropy;         // 会被限制在 GL_MAX_TEXTURE_MAX_ANISOTROPY 以内, 1 表示不使用各向异性过滤
+
+        TextureFormat();
+
+        // 法线, 高度等非颜色数据, 下采样时不做 gamma 转换
+        static TextureFormat Linear();
+    };
+
     class Texture
     {
     public:
-        static GLuint LoadTexture(const std::string& filename);
+        static GLuint LoadTexture(const std::string& filename, const TextureFormat& format = TextureFormat());
+        // 六个面在共享线程池上并行解码, 全部完成后一次上传
         static GLuint LoadCubeMap(const std::string& base_name, const std::string& extension = ".png");
         static GLuint LoadHdrCubeMap(const std::string& base_name);
+
+        // 与上面的版本相同, 解码在 loader 的线程池中进行, 纹理在渲染线程调用 loader.Update() 时创建
+        static std::shared_future<GLuint> LoadTextureAsync(AssetLoader& loader, const std::string& filename, const TextureFormat& format = TextureFormat());
+        static std::shared_future<GLuint> LoadCubeMapAsync(AssetLoader& loader, const std::string& base_name, const std::string& extension = ".png");
+        static std::shared_future<GLuint> LoadHdrCubeMapAsync(AssetLoader& loader, const std::string& base_name);
     };
 }
 
@@ -0,0 +1,65 @@
+﻿#ifndef __GLSL_SHADER_COMMON_THREAD_POOL_H__
+#define __GLSL_SHADER_COMMON_THREAD_POOL_H__
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace glsl_shader
+{
+    // 固定数量的工作线程, 任务按提交顺序执行
+    class ThreadPool
+    {
+    public:
+        // thread_count 为 0 时使用 std::thread::hardware_concurrency()
+        explicit ThreadPool(unsigned int thread_count = 0);
+        ThreadPool(const ThreadPool&) = delete;
+        ~ThreadPool();
+
+        ThreadPool& operator = (const ThreadPool&) = delete;
+
+        template <typename Function>
+        std::future<std::invoke_result_t<Function>> Submit(Function&& function);
+
+        // 对 [0, count) 中的每个 i 调用 body(i), 调用线程也参与执行, 返回时全部完成;
+        // 可以在池中的任务里调用, 不会因为等待其它工作线程而死锁
+        void ParallelFor(size_t count, const std::function<void(size_t)>& body);
+
+        unsigned int GetThreadCount() const;
+
+    public:
+        // 进程内共享的线程池, 第一次使用时创建
+        static ThreadPool& GetShared();
+
+    private:
+        void Enqueue(std::function<void()> task);
+        void WorkerLoop();
+
+    private:
+        std::vector<std::thread> m_threads;
+        std::deque<std::function<void()>> m_tasks;
+        std::mutex m_mutex;
+        std::condition_variable m_condition;
+        bool m_is_stopping;
+    };
+
+    template <typename Function>
+    std::future<std::invoke_result_t<Function>> ThreadPool::Submit(Function&& function)
+    {
+        using Result = std::invoke_result_t<Function>;
+
+        // std::function 要求可复制, packaged_task 只能移动, 所以放在 shared_ptr 里
+        std::shared_ptr<std::packaged_task<Result()>> task = std::make_shared<std::packaged_task<Result()>>(std::forward<Function>(function));
+        std::future<Result> result = task->get_future();
+        Enqueue([task]() { (*task)(); });
+        return result;
+    }
+}
+
+#endif // !__GLSL_SHADER_COMMON_THREAD_POOL_H__
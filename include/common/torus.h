@@ -2,17 +2,41 @@
 #define __GLSL_SHADER_COMMON_TORUS_H__
 
 #include "common/triangle_mesh.h"
+#include "common/asset_loader.h"
+
+#include <future>
+#include <memory>
 
 namespace glsl_shader
 {
     class Torus
     {
     public:
-        Torus(GLfloat outer_radius, GLfloat inner_radius, GLuint sides_count, GLuint rings_count);
+        Torus(GLfloat outer_radius, GLfloat inner_radius, GLuint sides_count, GLuint rings_count, const VertexFormat& format = VertexFormat());
         ~Torus();
 
         void Render();
 
+        const TriangleMesh& GetMesh() const;
+
+    public:
+        // 顶点在 loader 的线程池中生成, 在渲染线程调用 loader.Update() 时上传
+        static std::shared_future<std::shared_ptr<Torus>> LoadAsync
+        (
+            AssetLoader& loader,
+            GLfloat outer_radius,
+            GLfloat inner_radius,
+            GLuint sides_count,
+            GLuint rings_count,
+            const VertexFormat& format = VertexFormat()
+        );
+
+    private:
+        Torus();
+
+        // 只生成顶点和索引, 不需要 GL 上下文
+        static void Generate(GLfloat outer_radius, GLfloat inner_radius, GLuint sides_count, GLuint rings_count, bool strips, MeshArrays& arrays);
+
     private:
         TriangleMesh m_mesh;
     };
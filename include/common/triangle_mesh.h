@@ -3,12 +3,100 @@
 
 #include "glad/gl.h"
 
+#include "glm/glm.hpp"
+
+#include <memory_resource>
 #include <vector>
 
 namespace glsl_shader
 {
+    class GeometryArena;
+
+    // 顶点布局, 默认值与原来的行为一致: 每个属性一个独立的 GL_FLOAT 缓冲
+    struct VertexFormat
+    {
+        enum class PositionType
+        {
+            Float,          // 3 x float, 12 字节
+            Half            // 4 x half, 8 字节, 按包围盒量化到 [-1, 1], 需要配合 GetDequantizeTransform()
+        };
+
+        enum class NormalType
+        {
+            Float,          // 法线 3 x float, 切线 4 x float
+            Packed          // GL_INT_2_10_10_10_REV, 法线和切线各 4 字节
+        };
+
+        enum class UvType
+        {
+            Float,          // 2 x float, 8 字节
+            Half,           // 2 x half, 4 字节
+            Unorm16         // 2 x unorm16, 4 字节, 只适用于 [0, 1] 范围内的纹理坐标
+        };
+
+        bool interleaved;
+        PositionType position;
+        NormalType normal;
+        UvType uv;
+        bool optimize;                  // 初始化时用 MeshOptimizer 重排三角形列表的索引和顶点, 会直接修改传入的数组
+        bool strips;                    // Plane, Sphere, Torus, Teapot 按行生成三角形带, 行之间用图元重启索引分隔
+        GeometryArena* arena;           // 非空时网格追加到这个几何缓冲中, 通常直接使用 GeometryArena::GetVertexFormat()
+
+        VertexFormat();
+
+        // 单个交错缓冲, 法线和切线打包, 纹理坐标使用 half
+        static VertexFormat Compact(bool half_positions = false);
+    };
+
+    // 单个顶点属性在缓冲中的格式, 交错布局时 offset 是属性在顶点内的偏移, 否则是属性数据块在缓冲中的偏移
+    struct VertexAttribute
+    {
+        bool enabled;
+        GLint size;
+        GLenum type;
+        GLboolean normalized;
+        GLsizei bytes;
+        size_t offset;
+    };
+
+    // 外部内存中准备好的网格数据, 例如映射到内存的网格缓存, 上传时不经过中间的 std::vector
+    struct MeshView
+    {
+        size_t vertex_count;
+        const GLfloat* positions;       // 每个顶点 3 个 float
+        const GLfloat* normals;         // 每个顶点 3 个 float
+        const GLfloat* uvs;             // 每个顶点 2 个 float, 可以为 nullptr
+        const GLfloat* tangents;        // 每个顶点 4 个 float, 可以为 nullptr
+        size_t index_count;
+        GLenum index_type;              // 索引的宽度, 图元重启索引为类型的最大值
+        const void* indices;
+    };
+
+    // 在 CPU 上生成, 还没有上传的网格数组, 异步加载时在工作线程中填充, 在渲染线程中交给 TriangleMesh::Init
+    struct MeshArrays
+    {
+        std::vector<GLuint> indices;
+        std::vector<GLfloat> positions;
+        std::vector<GLfloat> normals;
+        std::vector<GLfloat> uvs;
+        std::vector<GLfloat> tangents;
+    };
+
     class TriangleMesh
     {
+    public:
+        enum AttributeIndex
+        {
+            ATTRIBUTE_POSITION = 0,
+            ATTRIBUTE_NORMAL,
+            ATTRIBUTE_UV,
+            ATTRIBUTE_TANGENT,
+            ATTRIBUTE_COUNT
+        };
+
+        // 三角形带之间的分隔索引, 上传时换成对应索引类型的最大值, 绘制时开启 GL_PRIMITIVE_RESTART_FIXED_INDEX
+        static const GLuint RESTART_INDEX = 0xFFFFFFFF;
+
     public:
         TriangleMesh();
         ~TriangleMesh();
@@ -19,24 +107,94 @@ namespace glsl_shader
             std::vector<GLfloat>* positions,
             std::vector<GLfloat>* normals,
             std::vector<GLfloat>* uvs = nullptr,
-            std::vector<GLfloat>* tangents = nullptr
+            std::vector<GLfloat>* tangents = nullptr,
+            const VertexFormat& format = VertexFormat(),
+            GLenum mode = GL_TRIANGLES
         );
+        // 不会运行 MeshOptimizer; 独立缓冲的格式全部是 float 时属性直接从 view 上传;
+        // 编码顶点和转换索引的临时数据从 scratch 分配, 为空时使用默认的 memory_resource
+        void Init(const MeshView& view, const VertexFormat& format = VertexFormat(), GLenum mode = GL_TRIANGLES, std::pmr::memory_resource* scratch = nullptr);
 
         void Terminate();
 
-        void Render();
+        // 不带 mode 的版本使用 Init 时指定的图元类型
+        void Render() const;
+        void Render(GLenum mode) const;
+        // 只发出绘制命令, 不绑定 VAO, 需要先调用 GeometryArena::Bind() 或绑定 GetVAO()
+        void Draw() const;
+        void Draw(GLenum mode) const;
+        // 一次绘制 instance_count 个实例, 着色器通过 gl_BaseInstance + gl_InstanceID 取每个实例的数据
+        void RenderInstanced(GLsizei instance_count, GLuint base_instance = 0) const;
+        void RenderInstanced(GLsizei instance_count, GLuint base_instance, GLenum mode) const;
+        void DrawInstanced(GLsizei instance_count, GLuint base_instance = 0) const;
+        void DrawInstanced(GLsizei instance_count, GLuint base_instance, GLenum mode) const;
 
         GLuint GetVAO() const;
-        GLuint GetIndexBufferObject();
-        GLuint GetPositionBufferObject();
-        GLuint GetNormalBufferObject();
-        GLuint GetUvBufferObject();
-        GLuint GetVertexCount();
+        GLuint GetIndexBufferObject() const;
+        // 独立缓冲按最大索引选择 GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT 或 GL_UNSIGNED_INT, 几何缓冲中总是 GL_UNSIGNED_INT
+        GLenum GetIndexType() const;
+        // 索引占用的显存字节数
+        size_t GetIndexBufferSize() const;
+        GLenum GetPrimitiveMode() const;
+        GLuint GetPositionBufferObject() const;
+        GLuint GetNormalBufferObject() const;
+        GLuint GetUvBufferObject() const;
+        GLuint GetVertexCount() const;
+
+        const VertexFormat& GetVertexFormat() const;
+        // 每个顶点占用的字节数
+        GLsizei GetVertexSize() const;
+        // 顶点数据占用的显存字节数, 不包含索引
+        size_t GetVertexBufferSize() const;
+        // 把量化后的位置还原到模型空间的变换, 需要乘在模型矩阵的右边; 位置没有量化时为单位矩阵
+        const glm::mat4& GetDequantizeTransform() const;
+
+        // 网格所在的几何缓冲, 独立缓冲时为 nullptr
+        GeometryArena* GetGeometryArena() const;
+        GLint GetBaseVertex() const;
+        GLuint GetFirstIndex() const;
+
+        // 计算格式对应的属性布局, 返回每个顶点的字节数
+        static GLsizei BuildVertexLayout
+        (
+            const VertexFormat& format,
+            bool has_uvs,
+            bool has_tangents,
+            size_t vertex_count,
+            VertexAttribute attributes[ATTRIBUTE_COUNT]
+        );
+
+        // 能表示所有索引的最小类型, 类型的最大值留给图元重启
+        static GLenum SelectIndexType(const GLuint* indices, size_t count);
+        static GLsizei GetIndexTypeSize(GLenum type);
+        // 把 32 位索引转换成 type 的宽度写入 destination, RESTART_INDEX 换成类型的最大值
+        static void ConvertIndices(const GLuint* indices, size_t count, GLenum type, void* destination);
+
+    private:
+        void EncodeVertices
+        (
+            const VertexFormat& format,
+            const VertexAttribute attributes[ATTRIBUTE_COUNT],
+            const MeshView& view,
+            std::pmr::vector<unsigned char>& vertex_data
+        );
 
     private:
         GLuint m_vao;
         GLuint m_vertex_count;
         std::vector<GLuint> m_buffers;
+        GLuint m_index_buffer;
+        GLenum m_index_type;
+        GLsizei m_index_size;
+        GLenum m_mode;
+        GLuint m_attribute_buffers[ATTRIBUTE_COUNT];
+        VertexFormat m_format;
+        GLsizei m_vertex_size;
+        size_t m_vertex_buffer_size;
+        glm::mat4 m_dequantize_transform;
+        GeometryArena* m_arena;
+        GLint m_base_vertex;
+        GLuint m_first_index;
     };
 }
 
@@ -0,0 +1,72 @@
+﻿#ifndef __GLSL_SHADER_COMMON_UNIFORM_BLOCK_H__
+#define __GLSL_SHADER_COMMON_UNIFORM_BLOCK_H__
+
+#include "common/glsl_program.h"
+
+#include "glm/glm.hpp"
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+namespace glsl_shader
+{
+    // 通过程序反射得到 uniform block 的布局(偏移, 数组步长, 矩阵步长),
+    // 在 CPU 端的暂存缓冲中按布局写入数据, 最后一次 glBufferSubData 上传整个修改范围
+    class UniformBlock
+    {
+    public:
+        UniformBlock();
+        UniformBlock(const UniformBlock&) = delete;
+        ~UniformBlock();
+
+        UniformBlock& operator = (const UniformBlock&) = delete;
+
+        void Init(GLSLProgram& program, const char* block_name, GLuint binding);
+        void Terminate();
+
+        void Set(const char* name, const glm::vec2& value);
+        void Set(const char* name, const glm::vec3& value);
+        void Set(const char* name, const glm::vec4& value);
+        void Set(const char* name, const glm::mat3& value);
+        void Set(const char* name, const glm::mat4& value);
+        void Set(const char* name, float value);
+        void Set(const char* name, bool value);
+        void Set(const char* name, int value);
+        void Set(const char* name, GLuint value);
+
+        void Upload();
+        void Bind();
+
+        GLuint GetBuffer() const;
+        GLuint GetBinding() const;
+        GLint GetSize() const;
+        bool HasMember(const char* name);
+
+    private:
+        struct Member
+        {
+            GLenum type;
+            GLint offset;
+            GLint array_size;
+            GLint array_stride;
+            GLint matrix_stride;
+            bool is_row_major;
+        };
+
+        GLint FindOffset(const char* name, const Member** member);
+        void Write(GLint offset, const void* data, size_t size);
+        template <int C, int R, typename M>
+        void WriteMatrix(const char* name, const M& value);
+
+    private:
+        GLuint m_buffer;
+        GLuint m_binding;
+        std::vector<unsigned char> m_data;
+        std::unordered_map<std::string, Member> m_members;
+        size_t m_dirty_begin;
+        size_t m_dirty_end;
+    };
+}
+
+#endif // !__GLSL_SHADER_COMMON_UNIFORM_BLOCK_H__
@@ -0,0 +1,199 @@
+﻿#include "glad/gl.h"
+#include "GLFW/glfw3.h"
+
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/type_ptr.hpp"
+
+#include "common/glsl_program.h"
+#include "common/glsl_pipeline.h"
+
+#include <iostream>
+
+GLFWwindow* window = nullptr;
+GLuint vbo[2] = { 0, 0 };
+GLuint vao = 0;
+glsl_shader::PipelineCache pipeline_cache;
+size_t vertex_stage = 0;
+size_t fragment_stages[2] = { 0, 0 };
+glsl_shader::GLSLPipeline* program_pipeline[2] = { nullptr, nullptr };
+
+void InitVertexData();
+void LoadShaderFromSourceCode();
+void InitProgramPipeline();
+
+int main()
+{
+    // 初始化 GLFW
+    if (!glfwInit())
+    {
+        std::cerr << "初始化 GLFW 失败" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    // 设置 GLFW
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
+
+    window = glfwCreateWindow(800, 600, "Chapter05PipelineCache", nullptr, nullptr);
+    if (!window)
+    {
+        std::cerr << "创建窗口失败" << std::endl;
+        glfwTerminate();
+        exit(EXIT_FAILURE);
+    }
+    glfwMakeContextCurrent(window);
+
+    // 初始化 GLAD
+    if (!gladLoadGL(static_cast<GLADloadfunc>(glfwGetProcAddress)))
+    {
+        std::cerr << "初始化 GLAD 失败" << std::endl;
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        exit(EXIT_FAILURE);
+    }
+
+    // 输出信息
+    const GLubyte* renderer = glGetString(GL_RENDERER);
+    const GLubyte* vendor = glGetString(GL_VENDOR);
+    const GLubyte* version = glGetString(GL_VERSION);
+    const GLubyte* glsl_version = glGetString(GL_SHADING_LANGUAGE_VERSION);
+    GLint major = 0;
+    GLint minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    std::cout << "Renderer: " << renderer << std::endl;
+    std::cout << "Vendor: " << vendor << std::endl;
+    std::cout << "OpenGL Version: " << version << std::endl;
+    std::cout << "Shading Language Version: " << glsl_version << std::endl;
+    std::cout << "OpenGL Version (parsed): " << major << "." << minor << std::endl;
+
+    // 输出支持的扩展信息
+    GLint extensions = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensions);
+    std::cout << "Supported Extensions:" << std::endl;
+    for (int i = 0; i < extensions; ++i)
+    {
+        std::cout << "    " << glGetStringi(GL_EXTENSIONS, i) << std::endl;
+    }
+
+    // 设置视口大小
+    glViewport(0, 0, 800, 600);
+
+    // 设置背景颜色
+    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+
+    // 启动混合
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    // 初始化几何数据
+    InitVertexData();
+
+    // 从着色器源代码加载和编译着色器
+    LoadShaderFromSourceCode();
+
+    // 初始化程序管线
+    InitProgramPipeline();
+
+    // 渲染循环
+    while (!glfwWindowShouldClose(window))
+    {
+        glUseProgram(0);
+
+        pipeline_cache.GetStage(vertex_stage).SetUniform("u_color_mask", glm::vec3(0.0f, 1.0f, 0.0f));
+
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        glBindVertexArray(vao);
+
+        glViewport(0, 0, 400, 600);
+        program_pipeline[0]->Bind();
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+
+        glViewport(400, 0, 400, 600);
+        program_pipeline[1]->Bind();
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+
+        glBindVertexArray(0);
+
+        glfwSwapBuffers(window);
+
+        glfwPollEvents();
+    }
+
+    // 清理和退出
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(2, vbo);
+    glfwDestroyWindow(window);
+    glfwTerminate();
+
+    return EXIT_SUCCESS;
+}
+
+void InitVertexData()
+{
+    float position_data[]
+    {
+        -0.8f, -0.8f, 0.0f,
+         0.8f, -0.8f, 0.0f,
+         0.0f,  0.8f, 0.0f,
+    };
+    float color_data[]
+    {
+        1.0f, 0.0f, 0.0f,
+        0.0f, 1.0f, 0.0f,
+        0.0f, 0.0f, 1.0f,
+    };
+
+    // 创建缓冲区
+    glGenBuffers(2, vbo);
+    GLuint position_vbo = vbo[0];
+    GLuint color_vbo = vbo[1];
+
+    // 绑定缓冲区并传输数据
+    glBindBuffer(GL_ARRAY_BUFFER, position_vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(position_data), position_data, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, color_vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(color_data), color_data, GL_STATIC_DRAW);
+
+    // 创建 VAO
+    glGenVertexArrays(1, &vao);
+
+    // 绑定 VAO 并设置格式
+    glBindVertexArray(vao);
+
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+
+    glBindVertexBuffer(0, position_vbo, 0, 3 * sizeof(float));
+    glVertexAttribFormat(0, 3, GL_FLOAT, GL_FALSE, 0);
+    glVertexAttribBinding(0, 0);
+
+    glBindVertexBuffer(1, color_vbo, 0, 3 * sizeof(float));
+    glVertexAttribFormat(1, 3, GL_FLOAT, GL_FALSE, 0);
+    glVertexAttribBinding(1, 1);
+
+    glBindVertexArray(0);
+}
+
+void LoadShaderFromSourceCode()
+{
+    // 每个阶段编译为一个可分离程序, 顶点阶段只编译一次, 由两个管线共用
+    vertex_stage = pipeline_cache.AddStage("../../assets/shaders/chapter05/separable.vs.glsl");
+    fragment_stages[0] = pipeline_cache.AddStage("../../assets/shaders/chapter05/separable1.fs.glsl");
+    fragment_stages[1] = pipeline_cache.AddStage("../../assets/shaders/chapter05/separable2.fs.glsl");
+}
+
+void InitProgramPipeline()
+{
+    // 按阶段组合创建程序管线, 组合不同的阶段不需要重新链接
+    for (int i = 0; i < 2; ++i)
+    {
+        program_pipeline[i] = &pipeline_cache.GetPipeline({ vertex_stage, fragment_stages[i] });
+        program_pipeline[i]->Validate();
+    }
+}
\ No newline at end of file
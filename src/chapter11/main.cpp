@@ -92,8 +92,10 @@ int main()
     // 从着色器源代码加载和编译着色器
     LoadShaderFromSourceCode();
 
-    // 创建 ObjMesh
-    obj_mesh = glsl_shader::ObjMesh::Load("../../assets/models/bs_ears.obj");
+    // 创建 ObjMesh, 加载时重排索引以提高顶点缓存命中率
+    glsl_shader::VertexFormat format;
+    format.optimize = true;
+    obj_mesh = glsl_shader::ObjMesh::Load("../../assets/models/bs_ears.obj", false, false, format);
 
     program.SetUniform("u_light.La", 0.4f, 0.4f, 0.4f);
     program.SetUniform("u_light.Ld", 1.0f, 1.0f, 1.0f);
@@ -5,6 +5,9 @@
 #include "glm/gtc/matrix_transform.hpp"
 
 #include "common/glsl_program.h"
+#include "common/uniform_block.h"
+#include "common/shader_file_watcher.h"
+#include "common/shader_pack.h"
 #include "common/obj_mesh.h"
 #include "common/plane.h"
 
@@ -12,7 +15,11 @@
 #include <memory>
 
 GLFWwindow* window = nullptr;
+glsl_shader::ShaderPack shader_pack;
 glsl_shader::GLSLProgram program;
+glsl_shader::UniformBlock light_block;
+glsl_shader::UniformBlock material_block;
+glsl_shader::ShaderFileWatcher shader_watcher;
 std::unique_ptr<glsl_shader::ObjMesh> obj_mesh;
 std::unique_ptr<glsl_shader::Plane> plane;
 
@@ -91,13 +98,25 @@ int main()
     // 从着色器源代码加载和编译着色器
     LoadShaderFromSourceCode();
 
-    // 创建 ObjMesh
-    obj_mesh = glsl_shader::ObjMesh::Load("../../assets/models/pig_triangulated.obj", true);
-    plane = std::make_unique<glsl_shader::Plane>(10.0f, 10.0f, 100, 100);
+    // 修改着色器文件后无需重启程序, 每帧检查并重新加载
+    shader_watcher.Watch(program);
+    shader_watcher.Start();
+
+    // 创建 ObjMesh, 加载时重排索引以提高顶点缓存命中率
+    glsl_shader::VertexFormat format;
+    format.optimize = true;
+    obj_mesh = glsl_shader::ObjMesh::Load("../../assets/models/pig_triangulated.obj", true, false, format);
+
+    // 100 x 100 的地面用三角形带绘制
+    glsl_shader::VertexFormat plane_format;
+    plane_format.strips = true;
+    plane = std::make_unique<glsl_shader::Plane>(10.0f, 10.0f, 100, 100, 1.0f, 1.0f, plane_format);
 
     // 渲染循环
     while (!glfwWindowShouldClose(window))
     {
+        shader_watcher.Poll();
+
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         glm::mat4 view = glm::lookAt(glm::vec3(0.5f, 0.75f, 0.75f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
@@ -109,10 +128,11 @@ int main()
         program.SetUniform("u_view_model_matrix", mv);
         program.SetUniform("u_normal_matrix", glm::mat3(glm::vec3(mv[0]), glm::vec3(mv[1]), glm::vec3(mv[2])));
         program.SetUniform("u_mvp_matrix", projection * mv);
-        program.SetUniform("u_material.Kd", 0.4f, 0.4f, 0.4f);
-        program.SetUniform("u_material.Ks", 0.9f, 0.9f, 0.9f);
-        program.SetUniform("u_material.Ka", 0.5f, 0.5f, 0.5f);
-        program.SetUniform("u_material.shininess", 180.0f);
+        material_block.Set("u_material.Kd", glm::vec3(0.4f, 0.4f, 0.4f));
+        material_block.Set("u_material.Ks", glm::vec3(0.9f, 0.9f, 0.9f));
+        material_block.Set("u_material.Ka", glm::vec3(0.5f, 0.5f, 0.5f));
+        material_block.Set("u_material.shininess", 180.0f);
+        material_block.Upload();
         obj_mesh->Render();
 
         model = glm::mat4(1.0f);
@@ -121,10 +141,11 @@ int main()
         program.SetUniform("u_view_model_matrix", mv);
         program.SetUniform("u_normal_matrix", glm::mat3(glm::vec3(mv[0]), glm::vec3(mv[1]), glm::vec3(mv[2])));
         program.SetUniform("u_mvp_matrix", projection * mv);
-        program.SetUniform("u_material.Kd", 0.1f, 0.1f, 0.1f);
-        program.SetUniform("u_material.Ks", 0.9f, 0.9f, 0.9f);
-        program.SetUniform("u_material.Ka", 0.1f, 0.1f, 0.1f);
-        program.SetUniform("u_material.shininess", 180.0f);
+        material_block.Set("u_material.Kd", glm::vec3(0.1f, 0.1f, 0.1f));
+        material_block.Set("u_material.Ks", glm::vec3(0.9f, 0.9f, 0.9f));
+        material_block.Set("u_material.Ka", glm::vec3(0.1f, 0.1f, 0.1f));
+        material_block.Set("u_material.shininess", 180.0f);
+        material_block.Upload();
         plane->Render();
 
         glfwSwapBuffers(window);
@@ -133,6 +154,9 @@ int main()
     }
 
     // 清理和退出
+    shader_watcher.Stop();
+    material_block.Terminate();
+    light_block.Terminate();
     plane.release();
     obj_mesh.release();
     glfwDestroyWindow(window);
@@ -143,6 +167,23 @@ int main()
 
 void LoadShaderFromSourceCode()
 {
+    // 所有着色器源代码从一个内存映射的着色器包中读取, 着色器包和程序二进制缓存一起放在可执行文件旁边
+    const std::filesystem::path shader_directory("../../assets/shaders");
+    const std::filesystem::path shader_pack_path = glsl_shader::GLSLProgram::GetBinaryCacheDirectory() / "shaders.pack";
+    bool is_pack_usable = shader_pack.Open(shader_pack_path, shader_directory);
+#ifndef NDEBUG
+    // 检查源目录需要遍历并读取每个文件的属性, 只在调试版本中做, 发布版本只在着色器包缺失或损坏时重新打包
+    is_pack_usable = is_pack_usable && !shader_pack.IsStale();
+#endif
+    if (!is_pack_usable)
+    {
+        // 映射中的文件在 Windows 上不能被替换, 重新打包前先关闭
+        shader_pack.Close();
+        glsl_shader::ShaderPack::Build(shader_directory, shader_pack_path);
+        shader_pack.Open(shader_pack_path, shader_directory);
+    }
+    shader_pack.Install();
+
     // 创建顶点着色器
     program.CompileShader("../../assets/shaders/chapter14/multiple_light_source.vs.glsl");
     program.CompileShader("../../assets/shaders/chapter14/multiple_light_source.fs.glsl");
@@ -152,6 +193,10 @@ void LoadShaderFromSourceCode()
     program.PrintActiveUniformBlocks();
     program.PrintActiveUniforms();
 
+    // 通过反射得到的 std140 布局填充光源和材质 uniform block
+    light_block.Init(program, "LightBlock", 0);
+    material_block.Init(program, "MaterialBlock", 1);
+
     glm::mat4 view = glm::lookAt(glm::vec3(0.5f, 0.75f, 0.75f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
     float x = 0.0f;
     float z = 0.0f;
@@ -161,18 +206,21 @@ void LoadShaderFromSourceCode()
         name << "u_lights[" << i << "].position_in_view";
         x = 2.0f * glm::cos((glm::two_pi<float>() / 5.0f) * i);
         z = 2.0f * glm::sin((glm::two_pi<float>() / 5.0f) * i);
-        program.SetUniform(name.str().c_str(), view * glm::vec4(x, 1.2f, z + 1.0f, 1.0f));
+        light_block.Set(name.str().c_str(), view * glm::vec4(x, 1.2f, z + 1.0f, 1.0f));
     }
 
-    program.SetUniform("u_lights[0].L", glm::vec3(0.0f, 0.8f, 0.8f));
-    program.SetUniform("u_lights[1].L", glm::vec3(0.0f, 0.0f, 0.8f));
-    program.SetUniform("u_lights[2].L", glm::vec3(0.8f, 0.0f, 0.0f));
-    program.SetUniform("u_lights[3].L", glm::vec3(0.0f, 0.8f, 0.0f));
-    program.SetUniform("u_lights[4].L", glm::vec3(0.8f, 0.8f, 0.8f));
-
-    program.SetUniform("u_lights[0].La", glm::vec3(0.0f, 0.2f, 0.2f));
-    program.SetUniform("u_lights[1].La", glm::vec3(0.0f, 0.0f, 0.2f));
-    program.SetUniform("u_lights[2].La", glm::vec3(0.2f, 0.0f, 0.0f));
-    program.SetUniform("u_lights[3].La", glm::vec3(0.0f, 0.2f, 0.0f));
-    program.SetUniform("u_lights[4].La", glm::vec3(0.2f, 0.2f, 0.2f));
+    light_block.Set("u_lights[0].L", glm::vec3(0.0f, 0.8f, 0.8f));
+    light_block.Set("u_lights[1].L", glm::vec3(0.0f, 0.0f, 0.8f));
+    light_block.Set("u_lights[2].L", glm::vec3(0.8f, 0.0f, 0.0f));
+    light_block.Set("u_lights[3].L", glm::vec3(0.0f, 0.8f, 0.0f));
+    light_block.Set("u_lights[4].L", glm::vec3(0.8f, 0.8f, 0.8f));
+
+    light_block.Set("u_lights[0].La", glm::vec3(0.0f, 0.2f, 0.2f));
+    light_block.Set("u_lights[1].La", glm::vec3(0.0f, 0.0f, 0.2f));
+    light_block.Set("u_lights[2].La", glm::vec3(0.2f, 0.0f, 0.0f));
+    light_block.Set("u_lights[3].La", glm::vec3(0.0f, 0.2f, 0.0f));
+    light_block.Set("u_lights[4].La", glm::vec3(0.2f, 0.2f, 0.2f));
+
+    // 所有光源数据只需一次上传
+    light_block.Upload();
 }
\ No newline at end of file
@@ -8,6 +8,7 @@
 #include "common/torus.h"
 #include "common/teapot.h"
 #include "common/plane.h"
+#include "common/geometry_arena.h"
 
 #include <iostream>
 #include <memory>
@@ -17,6 +18,7 @@ glsl_shader::GLSLProgram program;
 std::unique_ptr<glsl_shader::Torus> torus;
 std::unique_ptr<glsl_shader::Teapot> teapot;
 std::unique_ptr<glsl_shader::Plane> plane;
+glsl_shader::GeometryArena geometry_arena;
 float angle = 0.0f;
 float last_time = 0.0f;
 
@@ -95,9 +97,12 @@ int main()
     // 从着色器源代码加载和编译着色器
     LoadShaderFromSourceCode();
 
-    torus = std::make_unique<glsl_shader::Torus>(1.75f * 0.75f, 0.75f * 0.75f, 50, 50);
-    teapot = std::make_unique<glsl_shader::Teapot>(14, glm::mat4(1.0f));
-    plane = std::make_unique<glsl_shader::Plane>(50.0f, 50.0f, 1, 1);
+    // 所有网格放进同一个顶点缓冲和索引缓冲, 绘制时不再切换 VAO
+    geometry_arena.Init(16 * 1024, 64 * 1024);
+    const glsl_shader::VertexFormat& arena_format = geometry_arena.GetVertexFormat();
+    torus = std::make_unique<glsl_shader::Torus>(1.75f * 0.75f, 0.75f * 0.75f, 50, 50, arena_format);
+    teapot = std::make_unique<glsl_shader::Teapot>(14, glm::mat4(1.0f), arena_format);
+    plane = std::make_unique<glsl_shader::Plane>(50.0f, 50.0f, 1, 1, 1.0f, 1.0f, arena_format);
 
     last_time = static_cast<float>(glfwGetTime());
 
@@ -134,7 +139,8 @@ int main()
         program.SetUniform("u_view_model_matrix", mv);
         program.SetUniform("u_normal_matrix", glm::mat3(glm::vec3(mv[0]), glm::vec3(mv[1]), glm::vec3(mv[2])));
         program.SetUniform("u_mvp_matrix", projection * mv);
-        teapot->Render();
+        geometry_arena.Bind();
+        teapot->GetMesh().Draw();
 
         program.SetUniform("u_material.Kd", 0.9f, 0.5f, 0.3f);
         program.SetUniform("u_material.Ks", 0.95f, 0.95f, 0.95f);
@@ -147,7 +153,7 @@ int main()
         program.SetUniform("u_view_model_matrix", mv);
         program.SetUniform("u_normal_matrix", glm::mat3(glm::vec3(mv[0]), glm::vec3(mv[1]), glm::vec3(mv[2])));
         program.SetUniform("u_mvp_matrix", projection * mv);
-        torus->Render();
+        torus->GetMesh().Draw();
 
         program.SetUniform("u_material.Kd", 0.7f, 0.7f, 0.7f);
         program.SetUniform("u_material.Ks", 0.9f, 0.9f, 0.9f);
@@ -158,7 +164,8 @@ int main()
         program.SetUniform("u_view_model_matrix", mv);
         program.SetUniform("u_normal_matrix", glm::mat3(glm::vec3(mv[0]), glm::vec3(mv[1]), glm::vec3(mv[2])));
         program.SetUniform("u_mvp_matrix", projection * mv);
-        plane->Render();
+        plane->GetMesh().Draw();
+        geometry_arena.Unbind();
 
         glfwSwapBuffers(window);
 
@@ -169,6 +176,7 @@ int main()
     plane.release();
     teapot.release();
     torus.release();
+    geometry_arena.Terminate();
     glfwDestroyWindow(window);
     glfwTerminate();
 
@@ -7,6 +7,7 @@
 #include "common/glsl_program.h"
 #include "common/plane.h"
 #include "common/obj_mesh.h"
+#include "common/instance_buffer.h"
 
 #include <iostream>
 #include <memory>
@@ -15,6 +16,7 @@ GLFWwindow* window = nullptr;
 glsl_shader::GLSLProgram program;
 std::unique_ptr<glsl_shader::Plane> plane;
 std::unique_ptr<glsl_shader::ObjMesh> obj_mesh;
+glsl_shader::InstanceBuffer cow_instances;
 float angle = 0.0f;
 float last_time = 0.0f;
 glm::vec4 light_position = glm::vec4(5.0f, 5.0f, 5.0f, 1.0f);
@@ -24,7 +26,7 @@ glm::mat4 projection = glm::perspective(glm::radians(60.0f), 4.0f / 3.0f, 0.5f,
 void LoadShaderFromSourceCode();
 void InitGeometry();
 void TerminateGeometry();
-void DrawCow(const glm::vec3& position, float roughness, int is_metal, const glm::vec3& color);
+void AddCow(const glm::vec3& position, float roughness, int is_metal, const glm::vec3& color);
 
 int main()
 {
@@ -135,28 +137,13 @@ int main()
         program.SetUniform("u_material.color", glm::vec3(0.2f));
         plane->Render();
 
-        // 绘制 非金属 牛
-        int num_cows = 9;
-        glm::vec3 cow_base_color(0.1f, 0.33f, 0.17f);
-        for (int i = 0; i < num_cows; ++i)
-        {
-            float cow_x = i * (10.0f / (num_cows - 1)) - 5.0f;
-            float roughness = (i + 1) * (1.0f / num_cows);
-            DrawCow(glm::vec3(cow_x, 0.0f, 0.0f), roughness, 0, cow_base_color);
-        }
-
-        // 绘制 金属 牛
-        float metal_roughness = 0.43f;
-        // Gold
-        DrawCow(glm::vec3(-3.0f, 0.0f, 3.0f), metal_roughness, 1, glm::vec3(1, 0.71f, 0.29f));
-        // Copper
-        DrawCow(glm::vec3(-1.5f, 0.0f, 3.0f), metal_roughness, 1, glm::vec3(0.95f, 0.64f, 0.54f));
-        // Aluminum
-        DrawCow(glm::vec3(-0.0f, 0.0f, 3.0f), metal_roughness, 1, glm::vec3(0.91f, 0.92f, 0.92f));
-        // Titanium
-        DrawCow(glm::vec3(1.5f, 0.0f, 3.0f), metal_roughness, 1, glm::vec3(0.542f, 0.497f, 0.449f));
-        // Silver
-        DrawCow(glm::vec3(3.0f, 0.0f, 3.0f), metal_roughness, 1, glm::vec3(0.95f, 0.93f, 0.88f));
+        // 所有牛一次实例化绘制
+        program.SetUniform("u_instanced", true);
+        program.SetUniform("u_view_matrix", view);
+        program.SetUniform("u_projection_matrix", projection);
+        cow_instances.Bind();
+        obj_mesh->RenderInstanced(cow_instances.GetCount());
+        program.SetUniform("u_instanced", false);
 
         glfwSwapBuffers(window);
 
@@ -193,28 +180,51 @@ void LoadShaderFromSourceCode()
 void InitGeometry()
 {
     plane = std::make_unique<glsl_shader::Plane>(20.0f, 20.0f, 1, 1);
-    obj_mesh = glsl_shader::ObjMesh::Load("../../assets/models/spot_triangulated.obj");
+
+    glsl_shader::VertexFormat format;
+    format.optimize = true;
+    obj_mesh = glsl_shader::ObjMesh::Load("../../assets/models/spot_triangulated.obj", false, false, format);
+
+    cow_instances.Init();
+
+    // 非金属 牛
+    int num_cows = 9;
+    glm::vec3 cow_base_color(0.1f, 0.33f, 0.17f);
+    for (int i = 0; i < num_cows; ++i)
+    {
+        float cow_x = i * (10.0f / (num_cows - 1)) - 5.0f;
+        float roughness = (i + 1) * (1.0f / num_cows);
+        AddCow(glm::vec3(cow_x, 0.0f, 0.0f), roughness, 0, cow_base_color);
+    }
+
+    // 金属 牛
+    float metal_roughness = 0.43f;
+    // Gold
+    AddCow(glm::vec3(-3.0f, 0.0f, 3.0f), metal_roughness, 1, glm::vec3(1, 0.71f, 0.29f));
+    // Copper
+    AddCow(glm::vec3(-1.5f, 0.0f, 3.0f), metal_roughness, 1, glm::vec3(0.95f, 0.64f, 0.54f));
+    // Aluminum
+    AddCow(glm::vec3(-0.0f, 0.0f, 3.0f), metal_roughness, 1, glm::vec3(0.91f, 0.92f, 0.92f));
+    // Titanium
+    AddCow(glm::vec3(1.5f, 0.0f, 3.0f), metal_roughness, 1, glm::vec3(0.542f, 0.497f, 0.449f));
+    // Silver
+    AddCow(glm::vec3(3.0f, 0.0f, 3.0f), metal_roughness, 1, glm::vec3(0.95f, 0.93f, 0.88f));
+
+    cow_instances.Upload();
 }
 
 void TerminateGeometry()
 {
     plane.release();
     obj_mesh.release();
+    cow_instances.Terminate();
 }
 
-void DrawCow(const glm::vec3& position, float roughness, int is_metal, const glm::vec3& color)
+void AddCow(const glm::vec3& position, float roughness, int is_metal, const glm::vec3& color)
 {
     glm::mat4 model = glm::mat4(1.0f);
     model = glm::translate(model, position);
     model = glm::rotate(model, glm::radians(180.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-    glm::mat4 mv = view * model;
-    program.SetUniform("u_view_model_matrix", mv);
-    program.SetUniform("u_normal_matrix", glm::mat3(mv));
-    program.SetUniform("u_mvp_matrix", projection * mv);
-
-    program.SetUniform("u_material.roughness", roughness);
-    program.SetUniform("u_material.is_metal", is_metal);
-    program.SetUniform("u_material.color", color);
 
-    obj_mesh->Render();
+    cow_instances.Add(model, glm::vec4(color, 1.0f), glm::vec4(roughness, static_cast<float>(is_metal), 0.0f, 0.0f));
 }
\ No newline at end of file
@@ -163,7 +163,18 @@ void LoadShaderFromSourceCode()
 
 void InitGeometry()
 {
-    obj_mesh = glsl_shader::ObjMesh::Load("../../assets/models/bs_ears.obj", false, true);
+    // 交错单缓冲, 位置按包围盒量化为 half, 法线和切线打包为 GL_INT_2_10_10_10_REV, 纹理坐标使用 half
+    obj_mesh = glsl_shader::ObjMesh::Load("../../assets/models/bs_ears.obj", false, true, glsl_shader::VertexFormat::Compact(true));
+
+    // 顶点着色器用这个矩阵把量化后的位置还原到模型空间
+    const glsl_shader::TriangleMesh& mesh = obj_mesh->GetMesh();
+    program.SetUniform("u_dequantize_matrix", mesh.GetDequantizeTransform());
+
+    // 与默认的 GL_FLOAT 多缓冲布局比较, 位置 12 + 法线 12 + 纹理坐标 8 + 切线 16 字节
+    size_t vertex_count = mesh.GetVertexBufferSize() / mesh.GetVertexSize();
+    size_t float_vertex_size = 3 * sizeof(GLfloat) + 3 * sizeof(GLfloat) + 2 * sizeof(GLfloat) + 4 * sizeof(GLfloat);
+    std::cout << "顶点格式: " << float_vertex_size << " -> " << mesh.GetVertexSize() << " 字节/顶点, "
+              << (vertex_count * float_vertex_size) << " -> " << mesh.GetVertexBufferSize() << " 字节" << std::endl;
 }
 
 void TerminateGeometry()
@@ -174,7 +185,7 @@ void TerminateGeometry()
 void InitTextures()
 {
     color_texture = glsl_shader::Texture::LoadTexture("../../assets/textures/ogre_diffuse.png");
-    normal_texture = glsl_shader::Texture::LoadTexture("../../assets/textures/ogre_normalmap.png");
+    normal_texture = glsl_shader::Texture::LoadTexture("../../assets/textures/ogre_normalmap.png", glsl_shader::TextureFormat::Linear());
 
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, color_texture);
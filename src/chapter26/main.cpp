@@ -168,8 +168,8 @@ void TerminateGeometry()
 void InitTextures()
 {
     color_texture = glsl_shader::Texture::LoadTexture("../../assets/textures/mybrick-color.png");
-    normal_texture = glsl_shader::Texture::LoadTexture("../../assets/textures/mybrick-normal.png");
-    height_texture = glsl_shader::Texture::LoadTexture("../../assets/textures/mybrick-height.png");
+    normal_texture = glsl_shader::Texture::LoadTexture("../../assets/textures/mybrick-normal.png", glsl_shader::TextureFormat::Linear());
+    height_texture = glsl_shader::Texture::LoadTexture("../../assets/textures/mybrick-height.png", glsl_shader::TextureFormat::Linear());
 
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, color_texture);
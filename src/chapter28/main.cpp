@@ -4,7 +4,9 @@
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 
+#include "common/asset_loader.h"
 #include "common/glsl_program.h"
+#include "common/shader_compile_queue.h"
 #include "common/sky_box.h"
 #include "common/teapot.h"
 #include "common/texture.h"
@@ -20,7 +22,8 @@ std::unique_ptr<glsl_shader::Teapot> teapot;
 glm::vec3 camera_position = glm::vec3(0.0f);
 glm::mat4 view = glm::mat4(1.0f);
 glm::mat4 projection = glm::perspective(glm::radians(50.0f), 4.0f / 3.0f, 0.3f, 100.0f);
-GLuint cube_map_texture = 0;
+glsl_shader::AssetLoader asset_loader;
+std::shared_future<GLuint> cube_map_texture;
 float last_time = 0.0f;
 float angle = glm::radians(90.0f);
 
@@ -29,6 +32,7 @@ void InitGeometry();
 void TerminateGeometry();
 void InitTextures();
 void TerminateTextures();
+GLuint GetTexture(const std::shared_future<GLuint>& texture);
 void Update();
 
 int main()
@@ -104,7 +108,7 @@ int main()
     // 初始化几何体
     InitGeometry();
 
-    // 初始化纹理
+    // 初始化纹理, 立方体贴图的六个面在后台解码, 渲染循环中上传
     InitTextures();
 
     last_time = static_cast<float>(glfwGetTime());
@@ -116,6 +120,11 @@ int main()
 
         Update();
 
+        // 每帧最多用 2 ms 上传加载好的资源, 立方体贴图还没有上传时绑定 0
+        asset_loader.Update(2.0);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, GetTexture(cube_map_texture));
+
         mesh_program.Use();
         glm::mat4 model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(0.0f, -1.0f, 0.0f));
@@ -150,7 +159,17 @@ void LoadShaderFromSourceCode()
     // 创建顶点着色器
     mesh_program.CompileShader("../../assets/shaders/chapter28/cube_map_reflect.vs.glsl");
     mesh_program.CompileShader("../../assets/shaders/chapter28/cube_map_reflect.fs.glsl");
-    mesh_program.Link();
+    sky_box_program.CompileShader("../../assets/shaders/chapter28/sky_box.vs.glsl");
+    sky_box_program.CompileShader("../../assets/shaders/chapter28/sky_box.fs.glsl");
+
+    // 同时提交两个程序的编译和链接, 统一等待结果
+    glsl_shader::ShaderCompileQueue::SetMaxShaderCompilerThreads(static_cast<GLADloadfunc>(glfwGetProcAddress), 0xFFFFFFFF);
+    glsl_shader::ShaderCompileQueue compile_queue;
+    compile_queue.Add(mesh_program);
+    compile_queue.Add(sky_box_program);
+    compile_queue.Submit();
+    compile_queue.Join();
+
     mesh_program.Use();
     mesh_program.PrintActiveAttribs();
     mesh_program.PrintActiveUniformBlocks();
@@ -159,9 +178,6 @@ void LoadShaderFromSourceCode()
     mesh_program.SetUniform("u_material_color", glm::vec4(0.5f, 0.5f, 0.5f, 1.0f));
     mesh_program.SetUniform("u_reflect_factor", 0.85f);
 
-    sky_box_program.CompileShader("../../assets/shaders/chapter28/sky_box.vs.glsl");
-    sky_box_program.CompileShader("../../assets/shaders/chapter28/sky_box.fs.glsl");
-    sky_box_program.Link();
     sky_box_program.Use();
     sky_box_program.PrintActiveAttribs();
     sky_box_program.PrintActiveUniformBlocks();
@@ -182,15 +198,19 @@ void TerminateGeometry()
 
 void InitTextures()
 {
-    cube_map_texture = glsl_shader::Texture::LoadCubeMap("../../assets/textures/pisa");
-
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, cube_map_texture);
+    cube_map_texture = glsl_shader::Texture::LoadCubeMapAsync(asset_loader, "../../assets/textures/pisa");
 }
 
 void TerminateTextures()
 {
-    glDeleteTextures(1, &cube_map_texture);
+    // 还没有上传的纹理没有创建 GL 对象
+    GLuint texture = GetTexture(cube_map_texture);
+    glDeleteTextures(1, &texture);
+}
+
+GLuint GetTexture(const std::shared_future<GLuint>& texture)
+{
+    return glsl_shader::IsReady(texture) ? texture.get() : 0;
 }
 
 void Update()
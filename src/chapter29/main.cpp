@@ -4,6 +4,7 @@
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 
+#include "common/asset_loader.h"
 #include "common/glsl_program.h"
 #include "common/sky_box.h"
 #include "common/teapot.h"
@@ -20,7 +21,8 @@ std::unique_ptr<glsl_shader::Teapot> teapot;
 glm::vec3 camera_position = glm::vec3(0.0f);
 glm::mat4 view = glm::mat4(1.0f);
 glm::mat4 projection = glm::perspective(glm::radians(50.0f), 4.0f / 3.0f, 0.3f, 100.0f);
-GLuint cube_map_texture = 0;
+glsl_shader::AssetLoader asset_loader;
+std::shared_future<GLuint> cube_map_texture;
 float last_time = 0.0f;
 float angle = glm::radians(90.0f);
 
@@ -29,6 +31,7 @@ void InitGeometry();
 void TerminateGeometry();
 void InitTextures();
 void TerminateTextures();
+GLuint GetTexture(const std::shared_future<GLuint>& texture);
 void Update();
 
 int main()
@@ -104,7 +107,7 @@ int main()
     // 初始化几何体
     InitGeometry();
 
-    // 初始化纹理
+    // 初始化纹理, 立方体贴图的六个面在后台解码, 渲染循环中上传
     InitTextures();
 
     last_time = static_cast<float>(glfwGetTime());
@@ -116,6 +119,11 @@ int main()
 
         Update();
 
+        // 每帧最多用 2 ms 上传加载好的资源, 立方体贴图还没有上传时绑定 0
+        asset_loader.Update(2.0);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, GetTexture(cube_map_texture));
+
         mesh_program.Use();
         glm::mat4 model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(0.0f, -1.0f, 0.0f));
@@ -182,15 +190,19 @@ void TerminateGeometry()
 
 void InitTextures()
 {
-    cube_map_texture = glsl_shader::Texture::LoadHdrCubeMap("../../assets/textures/pisa");
-
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, cube_map_texture);
+    cube_map_texture = glsl_shader::Texture::LoadHdrCubeMapAsync(asset_loader, "../../assets/textures/pisa");
 }
 
 void TerminateTextures()
 {
-    glDeleteTextures(1, &cube_map_texture);
+    // 还没有上传的纹理没有创建 GL 对象
+    GLuint texture = GetTexture(cube_map_texture);
+    glDeleteTextures(1, &texture);
+}
+
+GLuint GetTexture(const std::shared_future<GLuint>& texture)
+{
+    return glsl_shader::IsReady(texture) ? texture.get() : 0;
 }
 
 void Update()
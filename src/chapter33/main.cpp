@@ -4,6 +4,7 @@
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 
+#include "common/asset_loader.h"
 #include "common/glsl_program.h"
 #include "common/obj_mesh.h"
 #include "common/sky_box.h"
@@ -16,14 +17,15 @@ GLFWwindow* window = nullptr;
 glsl_shader::GLSLProgram sky_box_program;
 glsl_shader::GLSLProgram obj_mesh_program;
 std::unique_ptr<glsl_shader::SkyBox> sky_box;
-std::unique_ptr<glsl_shader::ObjMesh> obj_mesh;
+glsl_shader::AssetLoader asset_loader;
+std::shared_future<std::shared_ptr<glsl_shader::ObjMesh>> obj_mesh;
 glm::vec3 camera_position = glm::vec3(0.0f);
 glm::mat4 model = glm::mat4(1.0f);
 glm::mat4 view = glm::mat4(1.0f);
 glm::mat4 projection = glm::perspective(glm::radians(50.0f), 4.0f / 3.0f, 0.3f, 100.0f);
-GLuint diffuse_ibl = 0;
-GLuint sky_box_texture = 0;
-GLuint mesh_texture = 0;
+std::shared_future<GLuint> diffuse_ibl;
+std::shared_future<GLuint> sky_box_texture;
+std::shared_future<GLuint> mesh_texture;
 float angle = glm::half_pi<float>();
 float last_time = 0.0f;
 
@@ -32,6 +34,7 @@ void InitGeometry();
 void TerminateGeometry();
 void InitTextures();
 void TerminateTextures();
+GLuint GetTexture(const std::shared_future<GLuint>& texture);
 void Update();
 
 int main()
@@ -104,7 +107,7 @@ int main()
     // 从着色器源代码加载和编译着色器
     LoadShaderFromSourceCode();
 
-    // 初始化几何体
+    // 初始化几何体, 模型和纹理在后台加载, 渲染循环中逐步上传
     InitGeometry();
 
     // 初始化纹理
@@ -115,23 +118,29 @@ int main()
     {
         Update();
 
+        // 每帧最多用 2 ms 上传加载好的资源, 纹理还没有上传时绑定 0
+        asset_loader.Update(2.0);
+
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, diffuse_ibl);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, mesh_texture);
-        obj_mesh_program.Use();
-        obj_mesh_program.SetUniform("u_camera_position", camera_position);
-        model = glm::rotate(glm::mat4(1.0f), glm::radians(180.0f), glm::vec3(0, 1, 0));
-        obj_mesh_program.SetUniform("u_model_matrix", model);
-        obj_mesh_program.SetUniform("u_normal_matrix", glm::transpose(glm::inverse(glm::mat3(model))));
-        obj_mesh_program.SetUniform("u_mvp_matrix", projection * view * model);
-        obj_mesh->Render();
+        if (glsl_shader::IsReady(obj_mesh))
+        {
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_CUBE_MAP, GetTexture(diffuse_ibl));
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D, GetTexture(mesh_texture));
+            obj_mesh_program.Use();
+            obj_mesh_program.SetUniform("u_camera_position", camera_position);
+            model = glm::rotate(glm::mat4(1.0f), glm::radians(180.0f), glm::vec3(0, 1, 0));
+            obj_mesh_program.SetUniform("u_model_matrix", model);
+            obj_mesh_program.SetUniform("u_normal_matrix", glm::transpose(glm::inverse(glm::mat3(model))));
+            obj_mesh_program.SetUniform("u_mvp_matrix", projection * view * model);
+            obj_mesh.get()->Render();
+        }
 
         model = glm::mat4(1.0f);
         glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, sky_box_texture);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, GetTexture(sky_box_texture));
         sky_box_program.Use();
         sky_box_program.SetUniform("u_mvp_matrix", projection * view * model);
         sky_box->Render();
@@ -171,28 +180,33 @@ void LoadShaderFromSourceCode()
 
 void InitGeometry()
 {
-    obj_mesh = glsl_shader::ObjMesh::Load("../../assets/models/spot_triangulated.obj");
+    obj_mesh = glsl_shader::ObjMesh::LoadAsync(asset_loader, "../../assets/models/spot_triangulated.obj");
     sky_box = std::make_unique<glsl_shader::SkyBox>();
 }
 
 void TerminateGeometry()
 {
-    obj_mesh.release();
+    obj_mesh = std::shared_future<std::shared_ptr<glsl_shader::ObjMesh>>();
     sky_box.release();
 }
 
 void InitTextures()
 {
-    diffuse_ibl = glsl_shader::Texture::LoadHdrCubeMap("../../assets/textures/grace-diffuse");
-    sky_box_texture = glsl_shader::Texture::LoadHdrCubeMap("../../assets/textures/grace");
-    mesh_texture = glsl_shader::Texture::LoadTexture("../../assets/textures/spot_texture.png");
+    diffuse_ibl = glsl_shader::Texture::LoadHdrCubeMapAsync(asset_loader, "../../assets/textures/grace-diffuse");
+    sky_box_texture = glsl_shader::Texture::LoadHdrCubeMapAsync(asset_loader, "../../assets/textures/grace");
+    mesh_texture = glsl_shader::Texture::LoadTextureAsync(asset_loader, "../../assets/textures/spot_texture.png");
 }
 
 void TerminateTextures()
 {
-    glDeleteTextures(1, &diffuse_ibl);
-    glDeleteTextures(1, &sky_box_texture);
-    glDeleteTextures(1, &mesh_texture);
+    // 还没有上传的纹理没有创建 GL 对象
+    GLuint textures[] = { GetTexture(diffuse_ibl), GetTexture(sky_box_texture), GetTexture(mesh_texture) };
+    glDeleteTextures(3, textures);
+}
+
+GLuint GetTexture(const std::shared_future<GLuint>& texture)
+{
+    return glsl_shader::IsReady(texture) ? texture.get() : 0;
 }
 
 void Update()
@@ -5,6 +5,8 @@
 #include "glm/gtc/matrix_transform.hpp"
 
 #include "common/glsl_program.h"
+#include "common/shader_variant_set.h"
+#include "common/program_cache.h"
 #include "common/plane.h"
 #include "common/torus.h"
 #include "common/teapot.h"
@@ -13,8 +15,30 @@
 #include <memory>
 #include <sstream>
 
+// 三种选择 pass 的方式: uniform 分支, 子程序, 编译期宏定义特化
+enum class PassMode : int
+{
+    Uniform     = 0,
+    Subroutine  = 1,
+    Variant     = 2,
+};
+
 GLFWwindow* window = nullptr;
-glsl_shader::GLSLProgram program;
+glsl_shader::ProgramCache program_cache;
+std::shared_ptr<glsl_shader::GLSLProgram> program;
+std::shared_ptr<glsl_shader::GLSLProgram> subroutine_program;
+glsl_shader::ShaderVariantSet pass_variants;
+size_t pass_variant_handles[3] = { 0, 0, 0 };
+GLuint pass_subroutine_indices[3] = { 0, 0, 0 };
+PassMode pass_mode = PassMode::Uniform;
+const char* pass_mode_names[3] = { "u_pass uniform", "subroutine", "#define variant" };
+const int BENCHMARK_FRAMES = 300;
+const int BENCHMARK_QUERY_COUNT = 3;
+int benchmark_frame = 0;
+int benchmark_results = 0;
+GLuint benchmark_queries[BENCHMARK_QUERY_COUNT] = { 0, 0, 0 };
+PassMode benchmark_query_modes[BENCHMARK_QUERY_COUNT] = { PassMode::Uniform, PassMode::Uniform, PassMode::Uniform };
+double benchmark_gpu_ms[3] = { 0.0, 0.0, 0.0 };
 std::unique_ptr<glsl_shader::Plane> plane;
 std::unique_ptr<glsl_shader::Torus> torus;
 std::unique_ptr<glsl_shader::Teapot> teapot;
@@ -46,6 +70,10 @@ void Update();
 void Pass1();
 void Pass2();
 void Pass3();
+glsl_shader::GLSLProgram& UsePassProgram(int pass);
+void BeginBenchmarkFrame();
+void EndBenchmarkFrame();
+void CollectBenchmarkResults(int wait_count);
 float CalculateGaussian(float x, float sigma2);
 
 int main()
@@ -136,18 +164,30 @@ int main()
         std::stringstream uniform_name;
         uniform_name << "u_weights[" << i << "]";
         float val = weights[i] / sum;
-        program.SetUniform(uniform_name.str().c_str(), val);
+        program->Use();
+        program->SetUniform(uniform_name.str().c_str(), val);
+        subroutine_program->Use();
+        subroutine_program->SetUniform(uniform_name.str().c_str(), val);
+        for (size_t handle : pass_variant_handles)
+        {
+            pass_variants.GetVariant(handle).Use();
+            pass_variants.GetVariant(handle).SetUniform(uniform_name.str().c_str(), val);
+        }
     }
 
+    glGenQueries(BENCHMARK_QUERY_COUNT, benchmark_queries);
+
     // 渲染循环
     while (!glfwWindowShouldClose(window))
     {
         Update();
+        BeginBenchmarkFrame();
         Pass1();
         glFlush();
         Pass2();
         glFlush();
         Pass3();
+        EndBenchmarkFrame();
 
         glfwSwapBuffers(window);
 
@@ -155,6 +195,7 @@ int main()
     }
 
     // 清理和退出
+    glDeleteQueries(BENCHMARK_QUERY_COUNT, benchmark_queries);
     TerminateFrameBuffer();
     TerminateGeometry();
     glfwDestroyWindow(window);
@@ -165,17 +206,46 @@ int main()
 
 void LoadShaderFromSourceCode()
 {
-    // 创建顶点着色器
-    program.CompileShader("../../assets/shaders/chapter35/gaussian_blur.vs.glsl");
-    program.CompileShader("../../assets/shaders/chapter35/gaussian_blur.fs.glsl");
-    program.Link();
-    program.Use();
-    program.PrintActiveAttribs();
-    program.PrintActiveUniformBlocks();
-    program.PrintActiveUniforms();
-
-    program.SetUniform("u_light.L", glm::vec3(1.0f));
-    program.SetUniform("u_light.La", glm::vec3(0.2f));
+    // 所有程序都通过 program_cache 构建, 共用的顶点着色器只编译一次
+    std::vector<std::filesystem::path> shader_file_paths
+    {
+        "../../assets/shaders/chapter35/gaussian_blur.vs.glsl",
+        "../../assets/shaders/chapter35/gaussian_blur.fs.glsl",
+    };
+    program = program_cache.GetProgram(shader_file_paths);
+    program->Use();
+    program->PrintActiveAttribs();
+    program->PrintActiveUniformBlocks();
+    program->PrintActiveUniforms();
+
+    program->SetUniform("u_light.L", glm::vec3(1.0f));
+    program->SetUniform("u_light.La", glm::vec3(0.2f));
+
+    // 同一份源代码, 通过 USE_SUBROUTINE 宏编译出子程序版本
+    subroutine_program = program_cache.GetProgram(shader_file_paths, { { "USE_SUBROUTINE", "1" } });
+    subroutine_program->Use();
+    subroutine_program->SetUniform("u_light.L", glm::vec3(1.0f));
+    subroutine_program->SetUniform("u_light.La", glm::vec3(0.2f));
+    pass_subroutine_indices[0] = subroutine_program->GetSubroutineIndex(glsl_shader::ShaderType::Fragment, "Pass1");
+    pass_subroutine_indices[1] = subroutine_program->GetSubroutineIndex(glsl_shader::ShaderType::Fragment, "Pass2");
+    pass_subroutine_indices[2] = subroutine_program->GetSubroutineIndex(glsl_shader::ShaderType::Fragment, "Pass3");
+
+    // 每个 pass 一个特化变体, PASS 在编译期确定
+    pass_variants.SetProgramCache(&program_cache);
+    pass_variants.AddShader(shader_file_paths[0]);
+    pass_variants.AddShader(shader_file_paths[1]);
+    for (int pass = 1; pass <= 3; ++pass)
+    {
+        pass_variant_handles[pass - 1] = pass_variants.GetVariantHandle({ { "PASS", std::to_string(pass) } });
+        glsl_shader::GLSLProgram& variant = pass_variants.GetVariant(pass_variant_handles[pass - 1]);
+        variant.Use();
+        variant.SetUniform("u_light.L", glm::vec3(1.0f));
+        variant.SetUniform("u_light.La", glm::vec3(0.2f));
+    }
+
+    glsl_shader::ProgramCacheStats stats = program_cache.GetStats();
+    std::cout << "Program cache: " << program_cache.GetProgramCount() << " programs, " << program_cache.GetShaderCount() << " shader objects, "
+              << "shader hits: " << stats.shader_hits << ", shader misses: " << stats.shader_misses << std::endl;
 }
 
 void InitGeometry()
@@ -326,7 +396,7 @@ void Update()
 
 void Pass1()
 {
-    program.SetUniform("u_pass", 1);
+    glsl_shader::GLSLProgram& program = UsePassProgram(1);
 
     glBindFramebuffer(GL_FRAMEBUFFER, frame_buffer_obj);
     glEnable(GL_DEPTH_TEST);
@@ -378,7 +448,7 @@ void Pass1()
 
 void Pass2()
 {
-    program.SetUniform("u_pass", 2);
+    glsl_shader::GLSLProgram& program = UsePassProgram(2);
 
     glBindFramebuffer(GL_FRAMEBUFFER, intermediate_frame_buffer_obj);
     glActiveTexture(GL_TEXTURE0);
@@ -402,7 +472,7 @@ void Pass2()
 
 void Pass3()
 {
-    program.SetUniform("u_pass", 3);
+    glsl_shader::GLSLProgram& program = UsePassProgram(3);
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
@@ -423,6 +493,89 @@ void Pass3()
     glDrawArrays(GL_TRIANGLES, 0, 6);
 }
 
+glsl_shader::GLSLProgram& UsePassProgram(int pass)
+{
+    switch (pass_mode)
+    {
+      case PassMode::Subroutine:
+        // 子程序的选择在每次 glUseProgram 之后都会重置, 需要重新设置
+        subroutine_program->Use();
+        subroutine_program->SetSubroutineIndex(glsl_shader::ShaderType::Fragment, 1, &pass_subroutine_indices[pass - 1]);
+        return *subroutine_program;
+      case PassMode::Variant:
+      {
+        glsl_shader::GLSLProgram& variant = pass_variants.GetVariant(pass_variant_handles[pass - 1]);
+        variant.Use();
+        return variant;
+      }
+      default:
+        program->Use();
+        program->SetUniform("u_pass", pass);
+        return *program;
+    }
+}
+
+void BeginBenchmarkFrame()
+{
+    // 只读取已经完成的查询, 查询对象全部在使用中时才等待最早的一个
+    CollectBenchmarkResults(benchmark_frame - BENCHMARK_QUERY_COUNT + 1);
+
+    if (benchmark_frame >= 3 * BENCHMARK_FRAMES)
+    {
+        return;
+    }
+
+    // 前 3 * BENCHMARK_FRAMES 帧依次用三种方式渲染, 统计 GPU 时间
+    pass_mode = static_cast<PassMode>(benchmark_frame / BENCHMARK_FRAMES);
+    int slot = benchmark_frame % BENCHMARK_QUERY_COUNT;
+    benchmark_query_modes[slot] = pass_mode;
+    glBeginQuery(GL_TIME_ELAPSED, benchmark_queries[slot]);
+}
+
+void EndBenchmarkFrame()
+{
+    if (benchmark_frame >= 3 * BENCHMARK_FRAMES)
+    {
+        return;
+    }
+
+    glEndQuery(GL_TIME_ELAPSED);
+    ++benchmark_frame;
+}
+
+void CollectBenchmarkResults(int wait_count)
+{
+    // 按提交顺序读取查询结果, 前 wait_count 帧的结果需要等待, 之后的只在可用时读取
+    while (benchmark_results < benchmark_frame)
+    {
+        int slot = benchmark_results % BENCHMARK_QUERY_COUNT;
+        if (benchmark_results >= wait_count)
+        {
+            GLuint available = GL_FALSE;
+            glGetQueryObjectuiv(benchmark_queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available == GL_FALSE)
+            {
+                break;
+            }
+        }
+
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(benchmark_queries[slot], GL_QUERY_RESULT, &elapsed);
+        benchmark_gpu_ms[static_cast<int>(benchmark_query_modes[slot])] += elapsed / 1.0e6;
+        ++benchmark_results;
+
+        if (benchmark_results == 3 * BENCHMARK_FRAMES)
+        {
+            std::cout << "平均每帧 GPU 时间 (" << BENCHMARK_FRAMES << " 帧):" << std::endl;
+            for (int i = 0; i < 3; ++i)
+            {
+                std::cout << "    " << pass_mode_names[i] << ": " << benchmark_gpu_ms[i] / BENCHMARK_FRAMES << " ms" << std::endl;
+            }
+            pass_mode = PassMode::Variant;
+        }
+    }
+}
+
 float CalculateGaussian(float x, float sigma2)
 {
     float coeff = 1.0f / (glm::two_pi<float>() * sigma2);
@@ -7,6 +7,7 @@
 #include "common/glsl_program.h"
 #include "common/cube.h"
 #include "common/sphere.h"
+#include "common/instance_buffer.h"
 
 #include <iostream>
 #include <memory>
@@ -20,8 +21,15 @@ struct ListNode
 
 GLFWwindow* window = nullptr;
 glsl_shader::GLSLProgram program;
+glsl_shader::UniformHandle<glm::mat3> u_normal_matrix;
+glsl_shader::UniformHandle<glm::mat4> u_view_model_matrix;
+glsl_shader::UniformHandle<glm::mat4> u_mvp_matrix;
+glsl_shader::UniformHandle<glm::mat4> u_view_matrix;
+glsl_shader::UniformHandle<glm::mat4> u_projection_matrix;
+glsl_shader::UniformHandle<bool> u_instanced;
 std::unique_ptr<glsl_shader::Cube> cube;
 std::unique_ptr<glsl_shader::Sphere> sphere;
+glsl_shader::InstanceBuffer cube_instances;
 glm::mat4 model = glm::mat4(1.0f);
 glm::mat4 view = glm::mat4(1.0f);
 glm::mat4 projection = glm::perspective(glm::radians(50.0f), 4.0f / 3.0f, 0.3f, 100.0f);
@@ -41,6 +49,7 @@ void CreateGBufferTexture(GLenum texture_unit, GLenum format, GLuint& texture);
 void InitShaderStorage();
 void TerminateShaderStorage();
 void InitGeometry();
+void InitInstances();
 void TerminateGeometry();
 void Pass1();
 void Pass2();
@@ -160,6 +169,15 @@ void LoadShaderFromSourceCode()
     program.CompileShader("../../assets/shaders/chapter42/oit.fs.glsl");
     program.Link();
     program.Use();
+
+    // 链接后一次性解析每帧都要上传的 uniform 位置
+    u_normal_matrix = program.GetUniformHandle<glm::mat3>("u_normal_matrix");
+    u_view_model_matrix = program.GetUniformHandle<glm::mat4>("u_view_model_matrix");
+    u_mvp_matrix = program.GetUniformHandle<glm::mat4>("u_mvp_matrix");
+    u_view_matrix = program.GetUniformHandle<glm::mat4>("u_view_matrix");
+    u_projection_matrix = program.GetUniformHandle<glm::mat4>("u_projection_matrix");
+    u_instanced = program.GetUniformHandle<bool>("u_instanced");
+
     program.PrintActiveAttribs();
     program.PrintActiveUniformBlocks();
     program.PrintActiveUniforms();
@@ -234,10 +252,60 @@ void InitGeometry()
     glEnableVertexAttribArray(0);
 
     glBindVertexArray(0);
+
+    InitInstances();
+}
+
+void InitInstances()
+{
+    // 场景是静态的, 所有立方体的变换和颜色只上传一次
+    cube_instances.Init();
+
+    glm::vec4 small_cube_Kd = glm::vec4(0.2f, 0.2f, 0.9f, 0.55f);
+    float size = 0.45f;
+    for (int i = 0; i <= 6; ++i)
+    {
+        for (int j = 0; j <= 6; ++j)
+        {
+            for (int k = 0; k <= 6; ++k)
+            {
+                if ((i + j + k) % 2 == 0)
+                {
+                    model = glm::translate(glm::mat4(1.0f), glm::vec3(i - 3.0f, j - 3.0f, k - 3.0f));
+                    model = glm::scale(model, glm::vec3(size));
+                    cube_instances.Add(model, small_cube_Kd);
+                }
+            }
+        }
+    }
+
+    glm::vec4 large_cube_Kd = glm::vec4(0.9f, 0.2f, 0.2f, 0.4f);
+    size = 2.0f;
+    float position = 1.75f;
+    glm::vec3 corners[] =
+    {
+        glm::vec3(-position, -position, position),
+        glm::vec3(-position, -position, -position),
+        glm::vec3(-position, position, position),
+        glm::vec3(-position, position, -position),
+        glm::vec3(position, position, position),
+        glm::vec3(position, position, -position),
+        glm::vec3(position, -position, position),
+        glm::vec3(position, -position, -position),
+    };
+    for (const glm::vec3& corner : corners)
+    {
+        model = glm::translate(glm::mat4(1.0f), corner);
+        model = glm::scale(model, glm::vec3(size));
+        cube_instances.Add(model, large_cube_Kd);
+    }
+
+    cube_instances.Upload();
 }
 
 void TerminateGeometry()
 {
+    cube_instances.Terminate();
     cube.release();
     sphere.release();
     glDeleteBuffers(1, &quad_vertices);
@@ -272,9 +340,9 @@ void Pass2()
     projection = glm::mat4(1.0f);
     model = glm::mat4(1.0f);
     glm::mat4 mv = view * model;
-    program.SetUniform("u_normal_matrix", glm::mat3(glm::vec3(mv[0]), glm::vec3(mv[1]), glm::vec3(mv[2])));
-    program.SetUniform("u_view_model_matrix", mv);
-    program.SetUniform("u_mvp_matrix", projection * mv);
+    program.SetUniform(u_normal_matrix, glm::mat3(glm::vec3(mv[0]), glm::vec3(mv[1]), glm::vec3(mv[2])));
+    program.SetUniform(u_view_model_matrix, mv);
+    program.SetUniform(u_mvp_matrix, projection * mv);
 
     glBindVertexArray(quad_vao);
     glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
@@ -296,95 +364,14 @@ void DrawScene()
 {
     program.SetUniform("u_light_position", glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
     program.SetUniform("u_light_intensity", glm::vec3(0.9f));
-    program.SetUniform("u_Kd", glm::vec4(0.2f, 0.2f, 0.9f, 0.55f));
-
-    float size = 0.45f;
-    for (int i = 0; i <= 6; ++i)
-    {
-        for (int j = 0; j <= 6; ++j)
-        {
-            for (int k = 0; k <= 6; ++k)
-            {
-                if ((i + j + k) % 2 == 0)
-                {
-                    model = glm::translate(glm::mat4(1.0f), glm::vec3(i - 3.0f, j - 3.0f, k - 3.0f));
-                    model = glm::scale(model, glm::vec3(size));
-                    glm::mat4 mv = view * model;
-                    program.SetUniform("u_normal_matrix", glm::mat3(glm::vec3(mv[0]), glm::vec3(mv[1]), glm::vec3(mv[2])));
-                    program.SetUniform("u_view_model_matrix", mv);
-                    program.SetUniform("u_mvp_matrix", projection * mv);
-                    cube->Render();
-                }
-            }
-        }
-    }
 
-    program.SetUniform("u_Kd", glm::vec4(0.9f, 0.2f, 0.2f, 0.4f));
-    size = 2.0f;
-    float position = 1.75f;
-    model = glm::translate(glm::mat4(1.0f), glm::vec3(-position, -position, position));
-    model = glm::scale(model, glm::vec3(size));
-    glm::mat4 mv = view * model;
-    program.SetUniform("u_normal_matrix", glm::mat3(glm::vec3(mv[0]), glm::vec3(mv[1]), glm::vec3(mv[2])));
-    program.SetUniform("u_view_model_matrix", mv);
-    program.SetUniform("u_mvp_matrix", projection * mv);
-    cube->Render();
-
-    model = glm::translate(glm::mat4(1.0f), glm::vec3(-position, -position, -position));
-    model = glm::scale(model, glm::vec3(size));
-    mv = view * model;
-    program.SetUniform("u_normal_matrix", glm::mat3(glm::vec3(mv[0]), glm::vec3(mv[1]), glm::vec3(mv[2])));
-    program.SetUniform("u_view_model_matrix", mv);
-    program.SetUniform("u_mvp_matrix", projection * mv);
-    cube->Render();
-
-    model = glm::translate(glm::mat4(1.0f), glm::vec3(-position, position, position));
-    model = glm::scale(model, glm::vec3(size));
-    mv = view * model;
-    program.SetUniform("u_normal_matrix", glm::mat3(glm::vec3(mv[0]), glm::vec3(mv[1]), glm::vec3(mv[2])));
-    program.SetUniform("u_view_model_matrix", mv);
-    program.SetUniform("u_mvp_matrix", projection * mv);
-    cube->Render();
-
-    model = glm::translate(glm::mat4(1.0f), glm::vec3(-position, position, -position));
-    model = glm::scale(model, glm::vec3(size));
-    mv = view * model;
-    program.SetUniform("u_normal_matrix", glm::mat3(glm::vec3(mv[0]), glm::vec3(mv[1]), glm::vec3(mv[2])));
-    program.SetUniform("u_view_model_matrix", mv);
-    program.SetUniform("u_mvp_matrix", projection * mv);
-    cube->Render();
-
-    model = glm::translate(glm::mat4(1.0f), glm::vec3(position, position, position));
-    model = glm::scale(model, glm::vec3(size));
-    mv = view * model;
-    program.SetUniform("u_normal_matrix", glm::mat3(glm::vec3(mv[0]), glm::vec3(mv[1]), glm::vec3(mv[2])));
-    program.SetUniform("u_view_model_matrix", mv);
-    program.SetUniform("u_mvp_matrix", projection * mv);
-    cube->Render();
-
-    model = glm::translate(glm::mat4(1.0f), glm::vec3(position, position, -position));
-    model = glm::scale(model, glm::vec3(size));
-    mv = view * model;
-    program.SetUniform("u_normal_matrix", glm::mat3(glm::vec3(mv[0]), glm::vec3(mv[1]), glm::vec3(mv[2])));
-    program.SetUniform("u_view_model_matrix", mv);
-    program.SetUniform("u_mvp_matrix", projection * mv);
-    cube->Render();
-
-    model = glm::translate(glm::mat4(1.0f), glm::vec3(position, -position, position));
-    model = glm::scale(model, glm::vec3(size));
-    mv = view * model;
-    program.SetUniform("u_normal_matrix", glm::mat3(glm::vec3(mv[0]), glm::vec3(mv[1]), glm::vec3(mv[2])));
-    program.SetUniform("u_view_model_matrix", mv);
-    program.SetUniform("u_mvp_matrix", projection * mv);
-    cube->Render();
-
-    model = glm::translate(glm::mat4(1.0f), glm::vec3(position, -position, -position));
-    model = glm::scale(model, glm::vec3(size));
-    mv = view * model;
-    program.SetUniform("u_normal_matrix", glm::mat3(glm::vec3(mv[0]), glm::vec3(mv[1]), glm::vec3(mv[2])));
-    program.SetUniform("u_view_model_matrix", mv);
-    program.SetUniform("u_mvp_matrix", projection * mv);
-    cube->Render();
+    // 所有立方体一次实例化绘制, 每个实例的变换和颜色来自实例缓冲
+    program.SetUniform(u_instanced, true);
+    program.SetUniform(u_view_matrix, view);
+    program.SetUniform(u_projection_matrix, projection);
+    cube_instances.Bind();
+    cube->GetMesh().RenderInstanced(cube_instances.GetCount());
+    program.SetUniform(u_instanced, false);
 }
 
 void DrawQuad()
@@ -393,9 +380,9 @@ void DrawQuad()
     model = glm::mat4(1.0);
     projection = glm::mat4(1.0);
     glm::mat4 mv = view * model;
-    program.SetUniform("u_view_model_matrix", mv);
-    program.SetUniform("u_normal_matrix", glm::mat3(glm::vec3(mv[0]), glm::vec3(mv[1]), glm::vec3(mv[2])));
-    program.SetUniform("u_mvp_matrix", projection * mv);
+    program.SetUniform(u_view_model_matrix, mv);
+    program.SetUniform(u_normal_matrix, glm::mat3(glm::vec3(mv[0]), glm::vec3(mv[1]), glm::vec3(mv[2])));
+    program.SetUniform(u_mvp_matrix, projection * mv);
 
     glBindVertexArray(quad_vao);
     glDrawArrays(GL_TRIANGLES, 0, 6);
@@ -152,7 +152,9 @@ void LoadShaderFromSourceCode()
 
 void InitGeometry()
 {
-    obj_mesh = glsl_shader::ObjMesh::LoadWithAdjacency("../../assets/models/bs_ears.obj");
+    glsl_shader::VertexFormat format;
+    format.optimize = true;
+    obj_mesh = glsl_shader::ObjMesh::LoadWithAdjacency("../../assets/models/bs_ears.obj", false, format);
 }
 
 void TerminateGeometry()
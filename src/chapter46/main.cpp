@@ -5,6 +5,7 @@
 #include "glm/gtc/matrix_transform.hpp"
 
 #include "common/glsl_program.h"
+#include "common/shader_compile_queue.h"
 
 #include <iostream>
 #include <cstdlib>
@@ -141,7 +142,17 @@ void LoadShaderFromSourceCode()
     program.CompileShader("../../assets/shaders/chapter46/tessellating_curve.tcs.glsl");
     program.CompileShader("../../assets/shaders/chapter46/tessellating_curve.tes.glsl");
     program.CompileShader("../../assets/shaders/chapter46/tessellating_curve.fs.glsl");
-    program.Link();
+    solid_program.CompileShader("../../assets/shaders/chapter46/solid.vs.glsl");
+    solid_program.CompileShader("../../assets/shaders/chapter46/solid.fs.glsl");
+
+    // 同时提交两个程序的编译和链接, 统一等待结果
+    glsl_shader::ShaderCompileQueue::SetMaxShaderCompilerThreads(static_cast<GLADloadfunc>(glfwGetProcAddress), 0xFFFFFFFF);
+    glsl_shader::ShaderCompileQueue compile_queue;
+    compile_queue.Add(program);
+    compile_queue.Add(solid_program);
+    compile_queue.Submit();
+    compile_queue.Join();
+
     program.Use();
     program.PrintActiveAttribs();
     program.PrintActiveUniformBlocks();
@@ -151,9 +162,6 @@ void LoadShaderFromSourceCode()
     program.SetUniform("u_strips_num", 1);
     program.SetUniform("u_line_color", glm::vec4(1.0f, 1.0f, 0.5f, 1.0f));
 
-    solid_program.CompileShader("../../assets/shaders/chapter46/solid.vs.glsl");
-    solid_program.CompileShader("../../assets/shaders/chapter46/solid.fs.glsl");
-    solid_program.Link();
     solid_program.Use();
     solid_program.PrintActiveAttribs();
     solid_program.PrintActiveUniformBlocks();
@@ -0,0 +1,92 @@
+﻿#include "common/asset_loader.h"
+
+#include <limits>
+
+namespace glsl_shader
+{
+    AssetLoader::AssetLoader(ThreadPool& pool)
+        : m_pool(pool),
+          m_decoding_count(0)
+    {
+
+    }
+
+    AssetLoader::~AssetLoader()
+    {
+        // 解码任务持有 this, 必须等它们结束
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_condition.wait(lock, [this]() { return m_decoding_count == 0; });
+        m_uploads.clear();
+    }
+
+    size_t AssetLoader::Update(double budget_ms)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        size_t upload_count = 0;
+        for (;;)
+        {
+            std::function<void()> upload;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_uploads.empty())
+                {
+                    break;
+                }
+                upload = std::move(m_uploads.front());
+                m_uploads.pop_front();
+            }
+
+            upload();
+            ++upload_count;
+
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            if (elapsed.count() >= budget_ms)
+            {
+                break;
+            }
+        }
+        return upload_count;
+    }
+
+    void AssetLoader::Finish()
+    {
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_condition.wait(lock, [this]() { return m_decoding_count == 0 || !m_uploads.empty(); });
+                if (m_decoding_count == 0 && m_uploads.empty())
+                {
+                    return;
+                }
+            }
+            Update(std::numeric_limits<double>::infinity());
+        }
+    }
+
+    size_t AssetLoader::GetPendingCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_decoding_count + m_uploads.size();
+    }
+
+    bool AssetLoader::IsIdle() const
+    {
+        return GetPendingCount() == 0;
+    }
+
+    void AssetLoader::PushUpload(std::function<void()> upload)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_uploads.push_back(std::move(upload));
+        m_condition.notify_all();
+    }
+
+    void AssetLoader::FinishDecode()
+    {
+        // 在锁内通知, 析构函数被唤醒时这里已经不再访问成员
+        std::lock_guard<std::mutex> lock(m_mutex);
+        --m_decoding_count;
+        m_condition.notify_all();
+    }
+}
\ No newline at end of file
@@ -2,7 +2,7 @@
 
 namespace glsl_shader
 {
-    Cube::Cube(float size)
+    Cube::Cube(float size, const VertexFormat& format)
     {
         GLfloat side2 = size / 2.0f;
 
@@ -64,7 +64,7 @@ namespace glsl_shader
             20, 21, 22, 20, 22, 23,
         };
 
-        m_mesh.Init(&indices, &positions, &normals, &uvs);
+        m_mesh.Init(&indices, &positions, &normals, &uvs, nullptr, format);
     }
 
     Cube::~Cube()
@@ -76,4 +76,9 @@ namespace glsl_shader
     {
         m_mesh.Render();
     }
+
+    const TriangleMesh& Cube::GetMesh() const
+    {
+        return m_mesh;
+    }
 }
\ No newline at end of file
@@ -0,0 +1,180 @@
+﻿#include "common/geometry_arena.h"
+
+#include <string>
+#include <stdexcept>
+
+namespace glsl_shader
+{
+    GeometryArena::GeometryArena()
+        : m_vao(0),
+          m_vertex_buffer(0),
+          m_index_buffer(0),
+          m_vertex_size(0),
+          m_vertex_capacity(0),
+          m_index_capacity(0),
+          m_vertex_count(0),
+          m_index_count(0)
+    {
+
+    }
+
+    GeometryArena::~GeometryArena()
+    {
+        Terminate();
+    }
+
+    void GeometryArena::Init(size_t vertex_capacity, size_t index_capacity, const VertexFormat& format)
+    {
+        Terminate();
+
+        m_format = format;
+        m_format.interleaved = true;
+        m_format.arena = this;
+
+        VertexAttribute attributes[TriangleMesh::ATTRIBUTE_COUNT] = {};
+        m_vertex_size = TriangleMesh::BuildVertexLayout(m_format, true, true, 0, attributes);
+        m_vertex_capacity = vertex_capacity;
+        m_index_capacity = index_capacity;
+
+        // 不可变存储, 之后只通过 glBufferSubData 写入; 用 GL_COPY_WRITE_BUFFER 避免改动当前 VAO 的索引缓冲绑定
+        glGenBuffers(1, &m_vertex_buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_vertex_buffer);
+        glBufferStorage(GL_COPY_WRITE_BUFFER, m_vertex_capacity * m_vertex_size, nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+        glGenBuffers(1, &m_index_buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_index_buffer);
+        glBufferStorage(GL_COPY_WRITE_BUFFER, m_index_capacity * sizeof(GLuint), nullptr, GL_DYNAMIC_STORAGE_BIT);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        glGenVertexArrays(1, &m_vao);
+        glBindVertexArray(m_vao);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_index_buffer);
+        glBindVertexBuffer(0, m_vertex_buffer, 0, m_vertex_size);
+
+        for (GLuint index = 0; index < TriangleMesh::ATTRIBUTE_COUNT; ++index)
+        {
+            const VertexAttribute& attribute = attributes[index];
+            glVertexAttribFormat(index, attribute.size, attribute.type, attribute.normalized, static_cast<GLuint>(attribute.offset));
+            glVertexAttribBinding(index, 0);
+            glEnableVertexAttribArray(index);
+        }
+
+        glBindVertexArray(0);
+    }
+
+    void GeometryArena::Terminate()
+    {
+        if (m_vao != 0)
+        {
+            glDeleteVertexArrays(1, &m_vao);
+            m_vao = 0;
+        }
+
+        if (m_vertex_buffer != 0)
+        {
+            glDeleteBuffers(1, &m_vertex_buffer);
+            m_vertex_buffer = 0;
+        }
+
+        if (m_index_buffer != 0)
+        {
+            glDeleteBuffers(1, &m_index_buffer);
+            m_index_buffer = 0;
+        }
+
+        m_vertex_capacity = 0;
+        m_index_capacity = 0;
+        m_vertex_count = 0;
+        m_index_count = 0;
+    }
+
+    void GeometryArena::Allocate
+    (
+        const void* vertices,
+        size_t vertex_count,
+        const GLuint* indices,
+        size_t index_count,
+        GLint& base_vertex,
+        GLuint& first_index
+    )
+    {
+        if (m_vao == 0)
+        {
+            throw std::runtime_error("几何缓冲没有初始化");
+        }
+
+        if (m_vertex_count + vertex_count > m_vertex_capacity || m_index_count + index_count > m_index_capacity)
+        {
+            throw std::runtime_error("几何缓冲空间不足: 需要 " + std::to_string(vertex_count) + " 个顶点和 " + std::to_string(index_count) + " 个索引, 剩余 "
+                + std::to_string(m_vertex_capacity - m_vertex_count) + " 个顶点和 " + std::to_string(m_index_capacity - m_index_count) + " 个索引");
+        }
+
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_vertex_buffer);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, m_vertex_count * m_vertex_size, vertex_count * m_vertex_size, vertices);
+
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_index_buffer);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, m_index_count * sizeof(GLuint), index_count * sizeof(GLuint), indices);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        base_vertex = static_cast<GLint>(m_vertex_count);
+        first_index = static_cast<GLuint>(m_index_count);
+        m_vertex_count += vertex_count;
+        m_index_count += index_count;
+    }
+
+    void GeometryArena::Bind() const
+    {
+        glBindVertexArray(m_vao);
+    }
+
+    void GeometryArena::Unbind() const
+    {
+        glBindVertexArray(0);
+    }
+
+    GLuint GeometryArena::GetVAO() const
+    {
+        return m_vao;
+    }
+
+    GLuint GeometryArena::GetVertexBuffer() const
+    {
+        return m_vertex_buffer;
+    }
+
+    GLuint GeometryArena::GetIndexBuffer() const
+    {
+        return m_index_buffer;
+    }
+
+    const VertexFormat& GeometryArena::GetVertexFormat() const
+    {
+        return m_format;
+    }
+
+    GLsizei GeometryArena::GetVertexSize() const
+    {
+        return m_vertex_size;
+    }
+
+    size_t GeometryArena::GetVertexCount() const
+    {
+        return m_vertex_count;
+    }
+
+    size_t GeometryArena::GetIndexCount() const
+    {
+        return m_index_count;
+    }
+
+    size_t GeometryArena::GetVertexCapacity() const
+    {
+        return m_vertex_capacity;
+    }
+
+    size_t GeometryArena::GetIndexCapacity() const
+    {
+        return m_index_capacity;
+    }
+}
\ No newline at end of file
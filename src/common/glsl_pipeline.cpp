@@ -0,0 +1,184 @@
+﻿#include "common/glsl_pipeline.h"
+#include "common/fnv_hash.h"
+
+#include <algorithm>
+
+namespace glsl_shader
+{
+    GLSLPipeline::GLSLPipeline()
+        : m_handle(0)
+    {
+        glGenProgramPipelines(1, &m_handle);
+        if (m_handle == 0)
+        {
+            throw GLSLProgramException("创建程序管线失败");
+        }
+    }
+
+    GLSLPipeline::~GLSLPipeline()
+    {
+        if (m_handle != 0)
+        {
+            glDeleteProgramPipelines(1, &m_handle);
+        }
+    }
+
+    void GLSLPipeline::UseProgramStages(GLSLProgram& program)
+    {
+        GLbitfield stages = 0;
+        for (ShaderType shader_type : program.GetShaderStages())
+        {
+            stages |= GetStageBit(shader_type);
+        }
+        UseProgramStages(stages, program);
+    }
+
+    void GLSLPipeline::UseProgramStages(GLbitfield stages, GLSLProgram& program)
+    {
+        if (!program.IsLinked() || !program.IsSeparable())
+        {
+            throw GLSLProgramException("程序管线只能使用已链接的可分离程序");
+        }
+        glUseProgramStages(m_handle, stages, program.GetHandle());
+    }
+
+    void GLSLPipeline::Validate()
+    {
+        GLint status = 0;
+        glValidateProgramPipeline(m_handle);
+        glGetProgramPipelineiv(m_handle, GL_VALIDATE_STATUS, &status);
+        if (status == GL_TRUE)
+        {
+            return;
+        }
+
+        std::string message = "程序管线验证失败";
+        GLint log_length = 0;
+        glGetProgramPipelineiv(m_handle, GL_INFO_LOG_LENGTH, &log_length);
+        if (log_length > 0)
+        {
+            std::string log(log_length, '\0');
+            GLsizei written_length = 0;
+            glGetProgramPipelineInfoLog(m_handle, log_length, &written_length, log.data());
+            message += log;
+        }
+        throw GLSLProgramException(message);
+    }
+
+    void GLSLPipeline::Bind()
+    {
+        glBindProgramPipeline(m_handle);
+    }
+
+    GLuint GLSLPipeline::GetHandle() const
+    {
+        return m_handle;
+    }
+
+    GLbitfield GLSLPipeline::GetStageBit(ShaderType shader_type)
+    {
+        switch (shader_type)
+        {
+        case ShaderType::Vertex:            return GL_VERTEX_SHADER_BIT;
+        case ShaderType::Fragment:          return GL_FRAGMENT_SHADER_BIT;
+        case ShaderType::Geometry:          return GL_GEOMETRY_SHADER_BIT;
+        case ShaderType::TessControl:       return GL_TESS_CONTROL_SHADER_BIT;
+        case ShaderType::TessEvaluation:    return GL_TESS_EVALUATION_SHADER_BIT;
+        case ShaderType::Compute:           return GL_COMPUTE_SHADER_BIT;
+        }
+        return 0;
+    }
+
+    PipelineCache::PipelineCache()
+    {
+
+    }
+
+    PipelineCache::~PipelineCache()
+    {
+
+    }
+
+    size_t PipelineCache::AddStage(const std::filesystem::path& shader_file_path, const ShaderDefines& defines)
+    {
+        // 先按文件路径和宏定义查找, 同一个阶段再次添加时不需要读取源代码
+        std::uint64_t path_key = FNV_OFFSET_BASIS;
+        std::string path = shader_file_path.lexically_normal().generic_string();
+        HashBytes(path_key, path.c_str(), path.size() + 1);
+        for (const std::pair<const std::string, std::string>& define : defines)
+        {
+            HashBytes(path_key, define.first.c_str(), define.first.size() + 1);
+            HashBytes(path_key, define.second.c_str(), define.second.size() + 1);
+        }
+
+        std::unordered_map<std::uint64_t, size_t>::iterator path_it = m_stage_indices_by_path.find(path_key);
+        if (path_it != m_stage_indices_by_path.end())
+        {
+            return path_it->second;
+        }
+
+        // CompileShader 只读取和预处理源代码, 不创建程序对象, 源代码哈希可以用来合并内容相同的阶段
+        std::unique_ptr<GLSLProgram> program = std::make_unique<GLSLProgram>();
+        program->SetDefines(defines);
+        program->SetSeparable(true);
+        program->CompileShader(shader_file_path);
+
+        std::uint64_t key = program->GetSourceHash();
+        std::unordered_map<std::uint64_t, size_t>::iterator it = m_stage_indices.find(key);
+        if (it != m_stage_indices.end())
+        {
+            m_stage_indices_by_path[path_key] = it->second;
+            return it->second;
+        }
+
+        program->Link();
+
+        size_t stage = m_stages.size();
+        m_stages.push_back(std::move(program));
+        m_stage_indices[key] = stage;
+        m_stage_indices_by_path[path_key] = stage;
+        return stage;
+    }
+
+    GLSLProgram& PipelineCache::GetStage(size_t stage)
+    {
+        if (stage >= m_stages.size())
+        {
+            throw GLSLProgramException("无效的阶段句柄");
+        }
+        return *m_stages[stage];
+    }
+
+    GLSLPipeline& PipelineCache::GetPipeline(const std::vector<size_t>& stages)
+    {
+        // 阶段的顺序不影响管线, 排序后作为键
+        std::vector<size_t> key = stages;
+        std::sort(key.begin(), key.end());
+
+        std::map<std::vector<size_t>, std::unique_ptr<GLSLPipeline>>::iterator it = m_pipelines.find(key);
+        if (it != m_pipelines.end())
+        {
+            return *it->second;
+        }
+
+        std::unique_ptr<GLSLPipeline> pipeline = std::make_unique<GLSLPipeline>();
+        for (size_t stage : key)
+        {
+            pipeline->UseProgramStages(GetStage(stage));
+        }
+
+        GLSLPipeline& result = *pipeline;
+        m_pipelines[key] = std::move(pipeline);
+        return result;
+    }
+
+    size_t PipelineCache::GetStageCount() const
+    {
+        return m_stages.size();
+    }
+
+    size_t PipelineCache::GetPipelineCount() const
+    {
+        return m_pipelines.size();
+    }
+}
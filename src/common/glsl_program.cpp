@@ -1,4 +1,5 @@
 ﻿#include "common/glsl_program.h"
+#include "common/fnv_hash.h"
 
 #include "glm/gtc/type_ptr.hpp"
 
@@ -6,6 +7,21 @@
 #include <vector>
 #include <fstream>
 #include <sstream>
+#include <iomanip>
+#include <cstring>
+#include <algorithm>
+#include <utility>
+#include <cctype>
+#include <random>
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <mach-o/dyld.h>
+#endif
 
 namespace glsl_shader
 {
@@ -19,6 +35,193 @@ namespace glsl_shader
         { ".cs.glsl", ShaderType::Compute},
     };
 
+    // 二进制缓存文件头, 用于识别文件和版本
+    static const char s_binary_cache_magic[4] = { 'G', 'L', 'S', 'B' };
+    static const std::uint32_t s_binary_cache_version = 1;
+
+    // 每次写缓存使用不同的临时文件, 多个进程或线程同时写同一个缓存时不会互相覆盖
+    static std::filesystem::path MakeTempCachePath(const std::filesystem::path& cache_path)
+    {
+        std::random_device random;
+        std::uint64_t id = (static_cast<std::uint64_t>(random()) << 32) ^ random() ^ std::hash<std::thread::id>()(std::this_thread::get_id());
+        std::filesystem::path temp_path = cache_path;
+        temp_path += "." + std::to_string(id) + ".tmp";
+        return temp_path;
+    }
+
+    // 相对路径在第一次使用时以可执行文件所在目录为根解析
+    static std::filesystem::path s_binary_cache_directory("shader_cache");
+
+    static GLSLProgram::SourceLoader s_source_loader;
+
+    // -1 表示尚未检测
+    static int s_parallel_compile_supported = -1;
+
+    // 取不到可执行文件的路径时返回空路径, 相对路径退回到工作目录
+    static std::filesystem::path GetExecutableDirectory()
+    {
+        std::error_code error;
+#ifdef _WIN32
+        std::wstring buffer(MAX_PATH, L'\0');
+        DWORD length = GetModuleFileNameW(nullptr, buffer.data(), static_cast<DWORD>(buffer.size()));
+        while (length == buffer.size())
+        {
+            buffer.resize(buffer.size() * 2);
+            length = GetModuleFileNameW(nullptr, buffer.data(), static_cast<DWORD>(buffer.size()));
+        }
+        if (length == 0)
+        {
+            return std::filesystem::path();
+        }
+        buffer.resize(length);
+        std::filesystem::path executable(buffer);
+#elif defined(__APPLE__)
+        std::uint32_t size = 0;
+        _NSGetExecutablePath(nullptr, &size);
+        std::string buffer(size, '\0');
+        if (_NSGetExecutablePath(buffer.data(), &size) != 0)
+        {
+            return std::filesystem::path();
+        }
+        std::filesystem::path executable = std::filesystem::canonical(buffer.c_str(), error);
+#else
+        std::filesystem::path executable = std::filesystem::read_symlink("/proc/self/exe", error);
+#endif
+        if (error)
+        {
+            return std::filesystem::path();
+        }
+        return executable.parent_path();
+    }
+
+    static bool IsIdentifierCharacter(char c)
+    {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+    }
+
+    static bool ContainsIdentifier(std::string_view source, const std::string& identifier)
+    {
+        size_t position = source.find(identifier);
+        while (position != std::string_view::npos)
+        {
+            size_t end = position + identifier.size();
+            bool is_begin = position == 0 || !IsIdentifierCharacter(source[position - 1]);
+            bool is_end = end >= source.size() || !IsIdentifierCharacter(source[end]);
+            if (is_begin && is_end)
+            {
+                return true;
+            }
+            position = source.find(identifier, position + 1);
+        }
+        return false;
+    }
+
+    // 资源文件都带有 UTF-8 BOM, 部分驱动不接受, 编译前去掉
+    static std::string_view StripByteOrderMark(std::string_view source)
+    {
+        if (source.size() >= 3 && source.compare(0, 3, "\xEF\xBB\xBF") == 0)
+        {
+            source.remove_prefix(3);
+        }
+        return source;
+    }
+
+    // 解析 #include "file" 行, # 和 include 之间允许有空白
+    static bool ParseInclude(std::string_view line, std::string& include_name)
+    {
+        size_t position = line.find_first_not_of(" \t");
+        if (position == std::string_view::npos || line[position] != '#')
+        {
+            return false;
+        }
+        position = line.find_first_not_of(" \t", position + 1);
+        if (position == std::string_view::npos || line.compare(position, 7, "include") != 0)
+        {
+            return false;
+        }
+
+        size_t begin = line.find('"', position + 7);
+        size_t end = begin == std::string_view::npos ? begin : line.find('"', begin + 1);
+        if (end == std::string_view::npos)
+        {
+            throw GLSLProgramException("无效的 #include: " + std::string(line));
+        }
+
+        include_name = std::string(line.substr(begin + 1, end - begin - 1));
+        return true;
+    }
+
+    // 从一个程序读取 uniform 的当前值并写入另一个程序, 重新加载时用于保留 uniform 状态
+    static void CopyUniformValue(GLuint source, GLint source_location, GLuint target, GLint target_location, GLenum type)
+    {
+        GLfloat float_values[16] = {};
+        GLint int_values[4] = {};
+        GLuint uint_values[4] = {};
+
+        switch (type)
+        {
+        case GL_FLOAT:
+        case GL_FLOAT_VEC2:
+        case GL_FLOAT_VEC3:
+        case GL_FLOAT_VEC4:
+        case GL_FLOAT_MAT2:
+        case GL_FLOAT_MAT3:
+        case GL_FLOAT_MAT4:
+        case GL_FLOAT_MAT2x3:
+        case GL_FLOAT_MAT2x4:
+        case GL_FLOAT_MAT3x2:
+        case GL_FLOAT_MAT3x4:
+        case GL_FLOAT_MAT4x2:
+        case GL_FLOAT_MAT4x3:
+            glGetUniformfv(source, source_location, float_values);
+            break;
+        case GL_UNSIGNED_INT:
+        case GL_UNSIGNED_INT_VEC2:
+        case GL_UNSIGNED_INT_VEC3:
+        case GL_UNSIGNED_INT_VEC4:
+            glGetUniformuiv(source, source_location, uint_values);
+            break;
+        case GL_DOUBLE:
+        case GL_DOUBLE_VEC2:
+        case GL_DOUBLE_VEC3:
+        case GL_DOUBLE_VEC4:
+            // 章节中没有使用双精度 uniform, 不复制
+            return;
+        default:
+            // int, bool 和所有采样器/图像类型都按整数读取
+            glGetUniformiv(source, source_location, int_values);
+            break;
+        }
+
+        switch (type)
+        {
+        case GL_FLOAT:              glProgramUniform1fv(target, target_location, 1, float_values); break;
+        case GL_FLOAT_VEC2:         glProgramUniform2fv(target, target_location, 1, float_values); break;
+        case GL_FLOAT_VEC3:         glProgramUniform3fv(target, target_location, 1, float_values); break;
+        case GL_FLOAT_VEC4:         glProgramUniform4fv(target, target_location, 1, float_values); break;
+        case GL_FLOAT_MAT2:         glProgramUniformMatrix2fv(target, target_location, 1, GL_FALSE, float_values); break;
+        case GL_FLOAT_MAT3:         glProgramUniformMatrix3fv(target, target_location, 1, GL_FALSE, float_values); break;
+        case GL_FLOAT_MAT4:         glProgramUniformMatrix4fv(target, target_location, 1, GL_FALSE, float_values); break;
+        case GL_FLOAT_MAT2x3:       glProgramUniformMatrix2x3fv(target, target_location, 1, GL_FALSE, float_values); break;
+        case GL_FLOAT_MAT2x4:       glProgramUniformMatrix2x4fv(target, target_location, 1, GL_FALSE, float_values); break;
+        case GL_FLOAT_MAT3x2:       glProgramUniformMatrix3x2fv(target, target_location, 1, GL_FALSE, float_values); break;
+        case GL_FLOAT_MAT3x4:       glProgramUniformMatrix3x4fv(target, target_location, 1, GL_FALSE, float_values); break;
+        case GL_FLOAT_MAT4x2:       glProgramUniformMatrix4x2fv(target, target_location, 1, GL_FALSE, float_values); break;
+        case GL_FLOAT_MAT4x3:       glProgramUniformMatrix4x3fv(target, target_location, 1, GL_FALSE, float_values); break;
+        case GL_UNSIGNED_INT:       glProgramUniform1uiv(target, target_location, 1, uint_values); break;
+        case GL_UNSIGNED_INT_VEC2:  glProgramUniform2uiv(target, target_location, 1, uint_values); break;
+        case GL_UNSIGNED_INT_VEC3:  glProgramUniform3uiv(target, target_location, 1, uint_values); break;
+        case GL_UNSIGNED_INT_VEC4:  glProgramUniform4uiv(target, target_location, 1, uint_values); break;
+        case GL_INT_VEC2:
+        case GL_BOOL_VEC2:          glProgramUniform2iv(target, target_location, 1, int_values); break;
+        case GL_INT_VEC3:
+        case GL_BOOL_VEC3:          glProgramUniform3iv(target, target_location, 1, int_values); break;
+        case GL_INT_VEC4:
+        case GL_BOOL_VEC4:          glProgramUniform4iv(target, target_location, 1, int_values); break;
+        default:                    glProgramUniform1iv(target, target_location, 1, int_values); break;
+        }
+    }
+
     GLSLProgramException::GLSLProgramException(const std::string& message)
         : std::runtime_error(message)
     {
@@ -27,7 +230,36 @@ namespace glsl_shader
 
     GLSLProgram::GLSLProgram()
         : m_handle(0),
-          m_is_linked(false)
+          m_is_linked(false),
+          m_lookups_saved(0),
+          m_source_hash(FNV_OFFSET_BASIS),
+          m_is_link_pending(false),
+          m_is_separable(false),
+          m_upload_stats()
+    {
+
+    }
+
+    GLSLProgram::GLSLProgram(GLSLProgram&& other) noexcept
+        : m_handle(std::exchange(other.m_handle, 0)),
+          m_is_linked(std::exchange(other.m_is_linked, false)),
+          m_uniform_locations(std::move(other.m_uniform_locations)),
+          m_lookups_saved(other.m_lookups_saved),
+          m_stage_sources(std::move(other.m_stage_sources)),
+          m_shader_stages(std::move(other.m_shader_stages)),
+          m_source_hash(std::exchange(other.m_source_hash, FNV_OFFSET_BASIS)),
+          m_is_link_pending(std::exchange(other.m_is_link_pending, false)),
+          m_is_separable(other.m_is_separable),
+          m_binary_cache_path(std::move(other.m_binary_cache_path)),
+          m_defines(std::move(other.m_defines)),
+          m_uniform_shadows(std::move(other.m_uniform_shadows)),
+          m_uniform_shadow_data(std::move(other.m_uniform_shadow_data)),
+          m_upload_stats(other.m_upload_stats),
+          m_shader_files(std::move(other.m_shader_files)),
+          m_shader_dependencies(std::move(other.m_shader_dependencies)),
+          m_attrib_bindings(std::move(other.m_attrib_bindings)),
+          m_frag_data_bindings(std::move(other.m_frag_data_bindings)),
+          m_shader_provider(std::move(other.m_shader_provider))
     {
 
     }
@@ -43,6 +275,56 @@ namespace glsl_shader
         glDeleteProgram(m_handle);
     }
 
+    GLSLProgram& GLSLProgram::operator = (GLSLProgram&& other) noexcept
+    {
+        if (this != &other)
+        {
+            // 借助临时对象的析构释放当前持有的程序对象
+            GLSLProgram released(std::move(*this));
+
+            m_handle = std::exchange(other.m_handle, 0);
+            m_is_linked = std::exchange(other.m_is_linked, false);
+            m_uniform_locations = std::move(other.m_uniform_locations);
+            m_lookups_saved = other.m_lookups_saved;
+            m_stage_sources = std::move(other.m_stage_sources);
+            m_shader_stages = std::move(other.m_shader_stages);
+            m_source_hash = std::exchange(other.m_source_hash, FNV_OFFSET_BASIS);
+            m_is_link_pending = std::exchange(other.m_is_link_pending, false);
+            m_is_separable = other.m_is_separable;
+            m_binary_cache_path = std::move(other.m_binary_cache_path);
+            m_defines = std::move(other.m_defines);
+            m_uniform_shadows = std::move(other.m_uniform_shadows);
+            m_uniform_shadow_data = std::move(other.m_uniform_shadow_data);
+            m_upload_stats = other.m_upload_stats;
+            m_shader_files = std::move(other.m_shader_files);
+            m_shader_dependencies = std::move(other.m_shader_dependencies);
+            m_attrib_bindings = std::move(other.m_attrib_bindings);
+            m_frag_data_bindings = std::move(other.m_frag_data_bindings);
+            m_shader_provider = std::move(other.m_shader_provider);
+        }
+        return *this;
+    }
+
+    void GLSLProgram::SetDefines(const ShaderDefines& defines)
+    {
+        m_defines = defines;
+    }
+
+    const ShaderDefines& GLSLProgram::GetDefines() const
+    {
+        return m_defines;
+    }
+
+    void GLSLProgram::SetSeparable(bool is_separable)
+    {
+        m_is_separable = is_separable;
+    }
+
+    bool GLSLProgram::IsSeparable() const
+    {
+        return m_is_separable;
+    }
+
     void GLSLProgram::CompileShader(const std::filesystem::path& shader_file_path)
     {
         std::string extension = shader_file_path.extension().string();
@@ -62,106 +344,292 @@ namespace glsl_shader
 
     void GLSLProgram::CompileShader(const std::filesystem::path& shader_file_path, ShaderType shader_type)
     {
-        if (!FileExists(shader_file_path.string()))
+        CompileShader(shader_file_path, shader_type, true);
+    }
+
+    void GLSLProgram::CompileShader(const std::filesystem::path& shader_file_path, ShaderType shader_type, bool use_source_loader)
+    {
+        StageSource stage;
+        stage.type = shader_type;
+        std::set<std::filesystem::path> included;
+        AppendSource(shader_file_path, stage, included, use_source_loader);
+
+        AddStageSource(std::move(stage));
+        m_shader_files.emplace_back(shader_file_path, shader_type);
+        m_shader_dependencies.insert(included.begin(), included.end());
+    }
+
+    void GLSLProgram::CompileShader(const std::string& source, ShaderType shader_type)
+    {
+        StageSource stage;
+        stage.type = shader_type;
+        stage.storage.push_back(std::make_shared<const std::string>(source));
+        stage.segments.push_back(StripByteOrderMark(*stage.storage.back()));
+
+        AddStageSource(std::move(stage));
+    }
+
+    void GLSLProgram::CreateHandle()
+    {
+        if (m_handle > 0)
         {
-            std::string message = "着色器文件不存在: " + shader_file_path.string();
-            throw GLSLProgramException(message);
+            return;
         }
 
+        m_handle = glCreateProgram();
         if (m_handle <= 0)
         {
-            m_handle = glCreateProgram();
-            if (m_handle <= 0)
+            throw GLSLProgramException("创建着色器程序失败");
+        }
+    }
+
+    void GLSLProgram::AppendSource(const std::filesystem::path& shader_file_path, StageSource& stage, std::set<std::filesystem::path>& included, bool use_source_loader)
+    {
+        std::filesystem::path path = shader_file_path.lexically_normal();
+        if (!included.insert(path).second)
+        {
+            return;
+        }
+
+        // 优先从着色器包中取得源代码, 不存在时从磁盘读取整个文件
+        std::string_view source;
+        if (!use_source_loader || !s_source_loader || !s_source_loader(path, source))
+        {
+            std::ifstream shader_file(path, std::ios::in | std::ios::binary | std::ios::ate);
+            if (!shader_file.is_open())
             {
-                throw GLSLProgramException("创建着色器程序失败");
+                std::string message = "无法打开着色器文件: " + path.string();
+                throw GLSLProgramException(message);
             }
+
+            std::shared_ptr<std::string> code = std::make_shared<std::string>(static_cast<size_t>(shader_file.tellg()), '\0');
+            shader_file.seekg(0);
+            shader_file.read(code->data(), code->size());
+            stage.storage.push_back(code);
+            source = *code;
         }
+        source = StripByteOrderMark(source);
 
-        std::ifstream shader_file(shader_file_path, std::ios::in);
-        if (!shader_file.is_open())
+        // 按行查找 #include, 其余内容作为片段直接引用
+        size_t segment_begin = 0;
+        size_t line_number = 1;
+        for (size_t line_begin = 0; line_begin < source.size(); ++line_number)
         {
-            std::string message = "无法打开着色器文件: " + shader_file_path.string();
-            throw GLSLProgramException(message);
-        }
+            size_t line_end = source.find('\n', line_begin);
+            size_t next_line = line_end == std::string_view::npos ? source.size() : line_end + 1;
 
-        std::stringstream code;
-        code << shader_file.rdbuf();
-        shader_file.close();
+            std::string include_name;
+            if (ParseInclude(source.substr(line_begin, next_line - line_begin), include_name))
+            {
+                if (line_begin > segment_begin)
+                {
+                    stage.segments.push_back(source.substr(segment_begin, line_begin - segment_begin));
+                }
+
+                // 使用 #line 让编译错误中的行号对应到原来的文件
+                stage.storage.push_back(std::make_shared<const std::string>("#line 1\n"));
+                stage.segments.push_back(*stage.storage.back());
+                AppendSource(path.parent_path() / include_name, stage, included, use_source_loader);
+                stage.storage.push_back(std::make_shared<const std::string>("\n#line " + std::to_string(line_number + 1) + "\n"));
+                stage.segments.push_back(*stage.storage.back());
+
+                segment_begin = next_line;
+            }
+            line_begin = next_line;
+        }
 
-        CompileShader(code.str(), shader_type);
+        if (segment_begin < source.size())
+        {
+            stage.segments.push_back(source.substr(segment_begin));
+        }
     }
 
-    void GLSLProgram::CompileShader(const std::string& source, ShaderType shader_type)
+    void GLSLProgram::AddStageSource(StageSource&& stage)
     {
-        if (m_handle <= 0)
+        // 宏定义插入到 #version 所在行之后, 只注入源代码中出现过的宏,
+        // 与宏无关的阶段保持源代码不变, 可以在程序之间共享编译结果
+        std::string define_lines;
+        for (const std::pair<const std::string, std::string>& define : m_defines)
         {
-            m_handle = glCreateProgram();
-            if (m_handle <= 0)
+            for (std::string_view segment : stage.segments)
             {
-                throw GLSLProgramException("创建着色器程序失败");
+                if (ContainsIdentifier(segment, define.first))
+                {
+                    define_lines += "#define " + define.first + " " + define.second + "\n";
+                    break;
+                }
             }
         }
 
-        GLuint shader = glCreateShader(static_cast<unsigned int>(shader_type));
-        const char* code = source.c_str();
-        glShaderSource(shader, 1, &code, nullptr);
-
-        glCompileShader(shader);
-        int result = 0;
-        glGetShaderiv(shader, GL_COMPILE_STATUS, &result);
-        if (result == GL_FALSE)
+        if (!define_lines.empty())
         {
-            std::string message = "编译着色器失败";
-            GLint log_length = 0;
-            glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &log_length);
-            if (log_length > 0)
+            stage.storage.push_back(std::make_shared<const std::string>(define_lines));
+            std::string_view defines = *stage.storage.back();
+
+            size_t index = 0;
+            size_t split = 0;
+            for (; index < stage.segments.size(); ++index)
             {
-                std::string log(log_length, '\0');
-                GLsizei written_length = 0;
-                glGetShaderInfoLog(shader, log_length, &written_length, log.data());
-                message += log;
+                size_t version = stage.segments[index].find("#version");
+                if (version != std::string_view::npos)
+                {
+                    size_t line_end = stage.segments[index].find('\n', version);
+                    split = line_end == std::string_view::npos ? stage.segments[index].size() : line_end + 1;
+                    break;
+                }
+            }
+
+            if (index == stage.segments.size())
+            {
+                stage.segments.insert(stage.segments.begin(), defines);
+            }
+            else
+            {
+                std::string_view segment = stage.segments[index];
+                stage.segments[index] = segment.substr(0, split);
+                stage.segments.insert(stage.segments.begin() + index + 1, segment.substr(split));
+                stage.segments.insert(stage.segments.begin() + index + 1, defines);
             }
-            throw GLSLProgramException(message);
         }
-        else
+
+        // 只记录源代码, 真正的编译推迟到 Link() 中, 命中二进制缓存时可以跳过编译
+        unsigned int type = static_cast<unsigned int>(stage.type);
+        HashBytes(m_source_hash, &type, sizeof(type));
+        for (std::string_view segment : stage.segments)
+        {
+            HashBytes(m_source_hash, segment.data(), segment.size());
+        }
+        m_shader_stages.push_back(stage.type);
+        m_stage_sources.push_back(std::move(stage));
+    }
+
+    void GLSLProgram::CompileAndAttachStage(const StageSource& stage)
+    {
+        // 由 ProgramCache 创建的程序共享相同源代码的着色器对象
+        if (m_shader_provider)
+        {
+            glAttachShader(m_handle, m_shader_provider(stage.type, stage.segments));
+            return;
+        }
+
+        // 只提交编译, 不查询状态, 支持并行编译的驱动可以在后台完成编译
+        std::vector<const GLchar*> code;
+        std::vector<GLint> lengths;
+        for (std::string_view segment : stage.segments)
         {
-            glAttachShader(m_handle, shader);
+            code.push_back(segment.data());
+            lengths.push_back(static_cast<GLint>(segment.size()));
         }
+
+        GLuint shader = glCreateShader(static_cast<unsigned int>(stage.type));
+        glShaderSource(shader, static_cast<GLsizei>(code.size()), code.data(), lengths.data());
+        glCompileShader(shader);
+        glAttachShader(m_handle, shader);
     }
 
     void GLSLProgram::Link()
     {
-        if (m_is_linked)
+        SubmitLink();
+        FinishLink();
+    }
+
+    void GLSLProgram::SubmitLink()
+    {
+        if (m_is_linked || m_is_link_pending)
         {
             return;
         }
 
-        if (m_handle <= 0)
+        if (m_handle <= 0 && m_stage_sources.empty())
         {
             throw GLSLProgramException("着色器程序不完整");
         }
 
+        CreateHandle();
+        m_is_link_pending = true;
+
+        // 可分离标记会影响链接结果, 需要计入缓存键
+        if (m_is_separable)
+        {
+            HashBytes(m_source_hash, "separable", 9);
+            glProgramParameteri(m_handle, GL_PROGRAM_SEPARABLE, GL_TRUE);
+        }
+
+        // 命中二进制缓存时直接加载, 跳过编译和链接
+        m_binary_cache_path = GetBinaryCachePath();
+        if (!m_binary_cache_path.empty() && LoadBinaryCache(m_binary_cache_path))
+        {
+            m_stage_sources.clear();
+            m_binary_cache_path.clear();
+            return;
+        }
+
+        for (const StageSource& stage : m_stage_sources)
+        {
+            CompileAndAttachStage(stage);
+        }
+        m_stage_sources.clear();
+
+        if (!m_binary_cache_path.empty())
+        {
+            glProgramParameteri(m_handle, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
+
         glLinkProgram(m_handle);
+    }
+
+    bool GLSLProgram::IsLinkComplete()
+    {
+        if (!m_is_link_pending || !IsParallelCompileSupported())
+        {
+            return true;
+        }
+
+        GLint completed = GL_FALSE;
+        glGetProgramiv(m_handle, GL_COMPLETION_STATUS_KHR, &completed);
+        return completed == GL_TRUE;
+    }
+
+    void GLSLProgram::FinishLink()
+    {
+        if (!m_is_link_pending)
+        {
+            return;
+        }
+        m_is_link_pending = false;
+
         int result = 0;
-        std::string message = "链接着色器失败";
+        std::string message;
         glGetProgramiv(m_handle, GL_LINK_STATUS, &result);
         if (result == GL_FALSE)
         {
-            GLint log_length = 0;
-            glGetProgramiv(m_handle, GL_INFO_LOG_LENGTH, &log_length);
-            if (log_length > 0)
+            // 优先报告编译错误, 没有编译错误时才报告链接错误
+            message = GetCompileErrors();
+            if (message.empty())
             {
-                std::string log(log_length, '\0');
-                GLsizei written_length = 0;
-                glGetProgramInfoLog(m_handle, log_length, &written_length, log.data());
-                message += log;
+                message = "链接着色器失败";
+                GLint log_length = 0;
+                glGetProgramiv(m_handle, GL_INFO_LOG_LENGTH, &log_length);
+                if (log_length > 0)
+                {
+                    std::string log(log_length, '\0');
+                    GLsizei written_length = 0;
+                    glGetProgramInfoLog(m_handle, log_length, &written_length, log.data());
+                    message += log;
+                }
             }
         }
         else
         {
             FindUniformLocations();
             m_is_linked = true;
+
+            if (!m_binary_cache_path.empty())
+            {
+                SaveBinaryCache(m_binary_cache_path);
+            }
         }
+        m_binary_cache_path.clear();
 
         DetachAndDeleteShaderObjects();
 
@@ -171,6 +639,172 @@ namespace glsl_shader
         }
     }
 
+    void GLSLProgram::Reload()
+    {
+        if (m_shader_files.empty())
+        {
+            throw GLSLProgramException("着色器程序不是从文件编译的, 无法重新加载");
+        }
+
+        // 在新的程序对象中编译和链接, 失败时异常直接抛出, 当前程序不受影响
+        GLSLProgram program;
+        program.SetDefines(m_defines);
+        program.SetSeparable(m_is_separable);
+        for (const std::pair<std::filesystem::path, ShaderType>& file : m_shader_files)
+        {
+            // 重新加载时总是读取磁盘上的文件
+            program.CompileShader(file.first, file.second, false);
+        }
+        for (const std::pair<GLuint, std::string>& binding : m_attrib_bindings)
+        {
+            program.BindAttribLocation(binding.first, binding.second.c_str());
+        }
+        for (const std::pair<GLuint, std::string>& binding : m_frag_data_bindings)
+        {
+            program.BindFragDataLocation(binding.first, binding.second.c_str());
+        }
+        program.Link();
+
+        if (m_is_linked)
+        {
+            CopyUniformState(program);
+        }
+
+        GLint current_program = 0;
+        glGetIntegerv(GL_CURRENT_PROGRAM, &current_program);
+        if (m_handle != 0 && static_cast<GLuint>(current_program) == m_handle)
+        {
+            glUseProgram(program.m_handle);
+        }
+
+        // 交换后旧的程序对象由临时对象负责删除
+        std::swap(m_handle, program.m_handle);
+        std::swap(m_uniform_locations, program.m_uniform_locations);
+        std::swap(m_uniform_shadows, program.m_uniform_shadows);
+        std::swap(m_uniform_shadow_data, program.m_uniform_shadow_data);
+        std::swap(m_shader_dependencies, program.m_shader_dependencies);
+        m_is_linked = true;
+    }
+
+    const std::vector<std::pair<std::filesystem::path, ShaderType>>& GLSLProgram::GetShaderFiles() const
+    {
+        return m_shader_files;
+    }
+
+    const std::set<std::filesystem::path>& GLSLProgram::GetShaderDependencies() const
+    {
+        return m_shader_dependencies;
+    }
+
+    const std::vector<ShaderType>& GLSLProgram::GetShaderStages() const
+    {
+        return m_shader_stages;
+    }
+
+    void GLSLProgram::CopyUniformState(GLSLProgram& target)
+    {
+        // 默认 uniform block 中的值: 按名称在新程序中查找位置, 逐个数组元素复制
+        GLint uniforms_num = 0;
+        glGetProgramInterfaceiv(m_handle, GL_UNIFORM, GL_ACTIVE_RESOURCES, &uniforms_num);
+
+        GLenum properties[] = { GL_NAME_LENGTH, GL_TYPE, GL_LOCATION, GL_BLOCK_INDEX, GL_ARRAY_SIZE };
+        for (GLint i = 0; i < uniforms_num; ++i)
+        {
+            GLint result[5] = { 0, 0, 0, 0, 0 };
+            glGetProgramResourceiv(m_handle, GL_UNIFORM, i, 5, properties, 5, nullptr, result);
+            if (result[3] != -1 || result[2] < 0)
+            {
+                continue;
+            }
+
+            std::string name(result[0] + 1, '\0');
+            glGetProgramResourceName(m_handle, GL_UNIFORM, i, result[0] + 1, nullptr, name.data());
+            name.resize(std::strlen(name.c_str()));
+
+            std::string base_name = name;
+            if (result[4] > 1 && base_name.size() > 3 && base_name.compare(base_name.size() - 3, 3, "[0]") == 0)
+            {
+                base_name.resize(base_name.size() - 3);
+            }
+
+            for (GLint element = 0; element < result[4]; ++element)
+            {
+                std::string element_name = result[4] > 1 ? base_name + "[" + std::to_string(element) + "]" : name;
+                GLint target_location = glGetUniformLocation(target.m_handle, element_name.c_str());
+                if (target_location < 0)
+                {
+                    continue;
+                }
+                CopyUniformValue(m_handle, result[2] + element, target.m_handle, target_location, result[1]);
+            }
+        }
+
+        // uniform block 和 shader storage block 的绑定点
+        const GLenum block_interfaces[] = { GL_UNIFORM_BLOCK, GL_SHADER_STORAGE_BLOCK };
+        for (GLenum block_interface : block_interfaces)
+        {
+            GLint blocks_num = 0;
+            glGetProgramInterfaceiv(m_handle, block_interface, GL_ACTIVE_RESOURCES, &blocks_num);
+
+            GLenum block_properties[] = { GL_NAME_LENGTH, GL_BUFFER_BINDING };
+            for (GLint block = 0; block < blocks_num; ++block)
+            {
+                GLint block_info[2] = { 0, 0 };
+                glGetProgramResourceiv(m_handle, block_interface, block, 2, block_properties, 2, nullptr, block_info);
+
+                std::string block_name(block_info[0] + 1, '\0');
+                glGetProgramResourceName(m_handle, block_interface, block, block_info[0] + 1, nullptr, block_name.data());
+
+                GLuint target_index = glGetProgramResourceIndex(target.m_handle, block_interface, block_name.c_str());
+                if (target_index == GL_INVALID_INDEX)
+                {
+                    continue;
+                }
+
+                if (block_interface == GL_UNIFORM_BLOCK)
+                {
+                    glUniformBlockBinding(target.m_handle, target_index, block_info[1]);
+                }
+                else
+                {
+                    glShaderStorageBlockBinding(target.m_handle, target_index, block_info[1]);
+                }
+            }
+        }
+    }
+
+    std::string GLSLProgram::GetCompileErrors()
+    {
+        std::string message;
+
+        GLint shaders_num = 0;
+        glGetProgramiv(m_handle, GL_ATTACHED_SHADERS, &shaders_num);
+        std::vector<GLuint> shaders(shaders_num);
+        glGetAttachedShaders(m_handle, shaders_num, nullptr, shaders.data());
+        for (GLuint shader : shaders)
+        {
+            int result = 0;
+            glGetShaderiv(shader, GL_COMPILE_STATUS, &result);
+            if (result == GL_TRUE)
+            {
+                continue;
+            }
+
+            message += "编译着色器失败";
+            GLint log_length = 0;
+            glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &log_length);
+            if (log_length > 0)
+            {
+                std::string log(log_length, '\0');
+                GLsizei written_length = 0;
+                glGetShaderInfoLog(shader, log_length, &written_length, log.data());
+                message += log;
+            }
+        }
+
+        return message;
+    }
+
     void GLSLProgram::Validate()
     {
         if (!IsLinked())
@@ -221,74 +855,288 @@ namespace glsl_shader
         return m_is_linked;
     }
 
+    std::uint64_t GLSLProgram::GetSourceHash() const
+    {
+        return m_source_hash;
+    }
+
     void GLSLProgram::BindAttribLocation(GLuint location, const char* name)
     {
+        // 绑定关系会影响链接结果, 需要计入缓存键
+        HashBytes(m_source_hash, "attrib", 6);
+        HashBytes(m_source_hash, &location, sizeof(location));
+        HashBytes(m_source_hash, name, std::strlen(name));
+        CreateHandle();
         glBindAttribLocation(m_handle, location, name);
+        m_attrib_bindings.emplace_back(location, name);
     }
 
     void GLSLProgram::BindFragDataLocation(GLuint location, const char* name)
     {
+        HashBytes(m_source_hash, "frag_data", 9);
+        HashBytes(m_source_hash, &location, sizeof(location));
+        HashBytes(m_source_hash, name, std::strlen(name));
+        CreateHandle();
         glBindFragDataLocation(m_handle, location, name);
+        m_frag_data_bindings.emplace_back(location, name);
     }
 
     void GLSLProgram::SetUniform(const char* name, float x, float y, float z)
     {
-        GLint location = glGetUniformLocation(m_handle, name);
-        glUniform3f(location, x, y, z);
+        GLint location = GetUniformLocation(name);
+        GLfloat value[3] = { x, y, z };
+        if (!ShouldUpload(location, value, sizeof(value)))
+        {
+            return;
+        }
+        glProgramUniform3fv(m_handle, location, 1, value);
     }
 
     void GLSLProgram::SetUniform(const char* name, const glm::vec2& value)
     {
-        GLint location = glGetUniformLocation(m_handle, name);
-        glUniform2fv(location, 1, glm::value_ptr(value));
+        GLint location = GetUniformLocation(name);
+        if (!ShouldUpload(location, glm::value_ptr(value), sizeof(glm::vec2)))
+        {
+            return;
+        }
+        glProgramUniform2fv(m_handle, location, 1, glm::value_ptr(value));
     }
 
     void GLSLProgram::SetUniform(const char* name, const glm::vec3& value)
     {
-        GLint location = glGetUniformLocation(m_handle, name);
-        glUniform3fv(location, 1, glm::value_ptr(value));
+        GLint location = GetUniformLocation(name);
+        if (!ShouldUpload(location, glm::value_ptr(value), sizeof(glm::vec3)))
+        {
+            return;
+        }
+        glProgramUniform3fv(m_handle, location, 1, glm::value_ptr(value));
     }
 
     void GLSLProgram::SetUniform(const char* name, const glm::vec4& value)
     {
-        GLint location = glGetUniformLocation(m_handle, name);
-        glUniform4fv(location, 1, glm::value_ptr(value));
+        GLint location = GetUniformLocation(name);
+        if (!ShouldUpload(location, glm::value_ptr(value), sizeof(glm::vec4)))
+        {
+            return;
+        }
+        glProgramUniform4fv(m_handle, location, 1, glm::value_ptr(value));
     }
 
     void GLSLProgram::SetUniform(const char* name, const glm::mat3& value)
     {
-        GLint location = glGetUniformLocation(m_handle, name);
-        glUniformMatrix3fv(location, 1, GL_FALSE, glm::value_ptr(value));
+        GLint location = GetUniformLocation(name);
+        if (!ShouldUpload(location, glm::value_ptr(value), sizeof(glm::mat3)))
+        {
+            return;
+        }
+        glProgramUniformMatrix3fv(m_handle, location, 1, GL_FALSE, glm::value_ptr(value));
     }
 
     void GLSLProgram::SetUniform(const char* name, const glm::mat4& value)
     {
-        GLint location = glGetUniformLocation(m_handle, name);
-        glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
+        GLint location = GetUniformLocation(name);
+        if (!ShouldUpload(location, glm::value_ptr(value), sizeof(glm::mat4)))
+        {
+            return;
+        }
+        glProgramUniformMatrix4fv(m_handle, location, 1, GL_FALSE, glm::value_ptr(value));
     }
 
     void GLSLProgram::SetUniform(const char* name, float value)
     {
-        GLint location = glGetUniformLocation(m_handle, name);
-        glUniform1f(location, value);
+        GLint location = GetUniformLocation(name);
+        if (!ShouldUpload(location, &value, sizeof(value)))
+        {
+            return;
+        }
+        glProgramUniform1f(m_handle, location, value);
     }
 
     void GLSLProgram::SetUniform(const char* name, bool value)
     {
-        GLint location = glGetUniformLocation(m_handle, name);
-        glUniform1i(location, value);
+        GLint location = GetUniformLocation(name);
+        GLint int_value = value ? 1 : 0;
+        if (!ShouldUpload(location, &int_value, sizeof(int_value)))
+        {
+            return;
+        }
+        glProgramUniform1i(m_handle, location, int_value);
     }
 
     void GLSLProgram::SetUniform(const char* name, int value)
     {
-        GLint location = glGetUniformLocation(m_handle, name);
-        glUniform1i(location, value);
+        GLint location = GetUniformLocation(name);
+        if (!ShouldUpload(location, &value, sizeof(value)))
+        {
+            return;
+        }
+        glProgramUniform1i(m_handle, location, value);
     }
 
     void GLSLProgram::SetUniform(const char* name, GLuint value)
     {
-        GLint location = glGetUniformLocation(m_handle, name);
-        glUniform1ui(location, value);
+        GLint location = GetUniformLocation(name);
+        if (!ShouldUpload(location, &value, sizeof(value)))
+        {
+            return;
+        }
+        glProgramUniform1ui(m_handle, location, value);
+    }
+
+    void GLSLProgram::SetUniform(const UniformHandle<glm::vec2>& handle, const glm::vec2& value)
+    {
+        ++m_lookups_saved;
+        GLint location = handle.GetLocation();
+        if (!ShouldUpload(location, glm::value_ptr(value), sizeof(glm::vec2)))
+        {
+            return;
+        }
+        glProgramUniform2fv(m_handle, location, 1, glm::value_ptr(value));
+    }
+
+    void GLSLProgram::SetUniform(const UniformHandle<glm::vec3>& handle, const glm::vec3& value)
+    {
+        ++m_lookups_saved;
+        GLint location = handle.GetLocation();
+        if (!ShouldUpload(location, glm::value_ptr(value), sizeof(glm::vec3)))
+        {
+            return;
+        }
+        glProgramUniform3fv(m_handle, location, 1, glm::value_ptr(value));
+    }
+
+    void GLSLProgram::SetUniform(const UniformHandle<glm::vec4>& handle, const glm::vec4& value)
+    {
+        ++m_lookups_saved;
+        GLint location = handle.GetLocation();
+        if (!ShouldUpload(location, glm::value_ptr(value), sizeof(glm::vec4)))
+        {
+            return;
+        }
+        glProgramUniform4fv(m_handle, location, 1, glm::value_ptr(value));
+    }
+
+    void GLSLProgram::SetUniform(const UniformHandle<glm::mat3>& handle, const glm::mat3& value)
+    {
+        ++m_lookups_saved;
+        GLint location = handle.GetLocation();
+        if (!ShouldUpload(location, glm::value_ptr(value), sizeof(glm::mat3)))
+        {
+            return;
+        }
+        glProgramUniformMatrix3fv(m_handle, location, 1, GL_FALSE, glm::value_ptr(value));
+    }
+
+    void GLSLProgram::SetUniform(const UniformHandle<glm::mat4>& handle, const glm::mat4& value)
+    {
+        ++m_lookups_saved;
+        GLint location = handle.GetLocation();
+        if (!ShouldUpload(location, glm::value_ptr(value), sizeof(glm::mat4)))
+        {
+            return;
+        }
+        glProgramUniformMatrix4fv(m_handle, location, 1, GL_FALSE, glm::value_ptr(value));
+    }
+
+    void GLSLProgram::SetUniform(const UniformHandle<float>& handle, float value)
+    {
+        ++m_lookups_saved;
+        GLint location = handle.GetLocation();
+        if (!ShouldUpload(location, &value, sizeof(value)))
+        {
+            return;
+        }
+        glProgramUniform1f(m_handle, location, value);
+    }
+
+    void GLSLProgram::SetUniform(const UniformHandle<bool>& handle, bool value)
+    {
+        ++m_lookups_saved;
+        GLint location = handle.GetLocation();
+        GLint int_value = value ? 1 : 0;
+        if (!ShouldUpload(location, &int_value, sizeof(int_value)))
+        {
+            return;
+        }
+        glProgramUniform1i(m_handle, location, int_value);
+    }
+
+    void GLSLProgram::SetUniform(const UniformHandle<int>& handle, int value)
+    {
+        ++m_lookups_saved;
+        GLint location = handle.GetLocation();
+        if (!ShouldUpload(location, &value, sizeof(value)))
+        {
+            return;
+        }
+        glProgramUniform1i(m_handle, location, value);
+    }
+
+    void GLSLProgram::SetUniform(const UniformHandle<GLuint>& handle, GLuint value)
+    {
+        ++m_lookups_saved;
+        GLint location = handle.GetLocation();
+        if (!ShouldUpload(location, &value, sizeof(value)))
+        {
+            return;
+        }
+        glProgramUniform1ui(m_handle, location, value);
+    }
+
+    unsigned long long GLSLProgram::GetLookupsSaved() const
+    {
+        return m_lookups_saved;
+    }
+
+    void GLSLProgram::ResetLookupsSaved()
+    {
+        m_lookups_saved = 0;
+    }
+
+    UniformUploadStats GLSLProgram::GetUniformUploadStats() const
+    {
+        return m_upload_stats;
+    }
+
+    void GLSLProgram::ResetUniformUploadStats()
+    {
+        m_upload_stats = UniformUploadStats();
+    }
+
+    void GLSLProgram::InvalidateUniformShadow()
+    {
+        for (UniformShadow& shadow : m_uniform_shadows)
+        {
+            shadow.is_valid = false;
+        }
+    }
+
+    bool GLSLProgram::ShouldUpload(GLint location, const void* data, size_t size)
+    {
+        if (location < 0)
+        {
+            return false;
+        }
+
+        // 没有反射信息(例如结构体数组中未被列出的位置)时直接上传
+        if (location >= static_cast<GLint>(m_uniform_shadows.size()) || m_uniform_shadows[location].size < size)
+        {
+            ++m_upload_stats.issued;
+            return true;
+        }
+
+        UniformShadow& shadow = m_uniform_shadows[location];
+        unsigned char* shadow_data = m_uniform_shadow_data.data() + shadow.offset;
+        if (shadow.is_valid && std::memcmp(shadow_data, data, size) == 0)
+        {
+            ++m_upload_stats.skipped;
+            return false;
+        }
+
+        std::memcpy(shadow_data, data, size);
+        shadow.is_valid = true;
+        ++m_upload_stats.issued;
+        return true;
     }
 
     GLuint GLSLProgram::GetSubroutineIndex(ShaderType shader_type, const char* name)
@@ -304,15 +1152,17 @@ namespace glsl_shader
     void GLSLProgram::FindUniformLocations()
     {
         m_uniform_locations.clear();
+        m_uniform_shadows.clear();
+        m_uniform_shadow_data.clear();
 
         GLint uniforms_num = 0;
         glGetProgramInterfaceiv(m_handle, GL_UNIFORM, GL_ACTIVE_RESOURCES, &uniforms_num);
 
-        GLenum properties[] = { GL_NAME_LENGTH, GL_TYPE, GL_LOCATION, GL_BLOCK_INDEX };
+        GLenum properties[] = { GL_NAME_LENGTH, GL_TYPE, GL_LOCATION, GL_BLOCK_INDEX, GL_ARRAY_SIZE };
         for (GLint i = 0; i < uniforms_num; ++i)
         {
-            GLint result[4] = { 0, 0, 0, 0 };
-            glGetProgramResourceiv(m_handle, GL_UNIFORM, i, 4, properties, 4, nullptr, result);
+            GLint result[5] = { 0, 0, 0, 0, 0 };
+            glGetProgramResourceiv(m_handle, GL_UNIFORM, i, 5, properties, 5, nullptr, result);
 
             // 跳过在 uniform block 中的 uniform 变量
             if (result[3] != -1)
@@ -324,6 +1174,25 @@ namespace glsl_shader
             glGetProgramResourceName(m_handle, GL_UNIFORM, i, name_buffer_size, nullptr, name);
             m_uniform_locations[name] = result[2];
             delete[] name;
+
+            // 为每个数组元素分配一份影子数据, 记录最近一次上传的值
+            if (result[2] < 0)
+            {
+                continue;
+            }
+            size_t type_size = GetTypeSize(result[1]);
+            for (GLint element = 0; element < result[4]; ++element)
+            {
+                size_t location = static_cast<size_t>(result[2] + element);
+                if (location >= m_uniform_shadows.size())
+                {
+                    m_uniform_shadows.resize(location + 1);
+                }
+                m_uniform_shadows[location].offset = m_uniform_shadow_data.size();
+                m_uniform_shadows[location].size = type_size;
+                m_uniform_shadows[location].is_valid = false;
+                m_uniform_shadow_data.resize(m_uniform_shadow_data.size() + type_size);
+            }
         }
     }
 
@@ -425,6 +1294,7 @@ namespace glsl_shader
             return location;
         }
 
+        ++m_lookups_saved;
         return position->second;
     }
 
@@ -437,17 +1307,219 @@ namespace glsl_shader
         for (GLuint shader : shaders)
         {
             glDetachShader(m_handle, shader);
-            glDeleteShader(shader);
+
+            // 共享的着色器对象由 ProgramCache 负责删除
+            if (!m_shader_provider)
+            {
+                glDeleteShader(shader);
+            }
         }
     }
 
-    bool GLSLProgram::FileExists(const std::string& filename)
+    std::filesystem::path GLSLProgram::GetBinaryCachePath()
     {
-        struct stat info;
-        int ret = -1;
+        const std::filesystem::path& cache_directory = GetBinaryCacheDirectory();
+        if (cache_directory.empty() || m_stage_sources.empty())
+        {
+            return std::filesystem::path();
+        }
+
+        GLint formats_num = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats_num);
+        if (formats_num < 1)
+        {
+            return std::filesystem::path();
+        }
+
+        // 缓存键 = 所有阶段源代码的哈希 + 驱动信息, 更换显卡或驱动后自动失效
+        std::uint64_t hash = m_source_hash;
+        const char* driver_strings[] =
+        {
+            reinterpret_cast<const char*>(glGetString(GL_RENDERER)),
+            reinterpret_cast<const char*>(glGetString(GL_VERSION)),
+        };
+        for (const char* driver_string : driver_strings)
+        {
+            if (driver_string == nullptr)
+            {
+                continue;
+            }
+            HashBytes(hash, driver_string, std::strlen(driver_string));
+        }
 
-        ret = stat(filename.c_str(), &info);
-        return 0 == ret;
+        std::ostringstream name;
+        name << std::hex << std::setw(16) << std::setfill('0') << hash << ".bin";
+        return cache_directory / name.str();
+    }
+
+    bool GLSLProgram::LoadBinaryCache(const std::filesystem::path& cache_path)
+    {
+        std::ifstream cache_file(cache_path, std::ios::binary);
+        if (!cache_file.is_open())
+        {
+            return false;
+        }
+
+        char magic[4] = { 0, 0, 0, 0 };
+        std::uint32_t version = 0;
+        GLenum format = 0;
+        std::uint32_t length = 0;
+        cache_file.read(magic, sizeof(magic));
+        cache_file.read(reinterpret_cast<char*>(&version), sizeof(version));
+        cache_file.read(reinterpret_cast<char*>(&format), sizeof(format));
+        cache_file.read(reinterpret_cast<char*>(&length), sizeof(length));
+        if (!cache_file || std::memcmp(magic, s_binary_cache_magic, sizeof(magic)) != 0 || version != s_binary_cache_version || length == 0)
+        {
+            return false;
+        }
+
+        std::vector<char> binary(length);
+        cache_file.read(binary.data(), length);
+        if (!cache_file)
+        {
+            return false;
+        }
+
+        GLint formats_num = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats_num);
+        std::vector<GLint> formats(formats_num);
+        glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, formats.data());
+        if (std::find(formats.begin(), formats.end(), static_cast<GLint>(format)) == formats.end())
+        {
+            return false;
+        }
+
+        // 驱动不接受该二进制时静默回退到从源代码编译
+        glProgramBinary(m_handle, format, binary.data(), static_cast<GLsizei>(length));
+        GLint status = GL_FALSE;
+        glGetProgramiv(m_handle, GL_LINK_STATUS, &status);
+        return status == GL_TRUE;
+    }
+
+    void GLSLProgram::SaveBinaryCache(const std::filesystem::path& cache_path)
+    {
+        GLint length = 0;
+        glGetProgramiv(m_handle, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0)
+        {
+            return;
+        }
+
+        std::vector<char> binary(length);
+        GLenum format = 0;
+        glGetProgramBinary(m_handle, length, nullptr, &format, binary.data());
+
+        std::error_code error;
+        std::filesystem::create_directories(cache_path.parent_path(), error);
+        if (error)
+        {
+            return;
+        }
+
+        // 先写临时文件再改名, 避免多个进程同时启动时读到写了一半的缓存
+        std::filesystem::path temp_path = MakeTempCachePath(cache_path);
+        bool written = false;
+        {
+            std::ofstream cache_file(temp_path, std::ios::binary | std::ios::trunc);
+            if (!cache_file.is_open())
+            {
+                return;
+            }
+
+            std::uint32_t binary_length = static_cast<std::uint32_t>(length);
+            cache_file.write(s_binary_cache_magic, sizeof(s_binary_cache_magic));
+            cache_file.write(reinterpret_cast<const char*>(&s_binary_cache_version), sizeof(s_binary_cache_version));
+            cache_file.write(reinterpret_cast<const char*>(&format), sizeof(format));
+            cache_file.write(reinterpret_cast<const char*>(&binary_length), sizeof(binary_length));
+            cache_file.write(binary.data(), length);
+            written = cache_file.good();
+        }
+
+        // 写入或改名失败时放弃这次缓存, 删除临时文件, 下次启动重新链接
+        if (written)
+        {
+            std::filesystem::rename(temp_path, cache_path, error);
+        }
+        if (!written || error)
+        {
+            std::filesystem::remove(temp_path, error);
+        }
+    }
+
+    bool GLSLProgram::IsParallelCompileSupported()
+    {
+        if (s_parallel_compile_supported < 0)
+        {
+            s_parallel_compile_supported = 0;
+            GLint extensions = 0;
+            glGetIntegerv(GL_NUM_EXTENSIONS, &extensions);
+            for (GLint i = 0; i < extensions; ++i)
+            {
+                const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+                if (std::strcmp(extension, "GL_KHR_parallel_shader_compile") == 0 || std::strcmp(extension, "GL_ARB_parallel_shader_compile") == 0)
+                {
+                    s_parallel_compile_supported = 1;
+                    break;
+                }
+            }
+        }
+
+        return s_parallel_compile_supported == 1;
+    }
+
+    void GLSLProgram::SetSourceLoader(SourceLoader source_loader)
+    {
+        s_source_loader = std::move(source_loader);
+    }
+
+    void GLSLProgram::SetBinaryCacheDirectory(const std::filesystem::path& directory)
+    {
+        s_binary_cache_directory = directory;
+    }
+
+    const std::filesystem::path& GLSLProgram::GetBinaryCacheDirectory()
+    {
+        if (s_binary_cache_directory.is_relative() && !s_binary_cache_directory.empty())
+        {
+            std::filesystem::path executable_directory = GetExecutableDirectory();
+            if (!executable_directory.empty())
+            {
+                s_binary_cache_directory = executable_directory / s_binary_cache_directory;
+            }
+        }
+        return s_binary_cache_directory;
+    }
+
+    size_t GLSLProgram::GetTypeSize(GLenum type)
+    {
+        switch (type)
+        {
+          case GL_FLOAT_VEC2:
+          case GL_INT_VEC2:
+          case GL_UNSIGNED_INT_VEC2:
+          case GL_BOOL_VEC2:
+            return 2 * sizeof(GLfloat);
+          case GL_FLOAT_VEC3:
+          case GL_INT_VEC3:
+          case GL_UNSIGNED_INT_VEC3:
+          case GL_BOOL_VEC3:
+            return 3 * sizeof(GLfloat);
+          case GL_FLOAT_VEC4:
+          case GL_INT_VEC4:
+          case GL_UNSIGNED_INT_VEC4:
+          case GL_BOOL_VEC4:
+          case GL_FLOAT_MAT2:
+            return 4 * sizeof(GLfloat);
+          case GL_FLOAT_MAT3:
+            return 9 * sizeof(GLfloat);
+          case GL_FLOAT_MAT4:
+            return 16 * sizeof(GLfloat);
+          case GL_DOUBLE:
+            return sizeof(GLdouble);
+          default:
+            // float, int, uint, bool 以及各种 sampler/image
+            return sizeof(GLfloat);
+        }
     }
 
     const char* GLSLProgram::GetTypeString(GLenum type)
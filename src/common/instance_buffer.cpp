@@ -0,0 +1,98 @@
+﻿#include "common/instance_buffer.h"
+
+namespace glsl_shader
+{
+    static_assert(sizeof(InstanceData) == 160, "InstanceData 必须与着色器中的 std430 布局一致");
+
+    InstanceBuffer::InstanceBuffer()
+        : m_buffer(0),
+          m_binding(0),
+          m_capacity(0)
+    {
+
+    }
+
+    InstanceBuffer::~InstanceBuffer()
+    {
+        Terminate();
+    }
+
+    void InstanceBuffer::Init(GLuint binding)
+    {
+        Terminate();
+
+        m_binding = binding;
+        glGenBuffers(1, &m_buffer);
+    }
+
+    void InstanceBuffer::Terminate()
+    {
+        if (m_buffer != 0)
+        {
+            glDeleteBuffers(1, &m_buffer);
+            m_buffer = 0;
+        }
+
+        m_capacity = 0;
+        m_instances.clear();
+    }
+
+    void InstanceBuffer::Clear()
+    {
+        m_instances.clear();
+    }
+
+    GLuint InstanceBuffer::Add(const glm::mat4& model_matrix, const glm::vec4& color, const glm::vec4& params)
+    {
+        glm::mat3 normal_matrix = glm::transpose(glm::inverse(glm::mat3(model_matrix)));
+
+        InstanceData instance;
+        instance.model_matrix = model_matrix;
+        instance.normal_matrix = glm::mat4(normal_matrix);
+        instance.color = color;
+        instance.params = params;
+        m_instances.push_back(instance);
+
+        return static_cast<GLuint>(m_instances.size() - 1);
+    }
+
+    void InstanceBuffer::Upload()
+    {
+        if (m_buffer == 0 || m_instances.empty())
+        {
+            return;
+        }
+
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_buffer);
+        if (m_instances.size() > m_capacity)
+        {
+            m_capacity = m_instances.size();
+            glBufferData(GL_SHADER_STORAGE_BUFFER, m_capacity * sizeof(InstanceData), m_instances.data(), GL_DYNAMIC_DRAW);
+        }
+        else
+        {
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, m_instances.size() * sizeof(InstanceData), m_instances.data());
+        }
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    void InstanceBuffer::Bind() const
+    {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, m_binding, m_buffer);
+    }
+
+    GLsizei InstanceBuffer::GetCount() const
+    {
+        return static_cast<GLsizei>(m_instances.size());
+    }
+
+    GLuint InstanceBuffer::GetBinding() const
+    {
+        return m_binding;
+    }
+
+    GLuint InstanceBuffer::GetBuffer() const
+    {
+        return m_buffer;
+    }
+}
\ No newline at end of file
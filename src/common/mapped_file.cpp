@@ -0,0 +1,121 @@
+﻿#include "common/mapped_file.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace glsl_shader
+{
+    MappedFile::MappedFile()
+        : m_data(nullptr),
+          m_size(0),
+#ifdef _WIN32
+          m_file(INVALID_HANDLE_VALUE),
+          m_mapping(nullptr)
+#else
+          m_file(-1)
+#endif
+    {
+
+    }
+
+    MappedFile::~MappedFile()
+    {
+        Close();
+    }
+
+    bool MappedFile::Open(const std::filesystem::path& file_path)
+    {
+        Close();
+
+#ifdef _WIN32
+        m_file = CreateFileW(file_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+        LARGE_INTEGER file_size;
+        GetFileSizeEx(m_file, &file_size);
+        m_size = static_cast<size_t>(file_size.QuadPart);
+        m_mapping = m_size == 0 ? nullptr : CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        m_data = m_mapping == nullptr ? nullptr : static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+        m_file = open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (m_file < 0)
+        {
+            return false;
+        }
+        struct stat file_stat;
+        fstat(m_file, &file_stat);
+        m_size = static_cast<size_t>(file_stat.st_size);
+        void* data = m_size == 0 ? MAP_FAILED : mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_file, 0);
+        m_data = data == MAP_FAILED ? nullptr : static_cast<const char*>(data);
+#endif
+        if (m_data == nullptr)
+        {
+            Close();
+            return false;
+        }
+
+        return true;
+    }
+
+    void MappedFile::Close()
+    {
+#ifdef _WIN32
+        if (m_data != nullptr)
+        {
+            UnmapViewOfFile(m_data);
+        }
+        if (m_mapping != nullptr)
+        {
+            CloseHandle(m_mapping);
+            m_mapping = nullptr;
+        }
+        if (m_file != INVALID_HANDLE_VALUE)
+        {
+            CloseHandle(m_file);
+            m_file = INVALID_HANDLE_VALUE;
+        }
+#else
+        if (m_data != nullptr)
+        {
+            munmap(const_cast<char*>(m_data), m_size);
+        }
+        if (m_file >= 0)
+        {
+            close(m_file);
+            m_file = -1;
+        }
+#endif
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+    bool MappedFile::IsOpen() const
+    {
+        return m_data != nullptr;
+    }
+
+    const char* MappedFile::GetData() const
+    {
+        return m_data;
+    }
+
+    size_t MappedFile::GetSize() const
+    {
+        return m_size;
+    }
+
+    std::string_view MappedFile::GetView() const
+    {
+        return std::string_view(m_data, m_size);
+    }
+}
\ No newline at end of file
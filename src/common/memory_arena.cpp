@@ -0,0 +1,109 @@
+﻿#include "common/memory_arena.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+namespace glsl_shader
+{
+    // 翻倍增长的块大小上限, 更大的请求按请求的大小单独分配
+    static const size_t s_max_block_size = 16 * 1024 * 1024;
+
+    // 块头之后的可用内存按 max_align_t 对齐
+    static const size_t s_block_header_size = (sizeof(void*) + sizeof(size_t) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+
+    static char* AlignPointer(char* p, size_t alignment)
+    {
+        std::uintptr_t address = reinterpret_cast<std::uintptr_t>(p);
+        return p + ((alignment - address % alignment) % alignment);
+    }
+
+    MemoryArena::MemoryArena(size_t block_size, MemoryArenaStatistics* statistics)
+        : m_blocks(nullptr),
+          m_current(nullptr),
+          m_end(nullptr),
+          m_block_size(std::max<size_t>(block_size, 1024)),
+          m_next_block_size(m_block_size),
+          m_reserved_bytes(0),
+          m_own_statistics{ 0, 0, 0, 0 },
+          m_statistics(statistics != nullptr ? statistics : &m_own_statistics)
+    {
+
+    }
+
+    MemoryArena::~MemoryArena()
+    {
+        Release();
+    }
+
+    void* MemoryArena::Allocate(size_t bytes, size_t alignment)
+    {
+        ++m_statistics->allocation_count;
+
+        char* p = m_current != nullptr ? AlignPointer(m_current, alignment) : nullptr;
+        if (p == nullptr || bytes > static_cast<size_t>(m_end - p))
+        {
+            // 当前块剩余的空间直接放弃, 单调分配器不会回头使用
+            size_t block_size = std::max(m_next_block_size, s_block_header_size + bytes + alignment);
+            Block* block = static_cast<Block*>(::operator new(block_size));
+            block->next = m_blocks;
+            block->size = block_size;
+            m_blocks = block;
+            m_current = reinterpret_cast<char*>(block) + s_block_header_size;
+            m_end = reinterpret_cast<char*>(block) + block_size;
+            m_next_block_size = std::min(m_next_block_size * 2, s_max_block_size);
+
+            m_reserved_bytes += block_size;
+            ++m_statistics->block_count;
+            m_statistics->reserved_bytes += block_size;
+            m_statistics->peak_bytes = std::max(m_statistics->peak_bytes, m_statistics->reserved_bytes);
+
+            p = AlignPointer(m_current, alignment);
+        }
+
+        m_current = p + bytes;
+        return p;
+    }
+
+    void MemoryArena::Release()
+    {
+        while (m_blocks != nullptr)
+        {
+            Block* next = m_blocks->next;
+            m_statistics->reserved_bytes -= m_blocks->size;
+            ::operator delete(m_blocks);
+            m_blocks = next;
+        }
+
+        m_current = nullptr;
+        m_end = nullptr;
+        m_next_block_size = m_block_size;
+        m_reserved_bytes = 0;
+    }
+
+    size_t MemoryArena::GetReservedBytes() const
+    {
+        return m_reserved_bytes;
+    }
+
+    const MemoryArenaStatistics& MemoryArena::GetStatistics() const
+    {
+        return *m_statistics;
+    }
+
+    void* MemoryArena::do_allocate(size_t bytes, size_t alignment)
+    {
+        return Allocate(bytes, alignment);
+    }
+
+    // 单调分配, 单次释放什么也不做, 内存只在 Release() 或析构时整体归还
+    void MemoryArena::do_deallocate(void*, size_t, size_t)
+    {
+
+    }
+
+    bool MemoryArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+    {
+        return this == &other;
+    }
+}
\ No newline at end of file
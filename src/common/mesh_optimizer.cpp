@@ -0,0 +1,397 @@
+﻿#include "common/mesh_optimizer.h"
+
+#include "glm/glm.hpp"
+
+#include <algorithm>
+#include <string>
+#include <stdexcept>
+
+namespace glsl_shader
+{
+    // 时间戳模拟 FIFO 缓存, 返回这个三角形的未命中次数
+    static unsigned int UpdateCache(const GLuint* triangle, unsigned int cache_size, std::vector<unsigned int>& timestamps, unsigned int& timestamp)
+    {
+        unsigned int misses = 0;
+        for (int corner = 0; corner < 3; ++corner)
+        {
+            GLuint vertex = triangle[corner];
+            if (timestamp - timestamps[vertex] > cache_size)
+            {
+                timestamps[vertex] = timestamp++;
+                ++misses;
+            }
+        }
+        return misses;
+    }
+
+    static size_t GetVertexCount(const std::vector<GLuint>& indices)
+    {
+        GLuint max_index = 0;
+        for (GLuint index : indices)
+        {
+            max_index = std::max(max_index, index);
+        }
+        return indices.empty() ? 0 : max_index + 1;
+    }
+
+    VertexCacheStatistics MeshOptimizer::AnalyzeVertexCache(const std::vector<GLuint>& indices, size_t vertex_count, unsigned int cache_size)
+    {
+        VertexCacheStatistics statistics = { 0, 0.0f, 0.0f };
+        if (indices.empty() || vertex_count == 0)
+        {
+            return statistics;
+        }
+
+        std::vector<unsigned int> timestamps(vertex_count, 0);
+        unsigned int timestamp = cache_size + 1;
+
+        size_t triangle_count = indices.size() / 3;
+        for (size_t i = 0; i < triangle_count; ++i)
+        {
+            statistics.vertices_transformed += UpdateCache(&indices[i * 3], cache_size, timestamps, timestamp);
+        }
+
+        statistics.acmr = static_cast<float>(statistics.vertices_transformed) / static_cast<float>(triangle_count);
+        statistics.atvr = static_cast<float>(statistics.vertices_transformed) / static_cast<float>(vertex_count);
+        return statistics;
+    }
+
+    void MeshOptimizer::OptimizeVertexCache(std::vector<GLuint>& indices, size_t vertex_count, unsigned int cache_size)
+    {
+        size_t triangle_count = indices.size() / 3;
+        if (triangle_count == 0 || vertex_count == 0)
+        {
+            return;
+        }
+
+        // 每个顶点相邻的三角形, 压缩存储
+        std::vector<GLuint> live_triangles(vertex_count, 0);
+        for (GLuint index : indices)
+        {
+            ++live_triangles[index];
+        }
+
+        std::vector<GLuint> adjacency_offsets(vertex_count + 1, 0);
+        for (size_t vertex = 0; vertex < vertex_count; ++vertex)
+        {
+            adjacency_offsets[vertex + 1] = adjacency_offsets[vertex] + live_triangles[vertex];
+        }
+
+        std::vector<GLuint> adjacency(indices.size());
+        std::vector<GLuint> fill_offsets(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+        for (size_t triangle = 0; triangle < triangle_count; ++triangle)
+        {
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                adjacency[fill_offsets[indices[triangle * 3 + corner]]++] = static_cast<GLuint>(triangle);
+            }
+        }
+
+        std::vector<unsigned int> cache_timestamps(vertex_count, 0);
+        std::vector<bool> emitted(triangle_count, false);
+        std::vector<GLuint> dead_end;
+        std::vector<GLuint> candidates;
+        std::vector<GLuint> result;
+        result.reserve(indices.size());
+
+        unsigned int timestamp = cache_size + 1;
+        size_t input_cursor = 1;
+        long long fanning_vertex = 0;
+
+        while (fanning_vertex >= 0)
+        {
+            // 输出扇心顶点所有未输出的三角形
+            candidates.clear();
+            GLuint vertex = static_cast<GLuint>(fanning_vertex);
+            for (GLuint offset = adjacency_offsets[vertex]; offset < adjacency_offsets[vertex + 1]; ++offset)
+            {
+                GLuint triangle = adjacency[offset];
+                if (emitted[triangle])
+                {
+                    continue;
+                }
+
+                for (int corner = 0; corner < 3; ++corner)
+                {
+                    GLuint v = indices[triangle * 3 + corner];
+                    result.push_back(v);
+                    dead_end.push_back(v);
+                    candidates.push_back(v);
+                    --live_triangles[v];
+                    if (timestamp - cache_timestamps[v] > cache_size)
+                    {
+                        cache_timestamps[v] = timestamp++;
+                    }
+                }
+                emitted[triangle] = true;
+            }
+
+            // 在刚输出的顶点里选下一个扇心: 仍在缓存中且剩余三角形能在缓存失效前输出完的顶点里最老的一个
+            fanning_vertex = -1;
+            long long best_priority = -1;
+            for (GLuint v : candidates)
+            {
+                if (live_triangles[v] == 0)
+                {
+                    continue;
+                }
+
+                long long priority = 0;
+                if (timestamp - cache_timestamps[v] + 2 * live_triangles[v] <= cache_size)
+                {
+                    priority = timestamp - cache_timestamps[v];
+                }
+
+                if (priority > best_priority)
+                {
+                    best_priority = priority;
+                    fanning_vertex = v;
+                }
+            }
+
+            // 死胡同: 先从最近输出的顶点里找, 再按输入顺序找
+            while (fanning_vertex < 0 && !dead_end.empty())
+            {
+                GLuint v = dead_end.back();
+                dead_end.pop_back();
+                if (live_triangles[v] > 0)
+                {
+                    fanning_vertex = v;
+                }
+            }
+
+            while (fanning_vertex < 0 && input_cursor < vertex_count)
+            {
+                if (live_triangles[input_cursor] > 0)
+                {
+                    fanning_vertex = static_cast<long long>(input_cursor);
+                }
+                ++input_cursor;
+            }
+        }
+
+        indices.swap(result);
+    }
+
+    void MeshOptimizer::OptimizeOverdraw(std::vector<GLuint>& indices, const std::vector<GLfloat>& positions, float threshold, unsigned int cache_size)
+    {
+        size_t triangle_count = indices.size() / 3;
+        size_t vertex_count = positions.size() / 3;
+        if (triangle_count == 0 || vertex_count == 0)
+        {
+            return;
+        }
+
+        // 硬边界: 三个顶点都不在缓存里的三角形通常是新的一片
+        std::vector<unsigned int> timestamps(vertex_count, 0);
+        unsigned int timestamp = cache_size + 1;
+        std::vector<size_t> hard_clusters;
+        for (size_t i = 0; i < triangle_count; ++i)
+        {
+            unsigned int misses = UpdateCache(&indices[i * 3], cache_size, timestamps, timestamp);
+            if (i == 0 || misses == 3)
+            {
+                hard_clusters.push_back(i);
+            }
+        }
+
+        // 软边界: 簇内累计 ACMR 降到簇整体 ACMR * threshold 以下时切开
+        std::vector<size_t> clusters;
+        for (size_t cluster = 0; cluster < hard_clusters.size(); ++cluster)
+        {
+            size_t start = hard_clusters[cluster];
+            size_t end = cluster + 1 < hard_clusters.size() ? hard_clusters[cluster + 1] : triangle_count;
+
+            timestamp += cache_size + 1;
+            unsigned int cluster_misses = 0;
+            for (size_t i = start; i < end; ++i)
+            {
+                cluster_misses += UpdateCache(&indices[i * 3], cache_size, timestamps, timestamp);
+            }
+            float cluster_threshold = threshold * static_cast<float>(cluster_misses) / static_cast<float>(end - start);
+
+            clusters.push_back(start);
+
+            timestamp += cache_size + 1;
+            unsigned int running_misses = 0;
+            unsigned int running_triangles = 0;
+            for (size_t i = start; i < end; ++i)
+            {
+                running_misses += UpdateCache(&indices[i * 3], cache_size, timestamps, timestamp);
+                ++running_triangles;
+
+                if (static_cast<float>(running_misses) / static_cast<float>(running_triangles) <= cluster_threshold)
+                {
+                    clusters.push_back(i + 1);
+                    timestamp += cache_size + 1;
+                    running_misses = 0;
+                    running_triangles = 0;
+                }
+            }
+
+            // 最后一段通常达不到目标 ACMR, 并入前一个簇
+            if (clusters.back() != start)
+            {
+                clusters.pop_back();
+            }
+        }
+
+        // 整个网格的中心
+        glm::vec3 mesh_centroid(0.0f);
+        for (size_t i = 0; i < indices.size(); ++i)
+        {
+            const GLfloat* p = &positions[indices[i] * 3];
+            mesh_centroid += glm::vec3(p[0], p[1], p[2]);
+        }
+        mesh_centroid /= static_cast<float>(indices.size());
+
+        // 簇的排序值: 簇中心相对网格中心的偏移在簇平均法线上的投影, 越朝外越先画
+        std::vector<float> sort_keys(clusters.size(), 0.0f);
+        for (size_t cluster = 0; cluster < clusters.size(); ++cluster)
+        {
+            size_t start = clusters[cluster];
+            size_t end = cluster + 1 < clusters.size() ? clusters[cluster + 1] : triangle_count;
+
+            glm::vec3 centroid(0.0f);
+            glm::vec3 normal(0.0f);
+            float area_sum = 0.0f;
+            for (size_t i = start; i < end; ++i)
+            {
+                const GLfloat* p0 = &positions[indices[i * 3 + 0] * 3];
+                const GLfloat* p1 = &positions[indices[i * 3 + 1] * 3];
+                const GLfloat* p2 = &positions[indices[i * 3 + 2] * 3];
+                glm::vec3 a(p0[0], p0[1], p0[2]);
+                glm::vec3 b(p1[0], p1[1], p1[2]);
+                glm::vec3 c(p2[0], p2[1], p2[2]);
+
+                glm::vec3 face_normal = glm::cross(b - a, c - a);
+                float area = glm::length(face_normal);
+
+                centroid += (a + b + c) * (area / 3.0f);
+                normal += face_normal;
+                area_sum += area;
+            }
+
+            if (area_sum > 0.0f)
+            {
+                centroid /= area_sum;
+            }
+
+            float normal_length = glm::length(normal);
+            if (normal_length > 0.0f)
+            {
+                normal /= normal_length;
+            }
+
+            sort_keys[cluster] = glm::dot(centroid - mesh_centroid, normal);
+        }
+
+        std::vector<size_t> order(clusters.size());
+        for (size_t cluster = 0; cluster < clusters.size(); ++cluster)
+        {
+            order[cluster] = cluster;
+        }
+        std::stable_sort(order.begin(), order.end(), [&sort_keys](size_t a, size_t b) { return sort_keys[a] > sort_keys[b]; });
+
+        std::vector<GLuint> result;
+        result.reserve(indices.size());
+        for (size_t cluster : order)
+        {
+            size_t start = clusters[cluster];
+            size_t end = cluster + 1 < clusters.size() ? clusters[cluster + 1] : triangle_count;
+            result.insert(result.end(), indices.begin() + start * 3, indices.begin() + end * 3);
+        }
+
+        indices.swap(result);
+    }
+
+    // 按 remap 重排一个属性数组, remap[旧序号] = 新序号
+    static void RemapVertexStream(std::vector<GLfloat>& stream, const std::vector<GLuint>& remap, size_t components)
+    {
+        std::vector<GLfloat> result(stream.size());
+        for (size_t vertex = 0; vertex < remap.size(); ++vertex)
+        {
+            std::copy
+            (
+                stream.begin() + vertex * components,
+                stream.begin() + (vertex + 1) * components,
+                result.begin() + remap[vertex] * components
+            );
+        }
+        stream.swap(result);
+    }
+
+    void MeshOptimizer::OptimizeVertexFetch
+    (
+        std::vector<GLuint>& indices,
+        std::vector<GLfloat>& positions,
+        std::vector<GLfloat>& normals,
+        std::vector<GLfloat>* uvs,
+        std::vector<GLfloat>* tangents
+    )
+    {
+        size_t vertex_count = positions.size() / 3;
+        const GLuint unused = static_cast<GLuint>(-1);
+
+        std::vector<GLuint> remap(vertex_count, unused);
+        GLuint next_vertex = 0;
+        for (GLuint& index : indices)
+        {
+            if (index >= vertex_count)
+            {
+                throw std::out_of_range("顶点索引 " + std::to_string(index) + " 超出顶点数量 " + std::to_string(vertex_count));
+            }
+            if (remap[index] == unused)
+            {
+                remap[index] = next_vertex++;
+            }
+            index = remap[index];
+        }
+
+        for (GLuint& target : remap)
+        {
+            if (target == unused)
+            {
+                target = next_vertex++;
+            }
+        }
+
+        RemapVertexStream(positions, remap, 3);
+        RemapVertexStream(normals, remap, 3);
+        if (uvs != nullptr && uvs->size() == vertex_count * 2)
+        {
+            RemapVertexStream(*uvs, remap, 2);
+        }
+        if (tangents != nullptr && tangents->size() == vertex_count * 4)
+        {
+            RemapVertexStream(*tangents, remap, 4);
+        }
+    }
+
+    void MeshOptimizer::Optimize
+    (
+        std::vector<GLuint>& indices,
+        std::vector<GLfloat>& positions,
+        std::vector<GLfloat>& normals,
+        std::vector<GLfloat>* uvs,
+        std::vector<GLfloat>* tangents,
+        VertexCacheStatistics* before,
+        VertexCacheStatistics* after
+    )
+    {
+        size_t vertex_count = std::max(positions.size() / 3, GetVertexCount(indices));
+        if (before != nullptr)
+        {
+            *before = AnalyzeVertexCache(indices, vertex_count);
+        }
+
+        OptimizeVertexCache(indices, vertex_count);
+        OptimizeOverdraw(indices, positions);
+        OptimizeVertexFetch(indices, positions, normals, uvs, tangents);
+
+        if (after != nullptr)
+        {
+            *after = AnalyzeVertexCache(indices, vertex_count);
+        }
+    }
+}
\ No newline at end of file
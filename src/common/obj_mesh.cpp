@@ -1,39 +1,595 @@
 ﻿#include "common/obj_mesh.h"
+#include "common/mesh_optimizer.h"
+#include "common/mapped_file.h"
+#include "common/fnv_hash.h"
+#include "common/thread_pool.h"
 
 #include <iostream>
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <charconv>
+#include <chrono>
+#include <cstring>
 #include <fstream>
-#include <unordered_map>
+#include <random>
+#include <thread>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GLSL_SHADER_USE_SSE
+#include <emmintrin.h>
+#endif
 
 namespace glsl_shader
 {
-    static void trim_string(std::string& str)
+    // 以下函数直接在映射的文件内容上解析, 不会越过 end, 也不会越过行尾
+    static bool IsBlank(char c)
     {
-        const char* white_space = " \t\n\r";
-        size_t location = str.find_first_not_of(white_space);
-        str.erase(0, location);
-        location = str.find_last_not_of(white_space);
-        str.erase(location + 1);
+        return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
     }
 
-    void ObjMesh::MeshData::Clear()
+    static void SkipBlanks(const char*& p, const char* end)
     {
-        positions.clear();
-        normals.clear();
-        uvs.clear();
-        faces.clear();
-        tangents.clear();
+        while (p < end && IsBlank(*p))
+        {
+            ++p;
+        }
     }
 
-    void ObjMesh::MeshData::Center(BoundingBox& bounding_box)
+    static void SkipLine(const char*& p, const char* end)
+    {
+        const void* newline = std::memchr(p, '\n', end - p);
+        p = newline != nullptr ? static_cast<const char*>(newline) + 1 : end;
+    }
+
+    static bool ParseFloat(const char*& p, const char* end, float& value)
+    {
+        SkipBlanks(p, end);
+        // from_chars 不接受正号
+        if (p < end && *p == '+')
+        {
+            ++p;
+        }
+
+        std::from_chars_result result = std::from_chars(p, end, value);
+        if (result.ec != std::errc())
+        {
+            return false;
+        }
+        p = result.ptr;
+        return true;
+    }
+
+    static bool ParseInt(const char*& p, const char* end, int& value)
+    {
+        std::from_chars_result result = std::from_chars(p, end, value);
+        if (result.ec != std::errc())
+        {
+            return false;
+        }
+        p = result.ptr;
+        return true;
+    }
+
+    // OBJ 索引从 1 开始, 负数表示相对于当前已读取的数量, 这时在 relative_mask 中记下 flag
+    static int ResolveIndex(int index, size_t count, unsigned char flag, unsigned char& relative_mask)
+    {
+        if (index < 0)
+        {
+            relative_mask |= flag;
+            return index + static_cast<int>(count);
+        }
+        return index - 1;
+    }
+
+    // 文件小于这个大小的两倍时不分块
+    static const size_t s_min_chunk_size = 256 * 1024;
+
+    // 统计 OBJ 文件中各类元素的数量, 面按扇形拆分后的三角形顶点数计算, 用于一次预留容量
+    struct ObjElementCounts
+    {
+        size_t positions;
+        size_t normals;
+        size_t uvs;
+        size_t corners;
+    };
+
+    static ObjElementCounts CountObjElements(const char* p, const char* end)
+    {
+        ObjElementCounts counts = { 0, 0, 0, 0 };
+        while (p < end)
+        {
+            SkipBlanks(p, end);
+            const char* token = p;
+            while (p < end && !IsBlank(*p) && *p != '\n' && *p != '#')
+            {
+                ++p;
+            }
+            size_t token_length = p - token;
+
+            if (token_length == 1 && token[0] == 'v')
+            {
+                ++counts.positions;
+            }
+            else if (token_length == 2 && token[0] == 'v' && token[1] == 't')
+            {
+                ++counts.uvs;
+            }
+            else if (token_length == 2 && token[0] == 'v' && token[1] == 'n')
+            {
+                ++counts.normals;
+            }
+            else if (token_length == 1 && token[0] == 'f')
+            {
+                // n 个顶点的多边形拆成 n - 2 个三角形
+                size_t vertex_count = 0;
+                bool in_vertex = false;
+                for (; p < end && *p != '\n' && *p != '#'; ++p)
+                {
+                    bool blank = IsBlank(*p);
+                    if (!blank && !in_vertex)
+                    {
+                        ++vertex_count;
+                    }
+                    in_vertex = !blank;
+                }
+                if (vertex_count >= 3)
+                {
+                    counts.corners += (vertex_count - 2) * 3;
+                }
+            }
+
+            SkipLine(p, end);
+        }
+        return counts;
+    }
+
+    // ToMesh 去重用的开放寻址哈希表, 键是面顶点的 (位置, 法线, 纹理坐标) 索引,
+    // 容量按预计的不同顶点数分配, 超过一半时翻倍重建
+    class ObjVertexIndexTable
     {
-        if (positions.empty())
+    public:
+        ObjVertexIndexTable(size_t expected_count, std::pmr::memory_resource* resource)
+            : m_slots(resource),
+              m_mask(0),
+              m_count(0)
+        {
+            size_t capacity = 16;
+            while (capacity < expected_count * 2)
+            {
+                capacity *= 2;
+            }
+            Rehash(capacity);
+        }
+
+        // 已有相同的键时返回原来的值, 否则插入 value 并返回 value
+        GLuint FindOrInsert(int position_index, int normal_index, int uv_index, GLuint value)
+        {
+            Slot* slot = &FindSlot(position_index, normal_index, uv_index);
+            if (slot->value != s_empty)
+            {
+                return slot->value;
+            }
+
+            if ((m_count + 1) * 2 > m_slots.size())
+            {
+                Rehash(m_slots.size() * 2);
+                slot = &FindSlot(position_index, normal_index, uv_index);
+            }
+            *slot = Slot{ position_index, normal_index, uv_index, value };
+            ++m_count;
+            return value;
+        }
+
+        size_t GetCount() const
+        {
+            return m_count;
+        }
+
+        // 对每个插入的键调用 function(position_index, normal_index, uv_index, value)
+        template <typename Function>
+        void ForEach(Function function) const
+        {
+            for (const Slot& slot : m_slots)
+            {
+                if (slot.value != s_empty)
+                {
+                    function(slot.position_index, slot.normal_index, slot.uv_index, slot.value);
+                }
+            }
+        }
+
+    private:
+        struct Slot
+        {
+            int position_index;
+            int normal_index;
+            int uv_index;
+            GLuint value;
+        };
+
+        static const GLuint s_empty = 0xFFFFFFFF;
+
+        // 返回键所在的槽, 没有时返回探测到的第一个空槽
+        Slot& FindSlot(int position_index, int normal_index, int uv_index)
+        {
+            uint64_t hash = static_cast<uint32_t>(position_index) * 0x9E3779B97F4A7C15ull
+                ^ static_cast<uint32_t>(normal_index) * 0xC2B2AE3D27D4EB4Full
+                ^ static_cast<uint32_t>(uv_index) * 0x165667B19E3779F9ull;
+            hash ^= hash >> 32;
+
+            for (size_t i = static_cast<size_t>(hash) & m_mask; ; i = (i + 1) & m_mask)
+            {
+                Slot& slot = m_slots[i];
+                if (slot.value == s_empty ||
+                    (slot.position_index == position_index && slot.normal_index == normal_index && slot.uv_index == uv_index))
+                {
+                    return slot;
+                }
+            }
+        }
+
+        void Rehash(size_t capacity)
+        {
+            std::pmr::vector<Slot> slots(capacity, Slot{ 0, 0, 0, s_empty }, m_slots.get_allocator());
+            slots.swap(m_slots);
+            m_mask = capacity - 1;
+            for (const Slot& slot : slots)
+            {
+                if (slot.value != s_empty)
+                {
+                    FindSlot(slot.position_index, slot.normal_index, slot.uv_index) = slot;
+                }
+            }
+        }
+
+    private:
+        std::pmr::vector<Slot> m_slots;
+        size_t m_mask;
+        size_t m_count;
+    };
+
+    // 少于这个数量时不值得分给线程池
+    static const size_t s_min_parallel_count = 4096;
+
+    // 把 [0, count) 分成若干块交给 body, 有线程池并且数量足够多时并行处理
+    static void ForEachBlock(ThreadPool* pool, size_t count, const std::function<void(size_t, size_t)>& body)
+    {
+        if (pool == nullptr || count < s_min_parallel_count)
+        {
+            body(0, count);
+            return;
+        }
+
+        size_t block_count = (pool->GetThreadCount() + 1) * 4;
+        pool->ParallelFor(block_count, [&](size_t block)
+        {
+            body(count * block / block_count, count * (block + 1) / block_count);
+        });
+    }
+
+    // 法线和切线按三角形分段累加, 每段写自己的累加数组, 最后按顶点合并.
+    // 只有一段时与逐个三角形累加的结果完全相同, 段数只取决于线程数, 结果不随调度变化
+    static size_t GetAccumulateSliceCount(ThreadPool* pool, size_t triangle_count)
+    {
+        if (pool == nullptr)
+        {
+            return 1;
+        }
+        return std::max<size_t>(1, std::min<size_t>(pool->GetThreadCount() + 1, triangle_count / s_min_parallel_count));
+    }
+
+    static float ClampCosine(float value)
+    {
+        return std::min(std::max(value, -1.0f), 1.0f);
+    }
+
+#ifdef GLSL_SHADER_USE_SSE
+    // 读写两个 float, 数组元素只保证 4 字节对齐, 不能当作 double 访问
+    static __m128 LoadFloat2(const float* source)
+    {
+        return _mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(source)));
+    }
+
+    static void StoreFloat2(float* destination, __m128 value)
+    {
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(destination), _mm_castps_si128(value));
+    }
+
+    // 读取为 (x, y, z, 0), 不会读到数组末尾之后
+    static __m128 LoadVec3(const glm::vec3& v)
+    {
+        return _mm_movelh_ps(LoadFloat2(&v.x), _mm_load_ss(&v.z));
+    }
+
+    static void StoreVec3(glm::vec3& v, __m128 value)
+    {
+        StoreFloat2(&v.x, value);
+        _mm_store_ss(&v.z, _mm_movehl_ps(value, value));
+    }
+
+    // 取连续 4 个三角形第 k 个角的位置, 在寄存器中转置成 x, y, z 三组
+    template <typename Corner>
+    static void GatherPositions(const glm::vec3* positions, const Corner* corners, int k, __m128& x, __m128& y, __m128& z)
+    {
+        __m128 p0 = LoadVec3(positions[corners[k].position_index]);
+        __m128 p1 = LoadVec3(positions[corners[k + 3].position_index]);
+        __m128 p2 = LoadVec3(positions[corners[k + 6].position_index]);
+        __m128 p3 = LoadVec3(positions[corners[k + 9].position_index]);
+        _MM_TRANSPOSE4_PS(p0, p1, p2, p3);
+        x = p0;
+        y = p1;
+        z = p2;
+    }
+
+    template <typename Corner>
+    static void GatherUvs(const glm::vec2* uvs, const Corner* corners, int k, __m128& u, __m128& v)
+    {
+        __m128 uv0 = LoadFloat2(&uvs[corners[k].uv_index].x);
+        __m128 uv1 = LoadFloat2(&uvs[corners[k + 3].uv_index].x);
+        __m128 uv2 = LoadFloat2(&uvs[corners[k + 6].uv_index].x);
+        __m128 uv3 = LoadFloat2(&uvs[corners[k + 9].uv_index].x);
+        __m128 low = _mm_unpacklo_ps(uv0, uv1);
+        __m128 high = _mm_unpacklo_ps(uv2, uv3);
+        u = _mm_movelh_ps(low, high);
+        v = _mm_movehl_ps(high, low);
+    }
+
+    // 把 4 个三角形的 x, y, z 转置回每个三角形一个向量
+    static void Transpose(__m128 x, __m128 y, __m128 z, __m128 vectors[4])
+    {
+        vectors[0] = x;
+        vectors[1] = y;
+        vectors[2] = z;
+        vectors[3] = _mm_setzero_ps();
+        _MM_TRANSPOSE4_PS(vectors[0], vectors[1], vectors[2], vectors[3]);
+    }
+
+    static __m128 Dot(__m128 ax, __m128 ay, __m128 az, __m128 bx, __m128 by, __m128 bz)
+    {
+        return _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz));
+    }
+#endif
+
+    // 把 [begin, end) 中三角形的法线按权重累加到三个角的顶点上, 并把角的法线索引指向位置索引.
+    // SSE 一次算 4 个三角形, 剩下的逐个计算, 两种路径的运算顺序相同, 累加顺序与三角形顺序一致
+    template <typename Corner>
+    static void AccumulateFaceNormals
+    (
+        const glm::vec3* positions,
+        Corner* corners,
+        size_t begin,
+        size_t end,
+        ObjMesh::NormalWeighting weighting,
+        glm::vec3* normals
+    )
+    {
+        size_t t = begin;
+#ifdef GLSL_SHADER_USE_SSE
+        for (; t + 4 <= end; t += 4)
+        {
+            Corner* c = corners + t * 3;
+            __m128 x0, y0, z0, x1, y1, z1, x2, y2, z2;
+            GatherPositions(positions, c, 0, x0, y0, z0);
+            GatherPositions(positions, c, 1, x1, y1, z1);
+            GatherPositions(positions, c, 2, x2, y2, z2);
+            __m128 ax = _mm_sub_ps(x1, x0), ay = _mm_sub_ps(y1, y0), az = _mm_sub_ps(z1, z0);
+            __m128 bx = _mm_sub_ps(x2, x0), by = _mm_sub_ps(y2, y0), bz = _mm_sub_ps(z2, z0);
+
+            __m128 nx = _mm_sub_ps(_mm_mul_ps(ay, bz), _mm_mul_ps(by, az));
+            __m128 ny = _mm_sub_ps(_mm_mul_ps(az, bx), _mm_mul_ps(bz, ax));
+            __m128 nz = _mm_sub_ps(_mm_mul_ps(ax, by), _mm_mul_ps(bx, ay));
+            // 面积加权直接累加叉积, 叉积的长度是面积的两倍, 退化三角形的叉积为 0
+            __m128 length = _mm_sqrt_ps(Dot(nx, ny, nz, nx, ny, nz));
+            if (weighting != ObjMesh::NormalWeighting::Area)
+            {
+                __m128 inverse_length = _mm_div_ps(_mm_set1_ps(1.0f), length);
+                nx = _mm_mul_ps(nx, inverse_length);
+                ny = _mm_mul_ps(ny, inverse_length);
+                nz = _mm_mul_ps(nz, inverse_length);
+            }
+
+            __m128 weights[3] = { _mm_set1_ps(1.0f), _mm_set1_ps(1.0f), _mm_set1_ps(1.0f) };
+            if (weighting == ObjMesh::NormalWeighting::Angle)
+            {
+                // 第三条边 e = p2 - p1, 三个内角的余弦分别是 (a, b), (e, -a), (b, e) 的夹角余弦
+                __m128 ex = _mm_sub_ps(bx, ax), ey = _mm_sub_ps(by, ay), ez = _mm_sub_ps(bz, az);
+                __m128 length_a = _mm_sqrt_ps(Dot(ax, ay, az, ax, ay, az));
+                __m128 length_b = _mm_sqrt_ps(Dot(bx, by, bz, bx, by, bz));
+                __m128 length_e = _mm_sqrt_ps(Dot(ex, ey, ez, ex, ey, ez));
+                alignas(16) float cosines[3][4];
+                _mm_store_ps(cosines[0], _mm_div_ps(Dot(ax, ay, az, bx, by, bz), _mm_mul_ps(length_a, length_b)));
+                _mm_store_ps(cosines[1], _mm_div_ps(_mm_sub_ps(_mm_setzero_ps(), Dot(ex, ey, ez, ax, ay, az)), _mm_mul_ps(length_e, length_a)));
+                _mm_store_ps(cosines[2], _mm_div_ps(Dot(bx, by, bz, ex, ey, ez), _mm_mul_ps(length_b, length_e)));
+
+                // 退化三角形的法线和角度都是 NaN, 清零后不参与累加
+                __m128 valid = _mm_cmpgt_ps(length, _mm_setzero_ps());
+                nx = _mm_and_ps(valid, nx);
+                ny = _mm_and_ps(valid, ny);
+                nz = _mm_and_ps(valid, nz);
+                for (int k = 0; k < 3; ++k)
+                {
+                    weights[k] = _mm_and_ps(valid, _mm_setr_ps
+                    (
+                        std::acos(ClampCosine(cosines[k][0])),
+                        std::acos(ClampCosine(cosines[k][1])),
+                        std::acos(ClampCosine(cosines[k][2])),
+                        std::acos(ClampCosine(cosines[k][3]))
+                    ));
+                }
+            }
+
+            __m128 weighted[3][4];
+            for (int k = 0; k < 3; ++k)
+            {
+                Transpose(_mm_mul_ps(weights[k], nx), _mm_mul_ps(weights[k], ny), _mm_mul_ps(weights[k], nz), weighted[k]);
+            }
+
+            // 按三角形顺序累加, 保证与逐个计算的结果相同
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                for (int k = 0; k < 3; ++k)
+                {
+                    Corner& corner = c[lane * 3 + k];
+                    glm::vec3& normal = normals[corner.position_index];
+                    StoreVec3(normal, _mm_add_ps(LoadVec3(normal), weighted[k][lane]));
+                    corner.normal_index = corner.position_index;
+                }
+            }
+        }
+#endif
+
+        for (; t < end; ++t)
+        {
+            Corner* c = corners + t * 3;
+            const glm::vec3& p0 = positions[c[0].position_index];
+            const glm::vec3& p1 = positions[c[1].position_index];
+            const glm::vec3& p2 = positions[c[2].position_index];
+            float ax = p1.x - p0.x, ay = p1.y - p0.y, az = p1.z - p0.z;
+            float bx = p2.x - p0.x, by = p2.y - p0.y, bz = p2.z - p0.z;
+
+            float nx = ay * bz - by * az;
+            float ny = az * bx - bz * ax;
+            float nz = ax * by - bx * ay;
+            float length = std::sqrt(nx * nx + ny * ny + nz * nz);
+            glm::vec3 n(nx, ny, nz);
+            if (weighting != ObjMesh::NormalWeighting::Area)
+            {
+                float inverse_length = 1.0f / length;
+                n = glm::vec3(nx * inverse_length, ny * inverse_length, nz * inverse_length);
+            }
+
+            float weights[3] = { 1.0f, 1.0f, 1.0f };
+            if (weighting == ObjMesh::NormalWeighting::Angle)
+            {
+                float ex = bx - ax, ey = by - ay, ez = bz - az;
+                float length_a = std::sqrt(ax * ax + ay * ay + az * az);
+                float length_b = std::sqrt(bx * bx + by * by + bz * bz);
+                float length_e = std::sqrt(ex * ex + ey * ey + ez * ez);
+                weights[0] = std::acos(ClampCosine((ax * bx + ay * by + az * bz) / (length_a * length_b)));
+                weights[1] = std::acos(ClampCosine((0.0f - (ex * ax + ey * ay + ez * az)) / (length_e * length_a)));
+                weights[2] = std::acos(ClampCosine((bx * ex + by * ey + bz * ez) / (length_b * length_e)));
+                if (!(length > 0.0f))
+                {
+                    n = glm::vec3(0.0f);
+                    weights[0] = weights[1] = weights[2] = 0.0f;
+                }
+            }
+
+            for (int k = 0; k < 3; ++k)
+            {
+                normals[c[k].position_index] += weights[k] * n;
+                c[k].normal_index = c[k].position_index;
+            }
+        }
+    }
+
+    // 把 [begin, end) 中三角形沿纹理坐标 s 和 t 方向的切线累加到三个角的顶点上
+    template <typename Corner>
+    static void AccumulateFaceTangents
+    (
+        const glm::vec3* positions,
+        const glm::vec2* uvs,
+        const Corner* corners,
+        size_t begin,
+        size_t end,
+        glm::vec3* s_tangents,
+        glm::vec3* t_tangents
+    )
+    {
+        size_t t = begin;
+#ifdef GLSL_SHADER_USE_SSE
+        for (; t + 4 <= end; t += 4)
+        {
+            const Corner* c = corners + t * 3;
+            __m128 x0, y0, z0, x1, y1, z1, x2, y2, z2;
+            GatherPositions(positions, c, 0, x0, y0, z0);
+            GatherPositions(positions, c, 1, x1, y1, z1);
+            GatherPositions(positions, c, 2, x2, y2, z2);
+            __m128 q1x = _mm_sub_ps(x1, x0), q1y = _mm_sub_ps(y1, y0), q1z = _mm_sub_ps(z1, z0);
+            __m128 q2x = _mm_sub_ps(x2, x0), q2y = _mm_sub_ps(y2, y0), q2z = _mm_sub_ps(z2, z0);
+
+            __m128 u0, v0, u1, v1, u2, v2;
+            GatherUvs(uvs, c, 0, u0, v0);
+            GatherUvs(uvs, c, 1, u1, v1);
+            GatherUvs(uvs, c, 2, u2, v2);
+            __m128 s1 = _mm_sub_ps(u1, u0), s2 = _mm_sub_ps(u2, u0);
+            __m128 t1 = _mm_sub_ps(v1, v0), t2 = _mm_sub_ps(v2, v0);
+            __m128 r = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sub_ps(_mm_mul_ps(s1, t2), _mm_mul_ps(s2, t1)));
+
+            __m128 tan1[4];
+            __m128 tan2[4];
+            Transpose
+            (
+                _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(t2, q1x), _mm_mul_ps(t1, q2x)), r),
+                _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(t2, q1y), _mm_mul_ps(t1, q2y)), r),
+                _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(t2, q1z), _mm_mul_ps(t1, q2z)), r),
+                tan1
+            );
+            Transpose
+            (
+                _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(s1, q2x), _mm_mul_ps(s2, q1x)), r),
+                _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(s1, q2y), _mm_mul_ps(s2, q1y)), r),
+                _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(s1, q2z), _mm_mul_ps(s2, q1z)), r),
+                tan2
+            );
+
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                for (int k = 0; k < 3; ++k)
+                {
+                    GLuint index = c[lane * 3 + k].position_index;
+                    StoreVec3(s_tangents[index], _mm_add_ps(LoadVec3(s_tangents[index]), tan1[lane]));
+                    StoreVec3(t_tangents[index], _mm_add_ps(LoadVec3(t_tangents[index]), tan2[lane]));
+                }
+            }
+        }
+#endif
+
+        for (; t < end; ++t)
+        {
+            const Corner* c = corners + t * 3;
+            glm::vec3 q1 = positions[c[1].position_index] - positions[c[0].position_index];
+            glm::vec3 q2 = positions[c[2].position_index] - positions[c[0].position_index];
+            const glm::vec2& tc1 = uvs[c[0].uv_index];
+            const glm::vec2& tc2 = uvs[c[1].uv_index];
+            const glm::vec2& tc3 = uvs[c[2].uv_index];
+            float s1 = tc2.x - tc1.x, s2 = tc3.x - tc1.x;
+            float t1 = tc2.y - tc1.y, t2 = tc3.y - tc1.y;
+            float r = 1.0f / (s1 * t2 - s2 * t1);
+            glm::vec3 tan1
+            (
+                (t2 * q1.x - t1 * q2.x) * r,
+                (t2 * q1.y - t1 * q2.y) * r,
+                (t2 * q1.z - t1 * q2.z) * r
+            );
+            glm::vec3 tan2
+            (
+                (s1 * q2.x - s2 * q1.x) * r,
+                (s1 * q2.y - s2 * q1.y) * r,
+                (s1 * q2.z - s2 * q1.z) * r
+            );
+            for (int k = 0; k < 3; ++k)
+            {
+                s_tangents[c[k].position_index] += tan1;
+                t_tangents[c[k].position_index] += tan2;
+            }
+        }
+    }
+
+    // MeshData 和 CompactMeshData 共用的部分, position_count 是 float 的个数
+    static void CenterPositions(GLfloat* positions, size_t position_count, BoundingBox& bounding_box)
+    {
+        if (position_count == 0)
         {
             return;
         }
 
         glm::vec3 center = 0.5f * (bounding_box.max + bounding_box.min);
 
-        for (int i = 0; i < positions.size(); i += 3)
+        for (size_t i = 0; i < position_count; i += 3)
         {
             positions[i] -= center.x;
             positions[i + 1] -= center.y;
@@ -44,7 +600,177 @@ namespace glsl_shader
         bounding_box.min = bounding_box.min - center;
     }
 
-    void ObjMesh::MeshData::ConvertFacesToAdjancencyFormat()
+    template <typename Data>
+    static MeshView MakeMeshView(const Data& data)
+    {
+        MeshView view =
+        {
+            data.positions.size() / 3,
+            data.positions.data(),
+            data.normals.data(),
+            data.uvs.empty() ? nullptr : data.uvs.data(),
+            data.tangents.empty() ? nullptr : data.tangents.data(),
+            data.faces.size(),
+            GL_UNSIGNED_INT,
+            data.faces.data()
+        };
+        return view;
+    }
+
+    void ObjMesh::MeshData::Clear()
+    {
+        positions.clear();
+        normals.clear();
+        uvs.clear();
+        faces.clear();
+        tangents.clear();
+    }
+
+    void ObjMesh::MeshData::Center(BoundingBox& bounding_box)
+    {
+        CenterPositions(positions.data(), positions.size(), bounding_box);
+    }
+
+    MeshView ObjMesh::MeshData::GetView() const
+    {
+        return MakeMeshView(*this);
+    }
+
+    ObjMesh::CompactMeshData::CompactMeshData(std::pmr::memory_resource* resource)
+        : positions(resource),
+          normals(resource),
+          uvs(resource),
+          faces(resource),
+          tangents(resource)
+    {
+
+    }
+
+    void ObjMesh::CompactMeshData::Clear()
+    {
+        positions.clear();
+        normals.clear();
+        uvs.clear();
+        faces.clear();
+        tangents.clear();
+    }
+
+    void ObjMesh::CompactMeshData::Center(BoundingBox& bounding_box)
+    {
+        CenterPositions(positions.data(), positions.size(), bounding_box);
+    }
+
+    MeshView ObjMesh::CompactMeshData::GetView() const
+    {
+        return MakeMeshView(*this);
+    }
+
+    void ObjMesh::MeshData::ConvertFacesToAdjancencyFormat(ThreadPool* pool)
+    {
+        std::vector<GLuint> index_adj(faces.size() * 2);
+        size_t triangle_count = faces.size() / 3;
+
+        GLuint vertex_count = 0;
+        for (GLuint i = 0; i < faces.size(); i += 3)
+        {
+            index_adj[i * 2 + 0] = faces[i];
+            index_adj[i * 2 + 1] = std::numeric_limits<GLuint>::max();
+            index_adj[i * 2 + 2] = faces[i + 1];
+            index_adj[i * 2 + 3] = std::numeric_limits<GLuint>::max();
+            index_adj[i * 2 + 4] = faces[i + 2];
+            index_adj[i * 2 + 5] = std::numeric_limits<GLuint>::max();
+            vertex_count = std::max({ vertex_count, faces[i] + 1, faces[i + 1] + 1, faces[i + 2] + 1 });
+        }
+
+        // 边 k 是三角形 k / 3 的第 k % 3 条边 (v[k % 3], v[(k + 1) % 3]), 对边顶点是 v[(k + 2) % 3].
+        // 按较小的端点计数排序把所有边分桶, 同一个桶内的边按三角形顺序排列
+        std::vector<GLuint> bucket_offsets(vertex_count + 1, 0);
+        for (size_t k = 0; k < faces.size(); ++k)
+        {
+            GLuint v0 = faces[k];
+            GLuint v1 = faces[k - k % 3 + (k + 1) % 3];
+            ++bucket_offsets[std::min(v0, v1) + 1];
+        }
+        for (GLuint v = 0; v < vertex_count; ++v)
+        {
+            bucket_offsets[v + 1] += bucket_offsets[v];
+        }
+
+        std::vector<GLuint> bucket_edges(faces.size());
+        std::vector<GLuint> fill_offsets(bucket_offsets.begin(), bucket_offsets.end() - 1);
+        for (size_t k = 0; k < faces.size(); ++k)
+        {
+            GLuint v0 = faces[k];
+            GLuint v1 = faces[k - k % 3 + (k + 1) % 3];
+            bucket_edges[fill_offsets[std::min(v0, v1)]++] = static_cast<GLuint>(k);
+        }
+
+        // 与原来两两比较的结果保持一致: 共享同一条边的三角形中, 优先取后面最后一个, 没有时取前面最后一个
+        std::function<void(size_t)> resolve_bucket = [&](size_t v)
+        {
+            for (GLuint e = bucket_offsets[v]; e < bucket_offsets[v + 1]; ++e)
+            {
+                GLuint edge = bucket_edges[e];
+                GLuint triangle = edge / 3;
+                GLuint other = std::max(faces[edge], faces[edge - edge % 3 + (edge + 1) % 3]);
+
+                GLuint match = std::numeric_limits<GLuint>::max();
+                for (GLuint f = bucket_offsets[v]; f < bucket_offsets[v + 1]; ++f)
+                {
+                    GLuint candidate = bucket_edges[f];
+                    GLuint candidate_triangle = candidate / 3;
+                    if (candidate_triangle == triangle || std::max(faces[candidate], faces[candidate - candidate % 3 + (candidate + 1) % 3]) != other)
+                    {
+                        continue;
+                    }
+
+                    if (candidate_triangle > triangle || match == std::numeric_limits<GLuint>::max() || match / 3 < triangle)
+                    {
+                        match = candidate;
+                    }
+                }
+
+                if (match != std::numeric_limits<GLuint>::max())
+                {
+                    index_adj[triangle * 6 + (edge % 3) * 2 + 1] = faces[match - match % 3 + (match + 2) % 3];
+                }
+            }
+        };
+
+        // 每个桶只写自己的边, 可以并行
+        if (pool != nullptr && triangle_count >= 4096)
+        {
+            size_t block_count = (pool->GetThreadCount() + 1) * 4;
+            pool->ParallelFor(block_count, [&](size_t block)
+            {
+                size_t begin = vertex_count * block / block_count;
+                size_t end = vertex_count * (block + 1) / block_count;
+                for (size_t v = begin; v < end; ++v)
+                {
+                    resolve_bucket(v);
+                }
+            });
+        }
+        else
+        {
+            for (size_t v = 0; v < vertex_count; ++v)
+            {
+                resolve_bucket(v);
+            }
+        }
+
+        for (GLuint i = 0; i < index_adj.size(); i += 6)
+        {
+            if (index_adj[i + 1] == std::numeric_limits<GLuint>::max()) index_adj[i + 1] = index_adj[i + 4];
+            if (index_adj[i + 3] == std::numeric_limits<GLuint>::max()) index_adj[i + 3] = index_adj[i];
+            if (index_adj[i + 5] == std::numeric_limits<GLuint>::max()) index_adj[i + 5] = index_adj[i + 2];
+        }
+
+        faces = index_adj;
+    }
+
+    // 逐对比较所有三角形, O(n²), 是原来的实现, 保留下来作为 ConvertFacesToAdjancencyFormat 的参考
+    void ObjMesh::MeshData::ConvertFacesToAdjancencyFormatReference()
     {
         std::vector<GLuint> index_adj(faces.size() * 2);
 
@@ -139,287 +865,538 @@ namespace glsl_shader
     ObjMesh::ObjMeshData::ObjVertex::ObjVertex()
         : position_index(-1),
           normal_index(-1),
-          uv_index(-1)
+          uv_index(-1),
+          relative_mask(0)
     {
 
     }
 
-    ObjMesh::ObjMeshData::ObjVertex::ObjVertex(std::string& vertex_string, ObjMesh::ObjMeshData* mesh)
-        : position_index(-1),
-          normal_index(-1),
-          uv_index(-1)
+    bool ObjMesh::ObjMeshData::ObjVertex::Parse(const char*& p, const char* end, const ObjMeshData& mesh)
     {
-        size_t slash1 = 0;
-        size_t slash2 = 0;
-        slash1 = vertex_string.find("/");
-        position_index = std::stoi(vertex_string.substr(0, slash1));
-        if (position_index < 0)
-        {
-            position_index += mesh->positions.size();
-        }
-        else
+        position_index = -1;
+        normal_index = -1;
+        uv_index = -1;
+        relative_mask = 0;
+
+        SkipBlanks(p, end);
+        int index = 0;
+        if (!ParseInt(p, end, index))
         {
-            --position_index;
+            return false;
         }
+        position_index = ResolveIndex(index, mesh.positions.size(), RELATIVE_POSITION, relative_mask);
 
-        if (slash1 != std::string::npos)
+        if (p < end && *p == '/')
         {
-            slash2 = vertex_string.find("/", slash1 + 1);
-            if (slash2 > slash1 + 1)
+            ++p;
+            if (p < end && *p != '/' && ParseInt(p, end, index))
             {
-                uv_index = std::stoi(vertex_string.substr(slash1 + 1, slash2 - slash1 - 1));
-                if (uv_index < 0)
-                {
-                    uv_index += mesh->uvs.size();
-                }
-                else
-                {
-                    --uv_index;
-                }
+                uv_index = ResolveIndex(index, mesh.uvs.size(), RELATIVE_UV, relative_mask);
             }
 
-            normal_index = std::stoi(vertex_string.substr(slash2 + 1));
-            if (normal_index < 0)
+            if (p < end && *p == '/')
             {
-                normal_index += mesh->normals.size();
-            }
-            else
-            {
-                --normal_index;
+                ++p;
+                if (ParseInt(p, end, index))
+                {
+                    normal_index = ResolveIndex(index, mesh.normals.size(), RELATIVE_NORMAL, relative_mask);
+                }
             }
         }
-    }
 
-    std::string ObjMesh::ObjMeshData::ObjVertex::ToString()
-    {
-        return std::to_string(position_index) + "/" + std::to_string(normal_index) + "/" + std::to_string(uv_index);
+        return true;
     }
 
-    ObjMesh::ObjMeshData::ObjMeshData()
+    ObjMesh::ObjMeshData::ObjMeshData(std::pmr::memory_resource* resource)
+        : positions(resource),
+          normals(resource),
+          uvs(resource),
+          faces(resource),
+          tangents(resource)
     {
 
     }
 
-    void ObjMesh::ObjMeshData::GenerateNormalsIfNeeded()
+    void ObjMesh::ObjMeshData::GenerateNormalsIfNeeded(NormalWeighting weighting, ThreadPool* pool)
     {
-        if (normals.size() != 0)
+        // 文件中的法线排在前面, 生成的法线追加在后面; 只有部分面顶点带法线时 (例如 f v//vn 与 f v 混用),
+        // 先记下文件中的法线索引, 生成后只有缺少法线的面顶点指向生成的法线
+        size_t file_normal_count = normals.size();
+        std::vector<int> file_normal_indices;
+        if (file_normal_count != 0)
         {
-            return;
+            if (std::none_of(faces.begin(), faces.end(), [](const ObjVertex& vertex) { return vertex.normal_index < 0; }))
+            {
+                return;
+            }
+            file_normal_indices.reserve(faces.size());
+            for (const ObjVertex& vertex : faces)
+            {
+                file_normal_indices.push_back(vertex.normal_index);
+            }
         }
 
-        normals.resize(positions.size());
+        size_t vertex_count = positions.size();
+        size_t triangle_count = faces.size() / 3;
+        normals.resize(file_normal_count + vertex_count);
+        glm::vec3* generated_normals = normals.data() + file_normal_count;
 
-        for (GLuint i = 0; i < faces.size(); i += 3)
+        // 第一段直接累加到 normals 中
+        size_t slice_count = GetAccumulateSliceCount(pool, triangle_count);
+        std::vector<std::vector<glm::vec3>> slice_normals(slice_count - 1);
+        std::function<void(size_t)> accumulate_slice = [&](size_t slice)
         {
-            const glm::vec3& p1 = positions[faces[i].position_index];
-            const glm::vec3& p2 = positions[faces[i + 1].position_index];
-            const glm::vec3& p3 = positions[faces[i + 2].position_index];
+            glm::vec3* accumulator = generated_normals;
+            if (slice > 0)
+            {
+                slice_normals[slice - 1].resize(vertex_count);
+                accumulator = slice_normals[slice - 1].data();
+            }
+            size_t begin = triangle_count * slice / slice_count;
+            size_t end = triangle_count * (slice + 1) / slice_count;
+            AccumulateFaceNormals(positions.data(), faces.data(), begin, end, weighting, accumulator);
+        };
 
-            glm::vec3 a = p2 - p1;
-            glm::vec3 b = p3 - p1;
-            glm::vec3 n = glm::normalize(glm::cross(a, b));
+        if (slice_count > 1)
+        {
+            pool->ParallelFor(slice_count, accumulate_slice);
+        }
+        else
+        {
+            accumulate_slice(0);
+        }
 
-            normals[faces[i].position_index] += n;
-            normals[faces[i + 1].position_index] += n;
-            normals[faces[i + 2].position_index] += n;
+        ForEachBlock(pool, vertex_count, [&](size_t begin, size_t end)
+        {
+            for (size_t v = begin; v < end; ++v)
+            {
+                glm::vec3 normal = generated_normals[v];
+                for (const std::vector<glm::vec3>& slice : slice_normals)
+                {
+                    normal += slice[v];
+                }
+                generated_normals[v] = glm::normalize(normal);
+            }
+        });
 
-            faces[i].normal_index = faces[i].position_index;
-            faces[i + 1].normal_index = faces[i + 1].position_index;
-            faces[i + 2].normal_index = faces[i + 2].position_index;
+        if (file_normal_count != 0)
+        {
+            for (size_t i = 0; i < faces.size(); ++i)
+            {
+                int file_normal_index = file_normal_indices[i];
+                faces[i].normal_index = file_normal_index >= 0 ? file_normal_index : static_cast<int>(file_normal_count) + faces[i].position_index;
+            }
+        }
+    }
+
+    void ObjMesh::ObjMeshData::FillMissingUvs()
+    {
+        if (uvs.empty() || std::none_of(faces.begin(), faces.end(), [](const ObjVertex& vertex) { return vertex.uv_index < 0; }))
+        {
+            return;
         }
 
-        for (GLuint i = 0; i < normals.size(); ++i)
+        int zero_uv_index = static_cast<int>(uvs.size());
+        uvs.push_back(glm::vec2(0.0f));
+        for (ObjVertex& vertex : faces)
         {
-            normals[i] = glm::normalize(normals[i]);
+            if (vertex.uv_index < 0)
+            {
+                vertex.uv_index = zero_uv_index;
+            }
         }
     }
 
-    void ObjMesh::ObjMeshData::GenerateTangents()
+    void ObjMesh::ObjMeshData::GenerateTangents(ThreadPool* pool)
     {
-        std::vector<glm::vec3> tan1_accum(positions.size());
-        std::vector<glm::vec3> tan2_accum(positions.size());
-        tangents.resize(positions.size());
+        // 没有纹理坐标时无法确定切线方向
+        if (uvs.empty())
+        {
+            return;
+        }
 
-        for (GLuint i = 0; i < faces.size(); i += 3)
+        size_t vertex_count = positions.size();
+        size_t triangle_count = faces.size() / 3;
+        tangents.resize(vertex_count);
+
+        // 第一段累加到与模型数据同一个 memory_resource 的数组中, 其它段各自分配
+        size_t slice_count = GetAccumulateSliceCount(pool, triangle_count);
+        std::pmr::vector<glm::vec3> tan1_accum(vertex_count, positions.get_allocator());
+        std::pmr::vector<glm::vec3> tan2_accum(vertex_count, positions.get_allocator());
+        std::vector<std::vector<glm::vec3>> slice_tan1_accum(slice_count - 1);
+        std::vector<std::vector<glm::vec3>> slice_tan2_accum(slice_count - 1);
+        std::function<void(size_t)> accumulate_slice = [&](size_t slice)
         {
-            const glm::vec3& p1 = positions[faces[i].position_index];
-            const glm::vec3& p2 = positions[faces[i + 1].position_index];
-            const glm::vec3& p3 = positions[faces[i + 2].position_index];
+            glm::vec3* tan1 = tan1_accum.data();
+            glm::vec3* tan2 = tan2_accum.data();
+            if (slice > 0)
+            {
+                slice_tan1_accum[slice - 1].resize(vertex_count);
+                slice_tan2_accum[slice - 1].resize(vertex_count);
+                tan1 = slice_tan1_accum[slice - 1].data();
+                tan2 = slice_tan2_accum[slice - 1].data();
+            }
+            size_t begin = triangle_count * slice / slice_count;
+            size_t end = triangle_count * (slice + 1) / slice_count;
+            AccumulateFaceTangents(positions.data(), uvs.data(), faces.data(), begin, end, tan1, tan2);
+        };
 
-            const glm::vec2& tc1 = uvs[faces[i].uv_index];
-            const glm::vec2& tc2 = uvs[faces[i + 1].uv_index];
-            const glm::vec2& tc3 = uvs[faces[i + 2].uv_index];
+        if (slice_count > 1)
+        {
+            pool->ParallelFor(slice_count, accumulate_slice);
+        }
+        else
+        {
+            accumulate_slice(0);
+        }
 
-            glm::vec3 q1 = p2 - p1;
-            glm::vec3 q2 = p3 - p1;
-            float s1 = tc2.x - tc1.x, s2 = tc3.x - tc1.x;
-            float t1 = tc2.y - tc1.y, t2 = tc3.y - tc1.y;
-            float r = 1.0f / (s1 * t2 - s2 * t1);
-            glm::vec3 tan1
-            (
-                (t2 * q1.x - t1 * q2.x) * r,
-                (t2 * q1.y - t1 * q2.y) * r,
-                (t2 * q1.z - t1 * q2.z) * r
-            );
-            glm::vec3 tan2
-            (
-                (s1 * q2.x - s2 * q1.x) * r,
-                (s1 * q2.y - s2 * q1.y) * r,
-                (s1 * q2.z - s2 * q1.z) * r
-            );
-            tan1_accum[faces[i].position_index] += tan1;
-            tan1_accum[faces[i + 1].position_index] += tan1;
-            tan1_accum[faces[i + 2].position_index] += tan1;
-            tan2_accum[faces[i].position_index] += tan2;
-            tan2_accum[faces[i + 1].position_index] += tan2;
-            tan2_accum[faces[i + 2].position_index] += tan2;
+        ForEachBlock(pool, vertex_count, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                glm::vec3 t1 = tan1_accum[i];
+                glm::vec3 t2 = tan2_accum[i];
+                for (size_t slice = 1; slice < slice_count; ++slice)
+                {
+                    t1 += slice_tan1_accum[slice - 1][i];
+                    t2 += slice_tan2_accum[slice - 1][i];
+                }
+
+                const glm::vec3& n = normals[i];
+                tangents[i] = glm::vec4(glm::normalize(t1 - (glm::dot(n, t1) * n)), 0.0f);
+                tangents[i].w = (glm::dot(glm::cross(n, t1), t2) < 0.0f) ? -1.0f : 1.0f;
+            }
+        });
+    }
+
+    size_t ObjMesh::ObjMeshData::Load(const char* filename, BoundingBox& bounding_box, ThreadPool* pool, bool reserve)
+    {
+        MappedFile obj_file;
+        if (!obj_file.Open(filename))
+        {
+            throw std::runtime_error(std::string("打开 .obj 文件失败: ") + filename);
         }
 
-        for (GLuint i = 0; i < positions.size(); ++i)
+        bounding_box.Reset();
+
+        const char* data = obj_file.GetData();
+        size_t size = obj_file.GetSize();
+
+        // 每个线程分几块, 解析快慢不同时可以互相补上
+        size_t chunk_count = 1;
+        if (pool != nullptr && !reserve)
         {
-            const glm::vec3& n = normals[i];
-            glm::vec3& t1 = tan1_accum[i];
-            glm::vec3& t2 = tan2_accum[i];
+            chunk_count = std::min<size_t>((pool->GetThreadCount() + 1) * 4, size / s_min_chunk_size);
+        }
 
-            tangents[i] = glm::vec4(glm::normalize(t1 - (glm::dot(n, t1) * n)), 0.0f);
-            tangents[i].w = (glm::dot(glm::cross(n, t1), t2) < 0.0f) ? -1.0f : 1.0f;
+        if (chunk_count <= 1)
+        {
+            if (reserve)
+            {
+                ObjElementCounts counts = CountObjElements(data, data + size);
+                positions.reserve(counts.positions);
+                normals.reserve(counts.normals);
+                uvs.reserve(counts.uvs);
+                faces.reserve(counts.corners);
+            }
+            ParseChunk(data, data + size, bounding_box);
+            FillMissingUvs();
+            return size;
         }
-    }
 
-    void ObjMesh::ObjMeshData::Load(const char* filename, BoundingBox& bounding_box)
-    {
-        std::ifstream obj_file(filename, std::ios::in);
+        // 在换行处切分, 每块只包含完整的行
+        std::vector<const char*> chunk_begins(chunk_count + 1);
+        chunk_begins[0] = data;
+        chunk_begins[chunk_count] = data + size;
+        for (size_t i = 1; i < chunk_count; ++i)
+        {
+            const char* p = std::max(data + size * i / chunk_count, chunk_begins[i - 1]);
+            SkipLine(p, data + size);
+            chunk_begins[i] = p;
+        }
 
-        if (!obj_file.is_open())
+        std::vector<ObjMeshData> chunks(chunk_count);
+        std::vector<BoundingBox> chunk_bounding_boxes(chunk_count);
+        pool->ParallelFor(chunk_count, [&](size_t i)
         {
-            std::cerr << "打开 .obj 文件失败: " << filename << std::endl;
-            std::exit(1);
+            chunks[i].ParseChunk(chunk_begins[i], chunk_begins[i + 1], chunk_bounding_boxes[i]);
+        });
+
+        // 前缀和得到每块在合并后数组中的起始位置
+        std::vector<size_t> position_offsets(chunk_count + 1, 0);
+        std::vector<size_t> normal_offsets(chunk_count + 1, 0);
+        std::vector<size_t> uv_offsets(chunk_count + 1, 0);
+        std::vector<size_t> face_offsets(chunk_count + 1, 0);
+        for (size_t i = 0; i < chunk_count; ++i)
+        {
+            position_offsets[i + 1] = position_offsets[i] + chunks[i].positions.size();
+            normal_offsets[i + 1] = normal_offsets[i] + chunks[i].normals.size();
+            uv_offsets[i + 1] = uv_offsets[i] + chunks[i].uvs.size();
+            face_offsets[i + 1] = face_offsets[i] + chunks[i].faces.size();
+            bounding_box.Add(chunk_bounding_boxes[i]);
         }
 
-        bounding_box.Reset();
-        std::string line;
-        std::string token;
-        std::getline(obj_file, line);
-        while (!obj_file.eof())
+        positions.resize(position_offsets[chunk_count]);
+        normals.resize(normal_offsets[chunk_count]);
+        uvs.resize(uv_offsets[chunk_count]);
+        faces.resize(face_offsets[chunk_count]);
+
+        // 块内的负数索引只相对于块内的数量, 加上之前所有块的数量后与顺序解析的结果一致
+        pool->ParallelFor(chunk_count, [&](size_t i)
         {
-            size_t pos = line.find_first_of("#");
-            if (pos != std::string::npos)
+            const ObjMeshData& chunk = chunks[i];
+            std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + position_offsets[i]);
+            std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + normal_offsets[i]);
+            std::copy(chunk.uvs.begin(), chunk.uvs.end(), uvs.begin() + uv_offsets[i]);
+
+            std::pmr::vector<ObjVertex>::iterator destination = faces.begin() + face_offsets[i];
+            for (const ObjVertex& vertex : chunk.faces)
             {
-                line = line.substr(0, pos);
+                *destination = vertex;
+                if (vertex.relative_mask != 0)
+                {
+                    if (vertex.relative_mask & ObjVertex::RELATIVE_POSITION)
+                    {
+                        destination->position_index += static_cast<int>(position_offsets[i]);
+                    }
+                    if (vertex.relative_mask & ObjVertex::RELATIVE_NORMAL)
+                    {
+                        destination->normal_index += static_cast<int>(normal_offsets[i]);
+                    }
+                    if (vertex.relative_mask & ObjVertex::RELATIVE_UV)
+                    {
+                        destination->uv_index += static_cast<int>(uv_offsets[i]);
+                    }
+                }
+                ++destination;
             }
-            trim_string(line);
+        });
 
-            if (line.length() > 0)
-            {
-                std::istringstream line_stream(line);
+        FillMissingUvs();
+        return size;
+    }
 
-                line_stream >> token;
+    void ObjMesh::ObjMeshData::ParseChunk(const char* begin, const char* end, BoundingBox& bounding_box)
+    {
+        const char* p = begin;
+        while (p < end)
+        {
+            SkipBlanks(p, end);
+            const char* token = p;
+            while (p < end && !IsBlank(*p) && *p != '\n' && *p != '#')
+            {
+                ++p;
+            }
+            size_t token_length = p - token;
 
-                if (token == "v")
-                {
-                    float x = 0.0f;
-                    float y = 0.0f;
-                    float z = 0.0f;
-                    line_stream >> x >> y >> z;
-                    glm::vec3 p(x, y, z);
-                    positions.push_back(p);
-                    bounding_box.Add(p);
-                }
-                else if (token == "vt")
-                {
-                    float s = 0.0f;
-                    float t = 0.0f;
-                    line_stream >> s >> t;
-                    uvs.push_back(glm::vec2(s, t));
-                }
-                else if (token == "vn")
-                {
-                    float x = 0.0f;
-                    float y = 0.0f;
-                    float z = 0.0f;
-                    line_stream >> x >> y >> z;
-                    normals.push_back(glm::vec3(x, y, z));
-                }
-                else if (token == "f")
+            if (token_length == 1 && token[0] == 'v')
+            {
+                glm::vec3 position(0.0f);
+                ParseFloat(p, end, position.x);
+                ParseFloat(p, end, position.y);
+                ParseFloat(p, end, position.z);
+                positions.push_back(position);
+                bounding_box.Add(position);
+            }
+            else if (token_length == 2 && token[0] == 'v' && token[1] == 't')
+            {
+                glm::vec2 uv(0.0f);
+                ParseFloat(p, end, uv.x);
+                ParseFloat(p, end, uv.y);
+                uvs.push_back(uv);
+            }
+            else if (token_length == 2 && token[0] == 'v' && token[1] == 'n')
+            {
+                glm::vec3 normal(0.0f);
+                ParseFloat(p, end, normal.x);
+                ParseFloat(p, end, normal.y);
+                ParseFloat(p, end, normal.z);
+                normals.push_back(normal);
+            }
+            else if (token_length == 1 && token[0] == 'f')
+            {
+                // 多边形按扇形拆分为三角形, 边解析边输出
+                ObjVertex first_vertex;
+                ObjVertex previous_vertex;
+                ObjVertex vertex;
+                int vertex_count = 0;
+                while (vertex.Parse(p, end, *this))
                 {
-                    std::vector<std::string> parts;
-                    while (line_stream.good())
+                    if (vertex_count == 0)
                     {
-                        std::string s;
-                        line_stream >> s;
-                        parts.push_back(s);
+                        first_vertex = vertex;
                     }
-
-                    if (parts.size() > 2)
+                    else if (vertex_count >= 2)
                     {
-                        ObjVertex first_vertex(parts[0], this);
-                        for (int i = 2; i < parts.size(); i++)
-                        {
-                            faces.push_back(first_vertex);
-                            faces.push_back(ObjVertex(parts[i - 1], this));
-                            faces.push_back(ObjVertex(parts[i], this));
-                        }
+                        faces.push_back(first_vertex);
+                        faces.push_back(previous_vertex);
+                        faces.push_back(vertex);
                     }
+                    previous_vertex = vertex;
+                    ++vertex_count;
                 }
             }
-            std::getline(obj_file, line);
+
+            SkipLine(p, end);
         }
-        obj_file.close();
     }
 
-    void ObjMesh::ObjMeshData::ToMesh(MeshData& data)
+    template <typename Data>
+    void ObjMesh::ObjMeshData::ToMesh(Data& data)
     {
         data.Clear();
 
-        std::unordered_map<std::string, GLuint> vertex_map;
-        for (ObjVertex& vertex : faces)
+        // 第一遍去重生成索引, 哈希表按位置, 法线, 纹理坐标中最多的数量预留, 通常与去重后的顶点数接近;
+        // 第二遍按去重后的顶点数一次分配输出数组, 从哈希表中的键写入每个顶点
+        ObjVertexIndexTable vertex_table(std::max({ positions.size(), normals.size(), uvs.size() }), faces.get_allocator().resource());
+        data.faces.resize(faces.size());
+        for (size_t i = 0; i < faces.size(); ++i)
+        {
+            const ObjVertex& vertex = faces[i];
+            GLuint next_index = static_cast<GLuint>(vertex_table.GetCount());
+            data.faces[i] = vertex_table.FindOrInsert(vertex.position_index, vertex.normal_index, vertex.uv_index, next_index);
+        }
+
+        size_t vertex_count = vertex_table.GetCount();
+        data.positions.resize(vertex_count * 3);
+        data.normals.resize(vertex_count * 3);
+        if (!uvs.empty())
+        {
+            data.uvs.resize(vertex_count * 2);
+        }
+        if (!tangents.empty())
+        {
+            data.tangents.resize(vertex_count * 4);
+        }
+
+        vertex_table.ForEach([&](int position_index, int normal_index, int uv_index, GLuint vertex_index)
         {
-            std::string vertex_str = vertex.ToString();
-            std::unordered_map<std::string, GLuint>::iterator it = vertex_map.find(vertex_str);
-            if (it == vertex_map.end())
+            const glm::vec3& position = positions[position_index];
+            GLfloat* p = &data.positions[vertex_index * 3];
+            p[0] = position.x;
+            p[1] = position.y;
+            p[2] = position.z;
+
+            const glm::vec3& n = normals[normal_index];
+            GLfloat* normal = &data.normals[vertex_index * 3];
+            normal[0] = n.x;
+            normal[1] = n.y;
+            normal[2] = n.z;
+
+            if (!uvs.empty())
             {
-                size_t vertex_index = data.positions.size() / 3;
+                const glm::vec2& uv = uvs[uv_index];
+                data.uvs[vertex_index * 2] = uv.x;
+                data.uvs[vertex_index * 2 + 1] = uv.y;
+            }
 
-                glm::vec3& position = positions[vertex.position_index];
-                data.positions.push_back(position.x);
-                data.positions.push_back(position.y);
-                data.positions.push_back(position.z);
+            if (!tangents.empty())
+            {
+                const glm::vec4& tangent = tangents[position_index];
+                GLfloat* t = &data.tangents[vertex_index * 4];
+                t[0] = tangent.x;
+                t[1] = tangent.y;
+                t[2] = tangent.z;
+                t[3] = tangent.w;
+            }
+        });
+    }
 
-                glm::vec3& n = normals[vertex.normal_index];
-                data.normals.push_back(n.x);
-                data.normals.push_back(n.y);
-                data.normals.push_back(n.z);
+    // 网格缓存文件格式: 文件头 | 位置 | 法线 | 纹理坐标 | 切线 | 索引, 数组紧密排列, 索引已经压缩到最小的类型
+    static const char s_mesh_cache_magic[4] = { 'G', 'L', 'S', 'M' };
+    static const std::uint32_t s_mesh_cache_version = 1;
+    // 保存缓存时每次压缩的索引数
+    static const size_t s_mesh_cache_index_batch = 16 * 1024;
 
-                if (!uvs.empty())
-                {
-                    glm::vec2& uv = uvs[vertex.uv_index];
-                    data.uvs.push_back(uv.x);
-                    data.uvs.push_back(uv.y);
-                }
+    enum MeshCacheFlag : std::uint32_t
+    {
+        MESH_CACHE_CENTER = 1,
+        MESH_CACHE_TANGENTS = 2,
+        MESH_CACHE_ADJACENCY = 4,
+        MESH_CACHE_OPTIMIZE = 8,
+        MESH_CACHE_AREA_WEIGHTED = 16,
+        MESH_CACHE_ANGLE_WEIGHTED = 32
+    };
+
+    enum MeshCacheAttribute : std::uint32_t
+    {
+        MESH_CACHE_HAS_UVS = 1,
+        MESH_CACHE_HAS_TANGENTS = 2
+    };
 
-                if (!tangents.empty())
-                {
-                    glm::vec4& tangent = tangents[vertex.position_index];
-                    data.tangents.push_back(tangent.x);
-                    data.tangents.push_back(tangent.y);
-                    data.tangents.push_back(tangent.z);
-                    data.tangents.push_back(tangent.w);
-                }
+    struct MeshCacheHeader
+    {
+        char magic[4];
+        std::uint32_t version;
+        std::uint64_t source_size;
+        std::uint64_t source_hash;
+        std::uint32_t flags;
+        std::uint32_t attributes;
+        std::uint64_t vertex_count;
+        std::uint64_t index_count;
+        std::uint32_t index_type;
+        float bounding_box[6];
+        std::uint32_t reserved;
+    };
+
+    // 条件成立时返回 flag, 否则返回 0, 用来拼接缓存的标志位
+    static std::uint32_t FlagIf(bool condition, std::uint32_t flag)
+    {
+        return condition ? flag : 0;
+    }
 
-                data.faces.push_back(static_cast<GLuint>(vertex_index));
-                vertex_map[vertex_str] = static_cast<GLuint>(vertex_index);
-            }
-            else
-            {
-                data.faces.push_back(it->second);
-            }
+    // 生成的法线随加权方式变化, 源文件自带法线时也一并计入, 只是多一份缓存
+    static std::uint32_t GetNormalWeightingFlag(ObjMesh::NormalWeighting weighting)
+    {
+        switch (weighting)
+        {
+        case ObjMesh::NormalWeighting::Area:  return MESH_CACHE_AREA_WEIGHTED;
+        case ObjMesh::NormalWeighting::Angle: return MESH_CACHE_ANGLE_WEIGHTED;
+        default:                              return 0;
+        }
+    }
+
+    // 文件头中的索引类型, 属性和数量必须与文件大小完全吻合, 截断或来源不明的文件不能映射.
+    // 数量先按文件大小限制, 后面的乘法不会溢出
+    static bool IsMeshCacheSizeValid(const MeshCacheHeader& header, size_t file_size)
+    {
+        if (header.index_type != GL_UNSIGNED_BYTE && header.index_type != GL_UNSIGNED_SHORT && header.index_type != GL_UNSIGNED_INT)
+        {
+            return false;
+        }
+        if ((header.attributes & ~std::uint32_t(MESH_CACHE_HAS_UVS | MESH_CACHE_HAS_TANGENTS)) != 0 || file_size < sizeof(MeshCacheHeader))
+        {
+            return false;
+        }
+
+        size_t floats_per_vertex = 6;
+        floats_per_vertex += (header.attributes & MESH_CACHE_HAS_UVS) != 0 ? 2 : 0;
+        floats_per_vertex += (header.attributes & MESH_CACHE_HAS_TANGENTS) != 0 ? 4 : 0;
+        size_t vertex_size = floats_per_vertex * sizeof(GLfloat);
+        size_t index_size = TriangleMesh::GetIndexTypeSize(header.index_type);
+        size_t data_size = file_size - sizeof(MeshCacheHeader);
+        if (header.vertex_count > data_size / vertex_size || header.index_count > data_size / index_size)
+        {
+            return false;
         }
+        return header.vertex_count * vertex_size + header.index_count * index_size == data_size;
     }
 
+    // 同一个模型可能被多个线程或进程同时保存, 每次写入使用不同的临时文件, 最后的重命名是原子的
+    static std::string MakeTempCachePath(const std::string& cache_path)
+    {
+        std::random_device random;
+        std::uint64_t id = (static_cast<std::uint64_t>(random()) << 32) ^ random() ^ std::hash<std::thread::id>()(std::this_thread::get_id());
+        return cache_path + "." + std::to_string(id) + ".tmp";
+    }
+
+    // LoadCompact 的内存块大小, 大数组都会超过它, 按请求的大小单独分配
+    static const size_t s_compact_arena_block_size = 64 * 1024;
+
+    ObjMesh::NormalWeighting ObjMesh::s_normal_weighting = ObjMesh::NormalWeighting::Uniform;
+
     ObjMesh::ObjMesh()
-        : m_is_draw_adj(false),
-          m_vao(0),
-          m_vertex_count(0)
+        : m_is_draw_adj(false)
     {
 
     }
@@ -435,129 +1412,191 @@ namespace glsl_shader
         std::vector<GLfloat>* positions,
         std::vector<GLfloat>* normals,
         std::vector<GLfloat>* uvs,
-        std::vector<GLfloat>* tangents
+        std::vector<GLfloat>* tangents,
+        const VertexFormat& format
     )
     {
-        if (indices == nullptr || positions == nullptr || normals == nullptr)
-        {
-            return;
-        }
+        m_mesh.Init(indices, positions, normals, uvs, tangents, format);
+    }
 
-        Terminate();
+    void ObjMesh::Terminate()
+    {
+        m_mesh.Terminate();
+    }
 
-        m_vertex_count = static_cast<GLuint>(indices->size());
+    void ObjMesh::Render() const
+    {
+        m_mesh.Render(m_is_draw_adj ? GL_TRIANGLES_ADJACENCY : GL_TRIANGLES);
+    }
 
-        GLuint index_buffer_object = 0;
-        GLuint position_buffer_object = 0;
-        GLuint normal_buffer_object = 0;
-        GLuint uv_buffer_object = 0;
-        GLuint tangent_buffer_object = 0;
-        glGenBuffers(1, &index_buffer_object);
-        m_buffers.push_back(index_buffer_object);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer_object);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices->size() * sizeof(GLuint), indices->data(), GL_STATIC_DRAW);
+    void ObjMesh::RenderInstanced(GLsizei instance_count, GLuint base_instance) const
+    {
+        m_mesh.RenderInstanced(instance_count, base_instance, m_is_draw_adj ? GL_TRIANGLES_ADJACENCY : GL_TRIANGLES);
+    }
 
-        glGenBuffers(1, &position_buffer_object);
-        m_buffers.push_back(position_buffer_object);
-        glBindBuffer(GL_ARRAY_BUFFER, position_buffer_object);
-        glBufferData(GL_ARRAY_BUFFER, positions->size() * sizeof(GLfloat), positions->data(), GL_STATIC_DRAW);
+    const TriangleMesh& ObjMesh::GetMesh() const
+    {
+        return m_mesh;
+    }
 
-        glGenBuffers(1, &normal_buffer_object);
-        m_buffers.push_back(normal_buffer_object);
-        glBindBuffer(GL_ARRAY_BUFFER, normal_buffer_object);
-        glBufferData(GL_ARRAY_BUFFER, normals->size() * sizeof(GLfloat), normals->data(), GL_STATIC_DRAW);
+    // Prepare 和 Upload 之间传递的数据, 命中缓存时 view 指向映射的缓存文件, 否则指向 data
+    struct ObjMesh::PreparedMesh
+    {
+        std::string filename;
+        std::string cache_path;
+        bool from_cache;
+        MappedFile cache_file;
+        MeshData data;
+        MeshView view;
+        VertexFormat format;
+        size_t file_size;
+        std::chrono::steady_clock::time_point load_start;
+        std::chrono::duration<double, std::milli> parse_time;
+    };
+
+    std::unique_ptr<ObjMesh> ObjMesh::Load(const char* filename, bool center, bool gen_tangents, const VertexFormat& format)
+    {
+        std::unique_ptr<ObjMesh> mesh(new ObjMesh());
+        PreparedMesh prepared;
+        mesh->Prepare(filename, center, gen_tangents, format, prepared);
+        mesh->Upload(prepared);
+        return mesh;
+    }
 
-        if (uvs != nullptr)
+    std::shared_future<std::shared_ptr<ObjMesh>> ObjMesh::LoadAsync
+    (
+        AssetLoader& loader,
+        const char* filename,
+        bool center,
+        bool gen_tangents,
+        const VertexFormat& format
+    )
+    {
+        std::string file_path(filename);
+        return loader.Load<std::shared_ptr<ObjMesh>>([file_path, center, gen_tangents, format]()
         {
-            glGenBuffers(1, &uv_buffer_object);
-            m_buffers.push_back(uv_buffer_object);
-            glBindBuffer(GL_ARRAY_BUFFER, uv_buffer_object);
-            glBufferData(GL_ARRAY_BUFFER, uvs->size() * sizeof(GLfloat), uvs->data(), GL_STATIC_DRAW);
-        }
+            std::shared_ptr<ObjMesh> mesh(new ObjMesh());
+            std::shared_ptr<PreparedMesh> prepared = std::make_shared<PreparedMesh>();
+            mesh->Prepare(file_path.c_str(), center, gen_tangents, format, *prepared);
+            return std::function<std::shared_ptr<ObjMesh>()>([mesh, prepared]()
+            {
+                mesh->Upload(*prepared);
+                return mesh;
+            });
+        });
+    }
 
-        if (tangents != nullptr)
+    void ObjMesh::Prepare(const char* filename, bool center, bool gen_tangents, const VertexFormat& format, PreparedMesh& prepared)
+    {
+        prepared.filename = filename;
+        prepared.load_start = std::chrono::steady_clock::now();
+        prepared.parse_time = std::chrono::duration<double, std::milli>(0.0);
+        prepared.file_size = 0;
+        prepared.format = format;
+        prepared.format.optimize = false;
+
+        std::uint32_t cache_flags = FlagIf(center, MESH_CACHE_CENTER) | FlagIf(gen_tangents, MESH_CACHE_TANGENTS) | FlagIf(format.optimize, MESH_CACHE_OPTIMIZE) | GetNormalWeightingFlag(s_normal_weighting);
+        CacheKey cache_key = {};
+        bool has_cache_key = MakeCacheKey(filename, cache_flags, cache_key, prepared.cache_path);
+        prepared.from_cache = has_cache_key && MapCache(prepared.cache_path, cache_key, prepared.cache_file, prepared.view);
+        if (prepared.from_cache)
         {
-            glGenBuffers(1, &tangent_buffer_object);
-            m_buffers.push_back(tangent_buffer_object);
-            glBindBuffer(GL_ARRAY_BUFFER, tangent_buffer_object);
-            glBufferData(GL_ARRAY_BUFFER, tangents->size() * sizeof(GLfloat), tangents->data(), GL_STATIC_DRAW);
+            return;
         }
 
-        glGenVertexArrays(1, &m_vao);
-        glBindVertexArray(m_vao);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer_object);
-
-        glBindBuffer(GL_ARRAY_BUFFER, position_buffer_object);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
-        glEnableVertexAttribArray(0);
+        ObjMeshData obj_mesh_data;
+        std::chrono::steady_clock::time_point parse_start = std::chrono::steady_clock::now();
+        prepared.file_size = obj_mesh_data.Load(filename, m_bounding_box, &ThreadPool::GetShared());
+        prepared.parse_time = std::chrono::steady_clock::now() - parse_start;
 
-        glBindBuffer(GL_ARRAY_BUFFER, normal_buffer_object);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, 0);
-        glEnableVertexAttribArray(1);
+        obj_mesh_data.GenerateNormalsIfNeeded(s_normal_weighting, &ThreadPool::GetShared());
 
-        if (uvs != nullptr)
+        if (gen_tangents)
         {
-            glBindBuffer(GL_ARRAY_BUFFER, uv_buffer_object);
-            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, 0);
-            glEnableVertexAttribArray(2);
+            obj_mesh_data.GenerateTangents(&ThreadPool::GetShared());
         }
 
-        if (tangents != nullptr)
+        MeshData& mesh_data = prepared.data;
+        obj_mesh_data.ToMesh(mesh_data);
+
+        if (center)
         {
-            glBindBuffer(GL_ARRAY_BUFFER, tangent_buffer_object);
-            glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, 0, 0);
-            glEnableVertexAttribArray(3);
+            mesh_data.Center(m_bounding_box);
         }
 
-        glBindVertexArray(0);
-    }
-
-    void ObjMesh::Terminate()
-    {
-        if (!m_buffers.empty())
+        // 在这里而不是 Init 中优化, 缓存保存的是重排之后的数据
+        if (format.optimize)
         {
-            glDeleteBuffers(static_cast<GLsizei>(m_buffers.size()), m_buffers.data());
-            m_buffers.clear();
+            MeshOptimizer::Optimize
+            (
+                mesh_data.faces,
+                mesh_data.positions,
+                mesh_data.normals,
+                mesh_data.uvs.empty() ? nullptr : &(mesh_data.uvs),
+                mesh_data.tangents.empty() ? nullptr : &(mesh_data.tangents)
+            );
         }
 
-        if (m_vao != 0)
+        prepared.view = mesh_data.GetView();
+        if (has_cache_key)
         {
-            glDeleteVertexArrays(1, &m_vao);
-            m_vao = 0;
+            SaveCache(prepared.cache_path, cache_key, prepared.view);
         }
     }
 
-    void ObjMesh::Render() const
+    void ObjMesh::Upload(PreparedMesh& prepared)
     {
-        if (m_is_draw_adj) {
-            glBindVertexArray(m_vao);
-            glDrawElements(GL_TRIANGLES_ADJACENCY, m_vertex_count, GL_UNSIGNED_INT, 0);
-            glBindVertexArray(0);
+        m_mesh.Init(prepared.view, prepared.format);
+        std::chrono::duration<double, std::milli> load_time = std::chrono::steady_clock::now() - prepared.load_start;
+
+        if (prepared.from_cache)
+        {
+            std::cout << "加载网格缓存: " << prepared.cache_path << std::endl;
+            std::cout << " triangles = " << (prepared.view.index_count / 3) << std::endl;
         }
         else
         {
-            glBindVertexArray(m_vao);
-            glDrawElements(GL_TRIANGLES, m_vertex_count, GL_UNSIGNED_INT, 0);
-            glBindVertexArray(0);
+            double parse_ms = prepared.parse_time.count();
+            std::cout << "加载模型文件: " << prepared.filename << std::endl;
+            std::cout << " vertices = " << prepared.view.vertex_count << std::endl;
+            std::cout << " triangles = " << (prepared.view.index_count / 3) << std::endl;
+            std::cout << " parse time = " << parse_ms << " ms (" << (prepared.file_size / (1024.0 * 1024.0)) / (parse_ms / 1000.0) << " MB/s)" << std::endl;
         }
+        std::cout << " load time = " << load_time.count() << " ms" << std::endl;
+        std::cout << " bounding box = " << m_bounding_box.ToString() << std::endl;
+        std::cout << " vertex size = " << m_mesh.GetVertexSize() << " bytes" << std::endl;
     }
 
-    std::unique_ptr<ObjMesh> ObjMesh::Load(const char* filename, bool center, bool gen_tangents)
+    std::unique_ptr<ObjMesh> ObjMesh::LoadWithAdjacency(const char* filename, bool center, const VertexFormat& format)
     {
         std::unique_ptr<ObjMesh> mesh(new ObjMesh());
+        mesh->m_is_draw_adj = true;
 
-        ObjMeshData obj_mesh_data;
-        obj_mesh_data.Load(filename, mesh->m_bounding_box);
-
-        obj_mesh_data.GenerateNormalsIfNeeded();
+        // 优化只能作用于三角形列表, 要在转换成邻接格式之前完成
+        VertexFormat adjacency_format = format;
+        adjacency_format.optimize = false;
 
-        if (gen_tangents)
+        std::chrono::steady_clock::time_point load_start = std::chrono::steady_clock::now();
+        std::uint32_t cache_flags = MESH_CACHE_ADJACENCY | FlagIf(center, MESH_CACHE_CENTER) | FlagIf(format.optimize, MESH_CACHE_OPTIMIZE) | GetNormalWeightingFlag(s_normal_weighting);
+        CacheKey cache_key = {};
+        std::string cache_path;
+        bool has_cache_key = MakeCacheKey(filename, cache_flags, cache_key, cache_path);
+        if (has_cache_key && mesh->LoadCache(cache_path, cache_key, adjacency_format))
         {
-            obj_mesh_data.GenerateTangents();
+            std::chrono::duration<double, std::milli> load_time = std::chrono::steady_clock::now() - load_start;
+            std::cout << "加载网格缓存: " << cache_path << std::endl;
+            std::cout << " load time = " << load_time.count() << " ms" << std::endl;
+            return mesh;
         }
 
-        ObjMesh::MeshData mesh_data;
+        ObjMeshData obj_mesh_data;
+        std::chrono::steady_clock::time_point parse_start = std::chrono::steady_clock::now();
+        size_t file_size = obj_mesh_data.Load(filename, mesh->m_bounding_box, &ThreadPool::GetShared());
+        std::chrono::duration<double, std::milli> parse_time = std::chrono::steady_clock::now() - parse_start;
+
+        obj_mesh_data.GenerateNormalsIfNeeded(s_normal_weighting, &ThreadPool::GetShared());
+
+        MeshData mesh_data;
         obj_mesh_data.ToMesh(mesh_data);
 
         if (center)
@@ -565,56 +1604,380 @@ namespace glsl_shader
             mesh_data.Center(mesh->m_bounding_box);
         }
 
+        if (format.optimize)
+        {
+            MeshOptimizer::Optimize
+            (
+                mesh_data.faces,
+                mesh_data.positions,
+                mesh_data.normals,
+                mesh_data.uvs.empty() ? nullptr : &(mesh_data.uvs),
+                mesh_data.tangents.empty() ? nullptr : &(mesh_data.tangents)
+            );
+        }
+
+        mesh_data.ConvertFacesToAdjancencyFormat(&ThreadPool::GetShared());
+
         mesh->Init
         (
             &(mesh_data.faces),
             &(mesh_data.positions),
             &(mesh_data.normals),
             mesh_data.uvs.empty() ? nullptr : &(mesh_data.uvs),
-            mesh_data.tangents.empty() ? nullptr : &(mesh_data.tangents)
+            mesh_data.tangents.empty() ? nullptr : &(mesh_data.tangents),
+            adjacency_format
         );
 
+        if (has_cache_key)
+        {
+            mesh->SaveCache(cache_path, cache_key, mesh_data.GetView());
+        }
+        std::chrono::duration<double, std::milli> load_time = std::chrono::steady_clock::now() - load_start;
+
         std::cout << "加载模型文件: " << filename << std::endl;
         std::cout << " vertices = " << (mesh_data.positions.size() / 3) << std::endl;
         std::cout << " triangles = " << (mesh_data.faces.size() / 3) << std::endl;
-        std::cout << " bounding box = " << mesh->m_bounding_box.ToString() << std::endl;
+        std::cout << " parse time = " << parse_time.count() << " ms (" << (file_size / (1024.0 * 1024.0)) / (parse_time.count() / 1000.0) << " MB/s)" << std::endl;
+        std::cout << " load time = " << load_time.count() << " ms" << std::endl;
 
         return mesh;
     }
 
-    std::unique_ptr<ObjMesh> ObjMesh::LoadWithAdjacency(const char* filename, bool center)
+    std::unique_ptr<ObjMesh> ObjMesh::LoadCompact
+    (
+        const char* filename,
+        bool center,
+        bool gen_tangents,
+        const VertexFormat& format,
+        MemoryArenaStatistics* statistics
+    )
     {
         std::unique_ptr<ObjMesh> mesh(new ObjMesh());
 
-        ObjMeshData obj_mesh_data;
-        obj_mesh_data.Load(filename, mesh->m_bounding_box);
-
-        obj_mesh_data.GenerateNormalsIfNeeded();
+        // 优化器在 std::vector 上原地重排并生成完整的副本, 这里不运行, 缓存与不优化的 Load 共用
+        VertexFormat compact_format = format;
+        compact_format.optimize = false;
 
-        MeshData mesh_data;
-        obj_mesh_data.ToMesh(mesh_data);
+        MemoryArenaStatistics arena_statistics = { 0, 0, 0, 0 };
+        if (statistics != nullptr)
+        {
+            *statistics = arena_statistics;
+        }
 
-        if (center)
+        std::chrono::steady_clock::time_point load_start = std::chrono::steady_clock::now();
+        std::uint32_t cache_flags = FlagIf(center, MESH_CACHE_CENTER) | FlagIf(gen_tangents, MESH_CACHE_TANGENTS) | GetNormalWeightingFlag(s_normal_weighting);
+        CacheKey cache_key = {};
+        std::string cache_path;
+        bool has_cache_key = MakeCacheKey(filename, cache_flags, cache_key, cache_path);
+        if (has_cache_key && mesh->LoadCache(cache_path, cache_key, compact_format))
         {
-            mesh_data.Center(mesh->m_bounding_box);
+            std::chrono::duration<double, std::milli> load_time = std::chrono::steady_clock::now() - load_start;
+            std::cout << "加载网格缓存: " << cache_path << std::endl;
+            std::cout << " triangles = " << (mesh->m_mesh.GetVertexCount() / 3) << std::endl;
+            std::cout << " load time = " << load_time.count() << " ms" << std::endl;
+            return mesh;
         }
 
-        mesh->m_is_draw_adj = true;
-        mesh_data.ConvertFacesToAdjancencyFormat();
+        // parse_arena 保存解析结果和去重用的哈希表, 生成网格数据后立即释放;
+        // mesh_arena 保存最终的顶点和索引以及上传时编码用的临时数据, 上传后释放
+        MemoryArena parse_arena(s_compact_arena_block_size, &arena_statistics);
+        MemoryArena mesh_arena(s_compact_arena_block_size, &arena_statistics);
 
-        mesh->Init
-        (
-            &(mesh_data.faces),
-            &(mesh_data.positions),
-            &(mesh_data.normals),
-            mesh_data.uvs.empty() ? nullptr : &(mesh_data.uvs),
-            mesh_data.tangents.empty() ? nullptr : &(mesh_data.tangents)
-        );
+        size_t file_size = 0;
+        size_t vertex_count = 0;
+        size_t triangle_count = 0;
+        std::chrono::duration<double, std::milli> parse_time(0.0);
+        {
+            CompactMeshData mesh_data(&mesh_arena);
+            {
+                ObjMeshData obj_mesh_data(&parse_arena);
+                std::chrono::steady_clock::time_point parse_start = std::chrono::steady_clock::now();
+                file_size = obj_mesh_data.Load(filename, mesh->m_bounding_box, nullptr, true);
+                parse_time = std::chrono::steady_clock::now() - parse_start;
+
+                obj_mesh_data.GenerateNormalsIfNeeded(s_normal_weighting);
+                if (gen_tangents)
+                {
+                    obj_mesh_data.GenerateTangents();
+                }
+
+                obj_mesh_data.ToMesh(mesh_data);
+            }
+            parse_arena.Release();
+
+            if (center)
+            {
+                mesh_data.Center(mesh->m_bounding_box);
+            }
+
+            vertex_count = mesh_data.positions.size() / 3;
+            triangle_count = mesh_data.faces.size() / 3;
+
+            mesh->m_mesh.Init(mesh_data.GetView(), compact_format, GL_TRIANGLES, &mesh_arena);
+            if (has_cache_key)
+            {
+                mesh->SaveCache(cache_path, cache_key, mesh_data.GetView());
+            }
+        }
+        mesh_arena.Release();
+        std::chrono::duration<double, std::milli> load_time = std::chrono::steady_clock::now() - load_start;
+
+        if (statistics != nullptr)
+        {
+            *statistics = arena_statistics;
+        }
 
+        size_t gpu_bytes = mesh->m_mesh.GetVertexBufferSize() + mesh->m_mesh.GetIndexBufferSize();
         std::cout << "加载模型文件: " << filename << std::endl;
-        std::cout << " vertices = " << (mesh_data.positions.size() / 3) << std::endl;
-        std::cout << " triangles = " << (mesh_data.faces.size() / 3) << std::endl;
+        std::cout << " vertices = " << vertex_count << std::endl;
+        std::cout << " triangles = " << triangle_count << std::endl;
+        std::cout << " parse time = " << parse_time.count() << " ms (" << (file_size / (1024.0 * 1024.0)) / (parse_time.count() / 1000.0) << " MB/s)" << std::endl;
+        std::cout << " load time = " << load_time.count() << " ms" << std::endl;
+        std::cout << " arena peak = " << (arena_statistics.peak_bytes / (1024.0 * 1024.0)) << " MB ("
+                  << static_cast<double>(arena_statistics.peak_bytes) / std::max<size_t>(gpu_bytes, 1) << "x mesh size), "
+                  << arena_statistics.allocation_count << " allocations, " << arena_statistics.block_count << " blocks" << std::endl;
+        std::cout << " vertex size = " << mesh->m_mesh.GetVertexSize() << " bytes" << std::endl;
 
         return mesh;
     }
+
+    bool ObjMesh::MakeCacheKey(const char* filename, std::uint32_t flags, CacheKey& key, std::string& cache_path)
+    {
+        MappedFile source_file;
+        if (!source_file.Open(filename))
+        {
+            return false;
+        }
+
+        key.source_size = source_file.GetSize();
+        key.source_hash = FNV_OFFSET_BASIS;
+        HashWords(key.source_hash, source_file.GetData(), source_file.GetSize());
+        key.flags = flags;
+        cache_path = std::string(filename) + "." + std::to_string(flags) + ".meshcache";
+        return true;
+    }
+
+    bool ObjMesh::LoadCache(const std::string& cache_path, const CacheKey& key, const VertexFormat& format)
+    {
+        MappedFile cache_file;
+        MeshView view = {};
+        if (!MapCache(cache_path, key, cache_file, view))
+        {
+            return false;
+        }
+
+        m_mesh.Init(view, format);
+        return true;
+    }
+
+    bool ObjMesh::MapCache(const std::string& cache_path, const CacheKey& key, MappedFile& cache_file, MeshView& view)
+    {
+        if (!cache_file.Open(cache_path) || cache_file.GetSize() < sizeof(MeshCacheHeader))
+        {
+            cache_file.Close();
+            return false;
+        }
+
+        MeshCacheHeader header;
+        std::memcpy(&header, cache_file.GetData(), sizeof(header));
+        if (std::memcmp(header.magic, s_mesh_cache_magic, sizeof(s_mesh_cache_magic)) != 0 ||
+            header.version != s_mesh_cache_version ||
+            header.source_size != key.source_size ||
+            header.source_hash != key.source_hash ||
+            header.flags != key.flags ||
+            !IsMeshCacheSizeValid(header, cache_file.GetSize()))
+        {
+            cache_file.Close();
+            return false;
+        }
+
+        m_bounding_box.min = glm::vec3(header.bounding_box[0], header.bounding_box[1], header.bounding_box[2]);
+        m_bounding_box.max = glm::vec3(header.bounding_box[3], header.bounding_box[4], header.bounding_box[5]);
+
+        // 映射的起始地址按页对齐, 各数组都是 4 字节对齐的, 可以直接交给 TriangleMesh 上传
+        const char* p = cache_file.GetData() + sizeof(MeshCacheHeader);
+        size_t vertex_count = static_cast<size_t>(header.vertex_count);
+        view = MeshView();
+        view.vertex_count = vertex_count;
+        view.positions = reinterpret_cast<const GLfloat*>(p);
+        p += vertex_count * 3 * sizeof(GLfloat);
+        view.normals = reinterpret_cast<const GLfloat*>(p);
+        p += vertex_count * 3 * sizeof(GLfloat);
+        if ((header.attributes & MESH_CACHE_HAS_UVS) != 0)
+        {
+            view.uvs = reinterpret_cast<const GLfloat*>(p);
+            p += vertex_count * 2 * sizeof(GLfloat);
+        }
+        if ((header.attributes & MESH_CACHE_HAS_TANGENTS) != 0)
+        {
+            view.tangents = reinterpret_cast<const GLfloat*>(p);
+            p += vertex_count * 4 * sizeof(GLfloat);
+        }
+        view.index_count = static_cast<size_t>(header.index_count);
+        view.index_type = header.index_type;
+        view.indices = p;
+        return true;
+    }
+
+    void ObjMesh::SaveCache(const std::string& cache_path, const CacheKey& key, const MeshView& view) const
+    {
+        MeshCacheHeader header = {};
+        std::memcpy(header.magic, s_mesh_cache_magic, sizeof(s_mesh_cache_magic));
+        header.version = s_mesh_cache_version;
+        header.source_size = key.source_size;
+        header.source_hash = key.source_hash;
+        header.flags = key.flags;
+        header.attributes = FlagIf(view.uvs != nullptr, MESH_CACHE_HAS_UVS) | FlagIf(view.tangents != nullptr, MESH_CACHE_HAS_TANGENTS);
+        header.vertex_count = view.vertex_count;
+        header.index_count = view.index_count;
+        header.index_type = TriangleMesh::SelectIndexType(static_cast<const GLuint*>(view.indices), view.index_count);
+        header.bounding_box[0] = m_bounding_box.min.x;
+        header.bounding_box[1] = m_bounding_box.min.y;
+        header.bounding_box[2] = m_bounding_box.min.z;
+        header.bounding_box[3] = m_bounding_box.max.x;
+        header.bounding_box[4] = m_bounding_box.max.y;
+        header.bounding_box[5] = m_bounding_box.max.z;
+
+        // 先写入临时文件再重命名, 避免读到不完整的缓存; 写入失败时只是下次继续解析源文件
+        std::string temp_path = MakeTempCachePath(cache_path);
+        bool written = false;
+        {
+            std::ofstream cache_file(temp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+            if (!cache_file.is_open())
+            {
+                std::cerr << "无法创建网格缓存: " << cache_path << std::endl;
+                return;
+            }
+
+            size_t vertex_count = view.vertex_count;
+            cache_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            cache_file.write(reinterpret_cast<const char*>(view.positions), vertex_count * 3 * sizeof(GLfloat));
+            cache_file.write(reinterpret_cast<const char*>(view.normals), vertex_count * 3 * sizeof(GLfloat));
+            if (view.uvs != nullptr)
+            {
+                cache_file.write(reinterpret_cast<const char*>(view.uvs), vertex_count * 2 * sizeof(GLfloat));
+            }
+            if (view.tangents != nullptr)
+            {
+                cache_file.write(reinterpret_cast<const char*>(view.tangents), vertex_count * 4 * sizeof(GLfloat));
+            }
+
+            // 索引分段压缩后写入, 不需要整个索引数组大小的临时缓冲
+            const GLuint* indices = static_cast<const GLuint*>(view.indices);
+            GLsizei index_size = TriangleMesh::GetIndexTypeSize(header.index_type);
+            std::vector<unsigned char> index_data(s_mesh_cache_index_batch * index_size);
+            for (size_t begin = 0; begin < view.index_count; begin += s_mesh_cache_index_batch)
+            {
+                size_t count = std::min(s_mesh_cache_index_batch, view.index_count - begin);
+                TriangleMesh::ConvertIndices(indices + begin, count, header.index_type, index_data.data());
+                cache_file.write(reinterpret_cast<const char*>(index_data.data()), count * index_size);
+            }
+            written = cache_file.good();
+        }
+
+        std::error_code error;
+        if (!written)
+        {
+            std::cerr << "写入网格缓存失败: " << cache_path << std::endl;
+            std::filesystem::remove(temp_path, error);
+            return;
+        }
+        std::filesystem::rename(temp_path, cache_path, error);
+        if (error)
+        {
+            std::filesystem::remove(temp_path, error);
+        }
+    }
+
+    void ObjMesh::BenchmarkParse(const char* filename, unsigned int max_thread_count)
+    {
+        if (max_thread_count == 0)
+        {
+            max_thread_count = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        std::cout << "解析速度: " << filename << std::endl;
+
+        double serial_time = 0.0;
+        for (unsigned int thread_count = 1; thread_count <= max_thread_count; ++thread_count)
+        {
+            // 调用线程也参与解析, 所以线程池少一个线程
+            std::unique_ptr<ThreadPool> pool(thread_count > 1 ? new ThreadPool(thread_count - 1) : nullptr);
+
+            double best_time = 0.0;
+            size_t file_size = 0;
+            for (int run = 0; run < 3; ++run)
+            {
+                ObjMeshData obj_mesh_data;
+                BoundingBox bounding_box;
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                file_size = obj_mesh_data.Load(filename, bounding_box, pool.get());
+                std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+                best_time = run == 0 ? elapsed.count() : std::min(best_time, elapsed.count());
+            }
+
+            if (thread_count == 1)
+            {
+                serial_time = best_time;
+            }
+
+            std::cout << " threads = " << thread_count << ": " << best_time << " ms, "
+                      << (file_size / (1024.0 * 1024.0)) / (best_time / 1000.0) << " MB/s, "
+                      << "x" << serial_time / best_time << std::endl;
+        }
+    }
+
+    bool ObjMesh::CheckAdjacency(const char* filename)
+    {
+        ObjMeshData obj_mesh_data;
+        BoundingBox bounding_box;
+        obj_mesh_data.Load(filename, bounding_box, &ThreadPool::GetShared());
+        obj_mesh_data.GenerateNormalsIfNeeded(s_normal_weighting, &ThreadPool::GetShared());
+
+        MeshData reference_data;
+        obj_mesh_data.ToMesh(reference_data);
+        MeshData serial_data;
+        serial_data.faces = reference_data.faces;
+        MeshData parallel_data;
+        parallel_data.faces = reference_data.faces;
+
+        std::cout << "检查邻接索引: " << filename << std::endl;
+        std::cout << " triangles = " << reference_data.faces.size() / 3 << std::endl;
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        reference_data.ConvertFacesToAdjancencyFormatReference();
+        std::chrono::duration<double, std::milli> reference_time = std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        serial_data.ConvertFacesToAdjancencyFormat();
+        std::chrono::duration<double, std::milli> serial_time = std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        parallel_data.ConvertFacesToAdjancencyFormat(&ThreadPool::GetShared());
+        std::chrono::duration<double, std::milli> parallel_time = std::chrono::steady_clock::now() - start;
+
+        // 数量不同时多出来的索引全部算作不同
+        auto count_mismatches = [&](const std::vector<GLuint>& faces)
+        {
+            size_t common_count = std::min(faces.size(), reference_data.faces.size());
+            size_t mismatch_count = std::max(faces.size(), reference_data.faces.size()) - common_count;
+            for (size_t i = 0; i < common_count; ++i)
+            {
+                mismatch_count += faces[i] != reference_data.faces[i] ? 1 : 0;
+            }
+            return mismatch_count;
+        };
+        size_t serial_mismatch_count = count_mismatches(serial_data.faces);
+        size_t parallel_mismatch_count = count_mismatches(parallel_data.faces);
+
+        std::cout << " reference = " << reference_time.count() << " ms" << std::endl;
+        std::cout << " serial = " << serial_time.count() << " ms, " << serial_mismatch_count << " mismatched indices" << std::endl;
+        std::cout << " parallel = " << parallel_time.count() << " ms, " << parallel_mismatch_count << " mismatched indices" << std::endl;
+        return serial_mismatch_count == 0 && parallel_mismatch_count == 0;
+    }
+
+    void ObjMesh::SetNormalWeighting(NormalWeighting weighting)
+    {
+        s_normal_weighting = weighting;
+    }
 }
\ No newline at end of file
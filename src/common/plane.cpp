@@ -2,14 +2,14 @@
 
 namespace glsl_shader
 {
-    Plane::Plane(float xsize, float zsize, int xdivs, int zdivs, float smax, float tmax)
+    Plane::Plane(float xsize, float zsize, int xdivs, int zdivs, float smax, float tmax, const VertexFormat& format)
     {
         int position_count = (xdivs + 1) * (zdivs + 1);
         std::vector<GLfloat> positions(3 * position_count);
         std::vector<GLfloat> normals(3 * position_count);
         std::vector<GLfloat> uvs(2 * position_count);
         std::vector<GLfloat> tangents(4 * position_count);
-        std::vector<GLuint> indices(6 * xdivs * zdivs);
+        std::vector<GLuint> indices;
 
         float x2 = xsize / 2.0f;
         float z2 = zsize / 2.0f;
@@ -52,24 +52,47 @@ namespace glsl_shader
 
         GLuint row_start = 0;
         GLuint next_row_start = 0;
-        int idx = 0;
-        for (int i = 0; i < zdivs; ++i)
+        if (format.strips)
         {
-            row_start = static_cast<GLuint>(i * (xdivs + 1));
-            next_row_start = static_cast<GLuint>((i + 1) * (xdivs + 1));
-            for (int j = 0; j < xdivs; ++j)
+            // 每行一条三角形带, 2 * (xdivs + 1) 个索引, 行之间插入重启索引
+            indices.reserve(zdivs * (2 * (xdivs + 1) + 1));
+            for (int i = 0; i < zdivs; ++i)
             {
-                indices[idx] = row_start + j;
-                indices[idx + 1] = next_row_start + j;
-                indices[idx + 2] = next_row_start + j + 1;
-                indices[idx + 3] = row_start + j;
-                indices[idx + 4] = next_row_start + j + 1;
-                indices[idx + 5] = row_start + j + 1;
-                idx += 6;
+                row_start = static_cast<GLuint>(i * (xdivs + 1));
+                next_row_start = static_cast<GLuint>((i + 1) * (xdivs + 1));
+                if (i > 0)
+                {
+                    indices.push_back(TriangleMesh::RESTART_INDEX);
+                }
+                for (int j = 0; j <= xdivs; ++j)
+                {
+                    indices.push_back(row_start + j);
+                    indices.push_back(next_row_start + j);
+                }
+            }
+        }
+        else
+        {
+            indices.resize(6 * xdivs * zdivs);
+            int idx = 0;
+            for (int i = 0; i < zdivs; ++i)
+            {
+                row_start = static_cast<GLuint>(i * (xdivs + 1));
+                next_row_start = static_cast<GLuint>((i + 1) * (xdivs + 1));
+                for (int j = 0; j < xdivs; ++j)
+                {
+                    indices[idx] = row_start + j;
+                    indices[idx + 1] = next_row_start + j;
+                    indices[idx + 2] = next_row_start + j + 1;
+                    indices[idx + 3] = row_start + j;
+                    indices[idx + 4] = next_row_start + j + 1;
+                    indices[idx + 5] = row_start + j + 1;
+                    idx += 6;
+                }
             }
         }
 
-        m_mesh.Init(&indices, &positions, &normals, &uvs, &tangents);
+        m_mesh.Init(&indices, &positions, &normals, &uvs, &tangents, format, format.strips ? GL_TRIANGLE_STRIP : GL_TRIANGLES);
     }
 
     Plane::~Plane()
@@ -81,4 +104,9 @@ namespace glsl_shader
     {
         m_mesh.Render();
     }
+
+    const TriangleMesh& Plane::GetMesh() const
+    {
+        return m_mesh;
+    }
 }
\ No newline at end of file
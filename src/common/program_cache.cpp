@@ -0,0 +1,170 @@
+﻿#include "common/program_cache.h"
+
+namespace glsl_shader
+{
+    // 把阶段类型, 源代码长度和源代码追加到键中, 带长度前缀的多个阶段拼接后仍能唯一区分
+    static void AppendStageKey(std::string& key, ShaderType shader_type, const std::vector<std::string_view>& segments)
+    {
+        unsigned int type = static_cast<unsigned int>(shader_type);
+        size_t size = 0;
+        for (std::string_view segment : segments)
+        {
+            size += segment.size();
+        }
+
+        key.append(reinterpret_cast<const char*>(&type), sizeof(type));
+        key.append(reinterpret_cast<const char*>(&size), sizeof(size));
+        for (std::string_view segment : segments)
+        {
+            key.append(segment.data(), segment.size());
+        }
+    }
+
+    ProgramCache::ProgramCache()
+        : m_stats()
+    {
+
+    }
+
+    ProgramCache::~ProgramCache()
+    {
+        Clear();
+    }
+
+    std::shared_ptr<GLSLProgram> ProgramCache::GetProgram(const std::vector<std::filesystem::path>& shader_file_paths, const ShaderDefines& defines)
+    {
+        // 先按文件路径和宏定义查找, 同一组文件再次请求时不需要读取源代码
+        std::string path_key = std::to_string(shader_file_paths.size());
+        path_key += '\0';
+        for (const std::filesystem::path& shader_file_path : shader_file_paths)
+        {
+            path_key += shader_file_path.lexically_normal().generic_string();
+            path_key += '\0';
+        }
+        for (const std::pair<const std::string, std::string>& define : defines)
+        {
+            path_key += define.first;
+            path_key += '\0';
+            path_key += define.second;
+            path_key += '\0';
+        }
+
+        std::unordered_map<std::string, std::shared_ptr<GLSLProgram>>::iterator path_it = m_programs_by_path.find(path_key);
+        if (path_it != m_programs_by_path.end())
+        {
+            ++m_stats.program_hits;
+            return path_it->second;
+        }
+
+        // CompileShader 只读取和预处理源代码, 不调用 GL, 预处理后的源代码用来合并内容相同的程序
+        std::shared_ptr<GLSLProgram> program = std::make_shared<GLSLProgram>();
+        program->SetDefines(defines);
+        for (const std::filesystem::path& shader_file_path : shader_file_paths)
+        {
+            program->CompileShader(shader_file_path);
+        }
+
+        std::string key;
+        for (const GLSLProgram::StageSource& stage : program->m_stage_sources)
+        {
+            AppendStageKey(key, stage.type, stage.segments);
+        }
+
+        std::unordered_map<std::string, std::shared_ptr<GLSLProgram>>::iterator it = m_programs.find(key);
+        if (it != m_programs.end())
+        {
+            ++m_stats.program_hits;
+            m_programs_by_path[path_key] = it->second;
+            return it->second;
+        }
+
+        // 只有未命中时才创建程序对象并链接
+        ++m_stats.program_misses;
+        m_new_shader_keys.clear();
+        program->m_shader_provider = [this](ShaderType shader_type, const std::vector<std::string_view>& segments)
+        {
+            return AcquireShader(shader_type, segments);
+        };
+        try
+        {
+            program->Link();
+        }
+        catch (...)
+        {
+            // 失败的程序不进入缓存, 它新编译的着色器也一起删除, 修改源代码后再次请求时重新编译
+            program->m_shader_provider = nullptr;
+            for (const std::string& shader_key : m_new_shader_keys)
+            {
+                std::unordered_map<std::string, GLuint>::iterator shader_it = m_shaders.find(shader_key);
+                glDeleteShader(shader_it->second);
+                m_shaders.erase(shader_it);
+            }
+            m_new_shader_keys.clear();
+            throw;
+        }
+        program->m_shader_provider = nullptr;
+        m_new_shader_keys.clear();
+
+        m_programs[key] = program;
+        m_programs_by_path[path_key] = program;
+        return program;
+    }
+
+    void ProgramCache::Clear()
+    {
+        for (const std::pair<const std::string, GLuint>& shader : m_shaders)
+        {
+            glDeleteShader(shader.second);
+        }
+
+        m_shaders.clear();
+        m_programs.clear();
+        m_programs_by_path.clear();
+    }
+
+    ProgramCacheStats ProgramCache::GetStats() const
+    {
+        return m_stats;
+    }
+
+    size_t ProgramCache::GetProgramCount() const
+    {
+        return m_programs.size();
+    }
+
+    size_t ProgramCache::GetShaderCount() const
+    {
+        return m_shaders.size();
+    }
+
+    GLuint ProgramCache::AcquireShader(ShaderType shader_type, const std::vector<std::string_view>& segments)
+    {
+        std::string key;
+        AppendStageKey(key, shader_type, segments);
+
+        std::unordered_map<std::string, GLuint>::iterator it = m_shaders.find(key);
+        if (it != m_shaders.end())
+        {
+            ++m_stats.shader_hits;
+            return it->second;
+        }
+
+        // 与 GLSLProgram 一样只提交编译, 编译错误在链接后统一读取
+        ++m_stats.shader_misses;
+        std::vector<const GLchar*> code;
+        std::vector<GLint> lengths;
+        for (std::string_view segment : segments)
+        {
+            code.push_back(segment.data());
+            lengths.push_back(static_cast<GLint>(segment.size()));
+        }
+
+        GLuint shader = glCreateShader(static_cast<GLenum>(shader_type));
+        glShaderSource(shader, static_cast<GLsizei>(code.size()), code.data(), lengths.data());
+        glCompileShader(shader);
+
+        m_shaders[key] = shader;
+        m_new_shader_keys.push_back(std::move(key));
+        return shader;
+    }
+}
@@ -0,0 +1,96 @@
+﻿#include "common/shader_compile_queue.h"
+
+#include <thread>
+#include <chrono>
+#include <exception>
+
+namespace glsl_shader
+{
+    typedef void (GLAD_API_PTR *PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+    ShaderCompileQueue::ShaderCompileQueue()
+    {
+
+    }
+
+    ShaderCompileQueue::~ShaderCompileQueue()
+    {
+
+    }
+
+    void ShaderCompileQueue::Add(GLSLProgram& program)
+    {
+        m_programs.push_back(&program);
+    }
+
+    void ShaderCompileQueue::Submit()
+    {
+        for (GLSLProgram* program : m_programs)
+        {
+            program->SubmitLink();
+        }
+    }
+
+    void ShaderCompileQueue::Join()
+    {
+        // 轮询 GL_COMPLETION_STATUS_KHR, 哪个程序先完成就先收尾, 不在单个程序上阻塞
+        std::exception_ptr first_error = nullptr;
+        std::vector<GLSLProgram*> pending = m_programs;
+        while (!pending.empty())
+        {
+            bool progressed = false;
+            for (size_t i = 0; i < pending.size();)
+            {
+                if (!pending[i]->IsLinkComplete())
+                {
+                    ++i;
+                    continue;
+                }
+
+                try
+                {
+                    pending[i]->FinishLink();
+                }
+                catch (...)
+                {
+                    if (first_error == nullptr)
+                    {
+                        first_error = std::current_exception();
+                    }
+                }
+                pending.erase(pending.begin() + i);
+                progressed = true;
+            }
+
+            if (!progressed)
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        }
+        m_programs.clear();
+
+        if (first_error != nullptr)
+        {
+            std::rethrow_exception(first_error);
+        }
+    }
+
+    void ShaderCompileQueue::SetMaxShaderCompilerThreads(GLADloadfunc load, GLuint count)
+    {
+        if (load == nullptr || !GLSLProgram::IsParallelCompileSupported())
+        {
+            return;
+        }
+
+        PFNGLMAXSHADERCOMPILERTHREADSKHRPROC max_threads = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(load("glMaxShaderCompilerThreadsKHR"));
+        if (max_threads == nullptr)
+        {
+            max_threads = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(load("glMaxShaderCompilerThreadsARB"));
+        }
+
+        if (max_threads != nullptr)
+        {
+            max_threads(count);
+        }
+    }
+}
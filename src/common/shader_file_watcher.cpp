@@ -0,0 +1,248 @@
+﻿#include "common/shader_file_watcher.h"
+
+#include <iostream>
+#include <chrono>
+#include <algorithm>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace glsl_shader
+{
+    // 后台线程检查停止标志和新增文件的间隔
+    static const int s_watch_interval_ms = 100;
+
+    static std::filesystem::path GetWatchPath(const std::filesystem::path& file_path)
+    {
+        std::error_code error;
+        std::filesystem::path path = std::filesystem::weakly_canonical(file_path, error);
+        return error ? std::filesystem::absolute(file_path).lexically_normal() : path;
+    }
+
+    ShaderFileWatcher::ShaderFileWatcher()
+        : m_is_running(false)
+    {
+
+    }
+
+    ShaderFileWatcher::~ShaderFileWatcher()
+    {
+        Stop();
+    }
+
+    void ShaderFileWatcher::Watch(GLSLProgram& program)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (std::find(m_programs.begin(), m_programs.end(), &program) == m_programs.end())
+        {
+            m_programs.push_back(&program);
+        }
+
+        AddFiles(program);
+    }
+
+    void ShaderFileWatcher::Unwatch(GLSLProgram& program)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_programs.erase(std::remove(m_programs.begin(), m_programs.end(), &program), m_programs.end());
+    }
+
+    void ShaderFileWatcher::Start()
+    {
+        if (m_is_running)
+        {
+            return;
+        }
+
+        m_is_running = true;
+        m_thread = std::thread(&ShaderFileWatcher::Run, this);
+    }
+
+    void ShaderFileWatcher::Stop()
+    {
+        m_is_running = false;
+        if (m_thread.joinable())
+        {
+            m_thread.join();
+        }
+    }
+
+    int ShaderFileWatcher::Poll()
+    {
+        std::set<std::filesystem::path> changed_files;
+        std::vector<GLSLProgram*> programs;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_changed_files.empty())
+            {
+                return 0;
+            }
+            changed_files.swap(m_changed_files);
+            programs = m_programs;
+        }
+
+        int reloaded = 0;
+        for (GLSLProgram* program : programs)
+        {
+            bool is_changed = false;
+            for (const std::filesystem::path& file_path : program->GetShaderDependencies())
+            {
+                if (changed_files.count(GetWatchPath(file_path)) > 0)
+                {
+                    is_changed = true;
+                    break;
+                }
+            }
+            if (!is_changed)
+            {
+                continue;
+            }
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            try
+            {
+                program->Reload();
+                ++reloaded;
+
+                // 重新加载后包含的文件可能变化, 新出现的文件也需要监视
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    AddFiles(*program);
+                }
+
+                std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+                std::cout << "重新加载着色器程序 " << program->GetShaderFiles().front().first.filename().string() << " 用时: " << elapsed.count() << " ms" << std::endl;
+            }
+            catch (const GLSLProgramException& e)
+            {
+                // 新程序链接失败时继续使用旧程序
+                std::cerr << "重新加载着色器程序失败, 继续使用旧的程序: " << e.what() << std::endl;
+            }
+        }
+
+        return reloaded;
+    }
+
+    void ShaderFileWatcher::Run()
+    {
+#ifdef __linux__
+        RunNotify();
+#else
+        RunPolling();
+#endif
+    }
+
+    void ShaderFileWatcher::RunNotify()
+    {
+#ifdef __linux__
+        int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd < 0)
+        {
+            RunPolling();
+            return;
+        }
+
+        // 监视文件所在的目录而不是文件本身, 编辑器通过重命名替换文件时也能收到事件
+        std::map<int, std::filesystem::path> directories;
+        std::set<std::filesystem::path> watched_directories;
+        alignas(inotify_event) char buffer[4096];
+
+        while (m_is_running)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                for (const std::filesystem::path& file_path : m_files)
+                {
+                    std::filesystem::path directory = file_path.parent_path();
+                    if (watched_directories.insert(directory).second)
+                    {
+                        int wd = inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+                        if (wd >= 0)
+                        {
+                            directories[wd] = directory;
+                        }
+                    }
+                }
+            }
+
+            pollfd descriptor = { fd, POLLIN, 0 };
+            if (poll(&descriptor, 1, s_watch_interval_ms) <= 0)
+            {
+                continue;
+            }
+
+            ssize_t length = read(fd, buffer, sizeof(buffer));
+            for (ssize_t offset = 0; offset < length; )
+            {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                offset += sizeof(inotify_event) + event->len;
+
+                std::map<int, std::filesystem::path>::iterator directory = directories.find(event->wd);
+                if (event->len > 0 && directory != directories.end())
+                {
+                    MarkChanged(directory->second / event->name);
+                }
+            }
+        }
+
+        close(fd);
+#endif
+    }
+
+    void ShaderFileWatcher::RunPolling()
+    {
+        std::map<std::filesystem::path, std::filesystem::file_time_type> write_times;
+
+        while (m_is_running)
+        {
+            std::set<std::filesystem::path> files;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                files = m_files;
+            }
+
+            for (const std::filesystem::path& file_path : files)
+            {
+                std::error_code error;
+                std::filesystem::file_time_type write_time = std::filesystem::last_write_time(file_path, error);
+                if (error)
+                {
+                    continue;
+                }
+
+                std::map<std::filesystem::path, std::filesystem::file_time_type>::iterator it = write_times.find(file_path);
+                if (it == write_times.end())
+                {
+                    write_times[file_path] = write_time;
+                }
+                else if (it->second != write_time)
+                {
+                    it->second = write_time;
+                    MarkChanged(file_path);
+                }
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(s_watch_interval_ms));
+        }
+    }
+
+    void ShaderFileWatcher::AddFiles(const GLSLProgram& program)
+    {
+        for (const std::filesystem::path& file_path : program.GetShaderDependencies())
+        {
+            m_files.insert(GetWatchPath(file_path));
+        }
+    }
+
+    void ShaderFileWatcher::MarkChanged(const std::filesystem::path& file_path)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_files.count(file_path) > 0)
+        {
+            m_changed_files.insert(file_path);
+        }
+    }
+}
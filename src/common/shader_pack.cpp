@@ -0,0 +1,279 @@
+﻿#include "common/shader_pack.h"
+#include "common/fnv_hash.h"
+
+#include <fstream>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+namespace glsl_shader
+{
+    // 文件格式: 文件头(标识, 版本, 文件数量, 目录清单哈希) | 索引(每项: 路径长度, 路径, 数据偏移, 数据长度) | 数据
+    static const char s_shader_pack_magic[4] = { 'G', 'L', 'S', 'P' };
+    static const std::uint32_t s_shader_pack_version = 2;
+
+    static bool IsShaderFile(const std::filesystem::directory_entry& directory_entry)
+    {
+        return directory_entry.is_regular_file() && directory_entry.path().extension() == ".glsl";
+    }
+
+    // 目录清单: 按路径排序的所有 GLSL 文件的相对路径, 大小和修改时间,
+    // 文件被修改, 新增, 删除或重命名时哈希都会变化
+    static std::uint64_t ComputeManifestHash(const std::filesystem::path& source_directory)
+    {
+        std::vector<std::filesystem::directory_entry> entries;
+        std::error_code error;
+        for (std::filesystem::recursive_directory_iterator it(source_directory, error), end; !error && it != end; it.increment(error))
+        {
+            if (IsShaderFile(*it))
+            {
+                entries.push_back(*it);
+            }
+        }
+        std::sort(entries.begin(), entries.end());
+
+        std::uint64_t hash = FNV_OFFSET_BASIS;
+        for (const std::filesystem::directory_entry& entry : entries)
+        {
+            std::string name = entry.path().lexically_relative(source_directory).generic_string();
+            std::uint64_t size = entry.file_size(error);
+            std::int64_t write_time = static_cast<std::int64_t>(entry.last_write_time(error).time_since_epoch().count());
+            HashBytes(hash, name.data(), name.size() + 1);
+            HashBytes(hash, &size, sizeof(size));
+            HashBytes(hash, &write_time, sizeof(write_time));
+        }
+        return hash;
+    }
+
+    template <typename T>
+    static bool ReadValue(const char* data, size_t size, size_t& offset, T& value)
+    {
+        if (offset + sizeof(T) > size)
+        {
+            return false;
+        }
+        std::memcpy(&value, data + offset, sizeof(T));
+        offset += sizeof(T);
+        return true;
+    }
+
+    template <typename T>
+    static void WriteValue(std::ofstream& file, const T& value)
+    {
+        file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    static void WritePack(const std::filesystem::path& source_directory, const std::filesystem::path& pack_path, const std::filesystem::path& temp_path)
+    {
+        struct File
+        {
+            std::string name;
+            std::string source;
+        };
+
+        // 清单在读取文件之前计算, 打包过程中被修改的文件下次启动时会重新打包
+        std::uint64_t manifest_hash = ComputeManifestHash(source_directory);
+
+        std::vector<File> files;
+        for (const std::filesystem::directory_entry& directory_entry : std::filesystem::recursive_directory_iterator(source_directory))
+        {
+            if (!IsShaderFile(directory_entry))
+            {
+                continue;
+            }
+
+            std::ifstream shader_file(directory_entry.path(), std::ios::in | std::ios::binary | std::ios::ate);
+            if (!shader_file.is_open())
+            {
+                throw GLSLProgramException("无法打开着色器文件: " + directory_entry.path().string());
+            }
+
+            File file;
+            file.name = directory_entry.path().lexically_relative(source_directory).generic_string();
+            file.source.resize(static_cast<size_t>(shader_file.tellg()));
+            shader_file.seekg(0);
+            shader_file.read(file.source.data(), file.source.size());
+            files.push_back(std::move(file));
+        }
+
+        std::uint64_t data_offset = sizeof(s_shader_pack_magic) + sizeof(std::uint32_t) * 2 + sizeof(std::uint64_t);
+        for (const File& file : files)
+        {
+            data_offset += sizeof(std::uint32_t) + file.name.size() + sizeof(std::uint64_t) * 2;
+        }
+
+        // 先写入临时文件再重命名, 避免其它进程读到不完整的文件
+        if (pack_path.has_parent_path())
+        {
+            std::filesystem::create_directories(pack_path.parent_path());
+        }
+        {
+            std::ofstream pack_file(temp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+            if (!pack_file.is_open())
+            {
+                throw GLSLProgramException("无法创建着色器包: " + pack_path.string());
+            }
+
+            pack_file.write(s_shader_pack_magic, sizeof(s_shader_pack_magic));
+            WriteValue(pack_file, s_shader_pack_version);
+            WriteValue(pack_file, static_cast<std::uint32_t>(files.size()));
+            WriteValue(pack_file, manifest_hash);
+            for (const File& file : files)
+            {
+                WriteValue(pack_file, static_cast<std::uint32_t>(file.name.size()));
+                pack_file.write(file.name.data(), file.name.size());
+                WriteValue(pack_file, data_offset);
+                WriteValue(pack_file, static_cast<std::uint64_t>(file.source.size()));
+                data_offset += file.source.size();
+            }
+            for (const File& file : files)
+            {
+                pack_file.write(file.source.data(), file.source.size());
+            }
+
+            if (!pack_file.good())
+            {
+                throw GLSLProgramException("写入着色器包失败: " + pack_path.string());
+            }
+        }
+
+        std::filesystem::rename(temp_path, pack_path);
+    }
+
+    ShaderPack::ShaderPack()
+        : m_manifest_hash(0),
+          m_is_installed(false)
+    {
+
+    }
+
+    ShaderPack::~ShaderPack()
+    {
+        if (m_is_installed)
+        {
+            GLSLProgram::SetSourceLoader(nullptr);
+        }
+        Close();
+    }
+
+    bool ShaderPack::Open(const std::filesystem::path& pack_path, const std::filesystem::path& source_directory)
+    {
+        Close();
+
+        if (!m_file.Open(pack_path))
+        {
+            return false;
+        }
+
+        const char* data = m_file.GetData();
+        size_t size = m_file.GetSize();
+
+        // 校验文件头, 解析索引, 所有内容都直接引用映射的内存
+        size_t offset = 0;
+        char magic[4];
+        std::uint32_t version = 0;
+        std::uint32_t count = 0;
+        bool is_valid = offset + sizeof(magic) <= size;
+        if (is_valid)
+        {
+            std::memcpy(magic, data, sizeof(magic));
+            offset += sizeof(magic);
+            is_valid = std::memcmp(magic, s_shader_pack_magic, sizeof(magic)) == 0
+                && ReadValue(data, size, offset, version) && version == s_shader_pack_version
+                && ReadValue(data, size, offset, count)
+                && ReadValue(data, size, offset, m_manifest_hash);
+        }
+
+        for (std::uint32_t i = 0; is_valid && i < count; ++i)
+        {
+            std::uint32_t name_length = 0;
+            std::uint64_t data_offset = 0;
+            std::uint64_t data_size = 0;
+            is_valid = ReadValue(data, size, offset, name_length) && offset + name_length <= size;
+            if (!is_valid)
+            {
+                break;
+            }
+
+            std::string name(data + offset, name_length);
+            offset += name_length;
+            is_valid = ReadValue(data, size, offset, data_offset)
+                && ReadValue(data, size, offset, data_size)
+                && data_offset <= size && data_size <= size - data_offset;
+            if (is_valid)
+            {
+                m_entries[name] = std::string_view(data + data_offset, static_cast<size_t>(data_size));
+            }
+        }
+
+        if (!is_valid)
+        {
+            Close();
+            return false;
+        }
+
+        m_source_directory = source_directory.lexically_normal();
+        return true;
+    }
+
+    void ShaderPack::Close()
+    {
+        m_entries.clear();
+        m_manifest_hash = 0;
+        m_file.Close();
+    }
+
+    bool ShaderPack::Find(const std::filesystem::path& shader_file_path, std::string_view& source) const
+    {
+        if (m_entries.empty())
+        {
+            return false;
+        }
+
+        std::string name = shader_file_path.lexically_normal().lexically_relative(m_source_directory).generic_string();
+        std::unordered_map<std::string, std::string_view>::const_iterator it = m_entries.find(name);
+        if (it == m_entries.end())
+        {
+            return false;
+        }
+
+        source = it->second;
+        return true;
+    }
+
+    bool ShaderPack::IsStale() const
+    {
+        return !m_file.IsOpen() || ComputeManifestHash(m_source_directory) != m_manifest_hash;
+    }
+
+    void ShaderPack::Install()
+    {
+        GLSLProgram::SetSourceLoader([this](const std::filesystem::path& shader_file_path, std::string_view& source)
+        {
+            return Find(shader_file_path, source);
+        });
+        m_is_installed = true;
+    }
+
+    size_t ShaderPack::GetFileCount() const
+    {
+        return m_entries.size();
+    }
+
+    void ShaderPack::Build(const std::filesystem::path& source_directory, const std::filesystem::path& pack_path)
+    {
+        std::filesystem::path temp_path = pack_path;
+        temp_path += ".tmp";
+        try
+        {
+            WritePack(source_directory, pack_path, temp_path);
+        }
+        catch (const std::filesystem::filesystem_error& e)
+        {
+            // 遍历目录, 创建目录和重命名失败时抛出的是 filesystem_error, 统一转换为着色器异常
+            std::error_code error;
+            std::filesystem::remove(temp_path, error);
+            throw GLSLProgramException("生成着色器包失败: " + pack_path.string() + "\n" + e.what());
+        }
+    }
+}
@@ -0,0 +1,112 @@
+﻿#include "common/shader_variant_set.h"
+
+namespace glsl_shader
+{
+    ShaderVariantSet::ShaderVariantSet()
+        : m_program_cache(nullptr)
+    {
+
+    }
+
+    ShaderVariantSet::ShaderVariantSet(const std::vector<std::filesystem::path>& shader_file_paths)
+        : m_shader_file_paths(shader_file_paths),
+          m_program_cache(nullptr)
+    {
+
+    }
+
+    ShaderVariantSet::~ShaderVariantSet()
+    {
+
+    }
+
+    void ShaderVariantSet::AddShader(const std::filesystem::path& shader_file_path)
+    {
+        m_shader_file_paths.push_back(shader_file_path);
+    }
+
+    void ShaderVariantSet::SetProgramCache(ProgramCache* program_cache)
+    {
+        m_program_cache = program_cache;
+    }
+
+    size_t ShaderVariantSet::GetVariantHandle(const ShaderDefines& defines)
+    {
+        std::string key = GetDefinesKey(defines);
+        std::unordered_map<std::string, size_t>::iterator it = m_variant_indices.find(key);
+        if (it != m_variant_indices.end())
+        {
+            return it->second;
+        }
+
+        size_t handle = m_variants.size();
+        Variant variant;
+        variant.defines = defines;
+        m_variants.push_back(std::move(variant));
+        m_variant_indices[key] = handle;
+        return handle;
+    }
+
+    GLSLProgram& ShaderVariantSet::GetVariant(size_t handle)
+    {
+        if (handle >= m_variants.size())
+        {
+            throw GLSLProgramException("无效的着色器变体句柄");
+        }
+
+        Variant& variant = m_variants[handle];
+        if (variant.program == nullptr && m_program_cache != nullptr)
+        {
+            variant.program = m_program_cache->GetProgram(m_shader_file_paths, variant.defines);
+        }
+        else if (variant.program == nullptr)
+        {
+            std::shared_ptr<GLSLProgram> program = std::make_shared<GLSLProgram>();
+            program->SetDefines(variant.defines);
+            for (const std::filesystem::path& shader_file_path : m_shader_file_paths)
+            {
+                program->CompileShader(shader_file_path);
+            }
+            program->Link();
+            variant.program = std::move(program);
+        }
+
+        return *variant.program;
+    }
+
+    GLSLProgram& ShaderVariantSet::GetVariant(const ShaderDefines& defines)
+    {
+        return GetVariant(GetVariantHandle(defines));
+    }
+
+    size_t ShaderVariantSet::GetVariantCount() const
+    {
+        return m_variants.size();
+    }
+
+    size_t ShaderVariantSet::GetBuiltVariantCount() const
+    {
+        size_t count = 0;
+        for (const Variant& variant : m_variants)
+        {
+            if (variant.program != nullptr)
+            {
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    std::string ShaderVariantSet::GetDefinesKey(const ShaderDefines& defines)
+    {
+        std::string key;
+        for (const std::pair<const std::string, std::string>& define : defines)
+        {
+            key += define.first;
+            key += '=';
+            key += define.second;
+            key += ';';
+        }
+        return key;
+    }
+}
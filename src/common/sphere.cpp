@@ -7,7 +7,7 @@
 
 namespace glsl_shader
 {
-    Sphere::Sphere(float radius, GLuint slices_count, GLuint stacks_count)
+    Sphere::Sphere(float radius, GLuint slices_count, GLuint stacks_count, const VertexFormat& format)
     {
         int vertex_count = (slices_count + 1) * (stacks_count + 1);
         int index_count = (slices_count * 2 * (stacks_count - 1)) * 3;
@@ -15,7 +15,7 @@ namespace glsl_shader
         std::vector<GLfloat> positions(3 * vertex_count);
         std::vector<GLfloat> normals(3 * vertex_count);
         std::vector<GLfloat> uvs(2 * vertex_count);
-        std::vector<GLuint> indices(index_count);
+        std::vector<GLuint> indices;
 
         GLfloat theta = 0.0f;
         GLfloat phi = 0.0f;
@@ -53,41 +53,64 @@ namespace glsl_shader
             }
         }
 
-        index = 0;
-        for (GLuint i = 0; i < slices_count; ++i)
+        if (format.strips)
         {
-            GLuint stack_start = i * (stacks_count + 1);
-            GLuint next_stack_start = (i + 1) * (stacks_count + 1);
-            for (GLuint j = 0; j < stacks_count; ++j)
+            // 每个经度条一条三角形带, 两极处的退化三角形不会被光栅化
+            indices.reserve(slices_count * (2 * (stacks_count + 1) + 1));
+            for (GLuint i = 0; i < slices_count; ++i)
             {
-                if (j == 0)
+                GLuint stack_start = i * (stacks_count + 1);
+                GLuint next_stack_start = (i + 1) * (stacks_count + 1);
+                if (i > 0)
                 {
-                    indices[index] = stack_start;
-                    indices[index + 1] = stack_start + 1;
-                    indices[index + 2] = next_stack_start + 1;
-                    index += 3;
+                    indices.push_back(TriangleMesh::RESTART_INDEX);
                 }
-                else if (j == stacks_count - 1)
+                for (GLuint j = 0; j <= stacks_count; ++j)
                 {
-                    indices[index] = stack_start + j;
-                    indices[index + 1] = stack_start + j + 1;
-                    indices[index + 2] = next_stack_start + j;
-                    index += 3;
+                    indices.push_back(next_stack_start + j);
+                    indices.push_back(stack_start + j);
                 }
-                else
+            }
+        }
+        else
+        {
+            indices.resize(index_count);
+            index = 0;
+            for (GLuint i = 0; i < slices_count; ++i)
+            {
+                GLuint stack_start = i * (stacks_count + 1);
+                GLuint next_stack_start = (i + 1) * (stacks_count + 1);
+                for (GLuint j = 0; j < stacks_count; ++j)
                 {
-                    indices[index] = stack_start + j;
-                    indices[index + 1] = stack_start + j + 1;
-                    indices[index + 2] = next_stack_start + j + 1;
-                    indices[index + 3] = next_stack_start + j;
-                    indices[index + 4] = stack_start + j;
-                    indices[index + 5] = next_stack_start + j + 1;
-                    index += 6;
+                    if (j == 0)
+                    {
+                        indices[index] = stack_start;
+                        indices[index + 1] = stack_start + 1;
+                        indices[index + 2] = next_stack_start + 1;
+                        index += 3;
+                    }
+                    else if (j == stacks_count - 1)
+                    {
+                        indices[index] = stack_start + j;
+                        indices[index + 1] = stack_start + j + 1;
+                        indices[index + 2] = next_stack_start + j;
+                        index += 3;
+                    }
+                    else
+                    {
+                        indices[index] = stack_start + j;
+                        indices[index + 1] = stack_start + j + 1;
+                        indices[index + 2] = next_stack_start + j + 1;
+                        indices[index + 3] = next_stack_start + j;
+                        indices[index + 4] = stack_start + j;
+                        indices[index + 5] = next_stack_start + j + 1;
+                        index += 6;
+                    }
                 }
             }
         }
 
-        m_mesh.Init(&indices, &positions, &normals, &uvs);
+        m_mesh.Init(&indices, &positions, &normals, &uvs, nullptr, format, format.strips ? GL_TRIANGLE_STRIP : GL_TRIANGLES);
     }
 
     Sphere::~Sphere()
@@ -99,4 +122,9 @@ namespace glsl_shader
     {
         m_mesh.Render();
     }
+
+    const TriangleMesh& Sphere::GetMesh() const
+    {
+        return m_mesh;
+    }
 }
\ No newline at end of file
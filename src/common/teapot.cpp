@@ -7,18 +7,16 @@
 
 namespace glsl_shader
 {
-    Teapot::Teapot(int grid, const glm::mat4& transform)
+    Teapot::Teapot(int grid, const glm::mat4& transform, const VertexFormat& format)
     {
-        int vertex_count = 32 * (grid + 1) * (grid + 1);
-        int face_count = grid * grid * 32;
-        std::vector<GLfloat> positions(vertex_count * 3);
-        std::vector<GLfloat> normals(vertex_count * 3);
-        std::vector<GLfloat> uvs(vertex_count * 2);
-        std::vector<GLuint> indices(face_count * 6);
-
-        GeneratePatches(positions, normals, uvs, indices, grid);
-        MoveLid(grid, positions, transform);
-        m_mesh.Init(&indices, &positions, &normals, &uvs);
+        MeshArrays arrays;
+        Generate(grid, transform, format.strips, arrays);
+        m_mesh.Init(&arrays.indices, &arrays.positions, &arrays.normals, &arrays.uvs, nullptr, format, format.strips ? GL_TRIANGLE_STRIP : GL_TRIANGLES);
+    }
+
+    Teapot::Teapot()
+    {
+
     }
 
     Teapot::~Teapot()
@@ -31,6 +29,40 @@ namespace glsl_shader
         m_mesh.Render();
     }
 
+    std::shared_future<std::shared_ptr<Teapot>> Teapot::LoadAsync(AssetLoader& loader, int grid, const glm::mat4& transform, const VertexFormat& format)
+    {
+        return loader.Load<std::shared_ptr<Teapot>>([grid, transform, format]()
+        {
+            // 生成用的成员函数不访问 m_mesh, 上传前对象只在当前线程中使用
+            std::shared_ptr<Teapot> teapot(new Teapot());
+            std::shared_ptr<MeshArrays> arrays = std::make_shared<MeshArrays>();
+            teapot->Generate(grid, transform, format.strips, *arrays);
+            return std::function<std::shared_ptr<Teapot>()>([teapot, arrays, format]()
+            {
+                teapot->m_mesh.Init(&arrays->indices, &arrays->positions, &arrays->normals, &arrays->uvs, nullptr, format, format.strips ? GL_TRIANGLE_STRIP : GL_TRIANGLES);
+                return teapot;
+            });
+        });
+    }
+
+    void Teapot::Generate(int grid, const glm::mat4& transform, bool strips, MeshArrays& arrays)
+    {
+        int vertex_count = 32 * (grid + 1) * (grid + 1);
+        int face_count = grid * grid * 32;
+        arrays.positions.resize(vertex_count * 3);
+        arrays.normals.resize(vertex_count * 3);
+        arrays.uvs.resize(vertex_count * 2);
+        arrays.indices.resize(face_count * 6);
+
+        GeneratePatches(arrays.positions, arrays.normals, arrays.uvs, arrays.indices, grid);
+        MoveLid(grid, arrays.positions, transform);
+
+        if (strips)
+        {
+            BuildPatchStrips(arrays.indices, 32, grid);
+        }
+    }
+
     void Teapot::GeneratePatches
     (
         std::vector<GLfloat>& positions,
@@ -237,6 +269,31 @@ namespace glsl_shader
         }
     }
 
+    void Teapot::BuildPatchStrips(std::vector<GLuint>& indices, int patch_count, int grid)
+    {
+        // 每个面片的顶点是连续的 (grid + 1) x (grid + 1) 网格, 每行一条三角形带
+        indices.clear();
+        indices.reserve(patch_count * grid * (2 * (grid + 1) + 1));
+        for (int patch = 0; patch < patch_count; ++patch)
+        {
+            int start_index = patch * (grid + 1) * (grid + 1);
+            for (int i = 0; i < grid; ++i)
+            {
+                int i_start = i * (grid + 1) + start_index;
+                int next_i_start = (i + 1) * (grid + 1) + start_index;
+                if (!indices.empty())
+                {
+                    indices.push_back(TriangleMesh::RESTART_INDEX);
+                }
+                for (int j = 0; j <= grid; ++j)
+                {
+                    indices.push_back(next_i_start + j);
+                    indices.push_back(i_start + j);
+                }
+            }
+        }
+    }
+
     void Teapot::GetPatch(int patch_num, glm::vec3 patch[][4], bool reverse_v)
     {
         for (int u = 0; u < 4; ++u)
@@ -337,4 +394,9 @@ namespace glsl_shader
             positions[i + 2] = vertex.z;
         }
     }
+
+    const TriangleMesh& Teapot::GetMesh() const
+    {
+        return m_mesh;
+    }
 }
\ No newline at end of file
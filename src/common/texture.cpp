@@ -1,103 +1,486 @@
 ﻿#include "common/texture.h"
+#include "common/thread_pool.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GLSL_SHADER_USE_SSE
+#include <emmintrin.h>
+#endif
+
 namespace glsl_shader
 {
-    GLuint Texture::LoadTexture(const std::string& filename)
+    TextureFormat::TextureFormat()
+        : mipmaps(MipmapSource::Cpu),
+          srgb(true),
+          max_anisotropy(16.0f)
+    {
+
+    }
+
+    TextureFormat TextureFormat::Linear()
+    {
+        TextureFormat format;
+        format.srgb = false;
+        return format;
+    }
+
+    // 解码后的图像, pixels 为空表示解码失败
+    struct DecodedImage
+    {
+        int width;
+        int height;
+        std::shared_ptr<void> pixels;
+    };
+
+    typedef std::array<DecodedImage, 6> DecodedCubeMap;
+    // 第 0 级是解码出的图像, 后面是逐级缩小的 RGBA8 图像
+    typedef std::vector<DecodedImage> MipChain;
+
+    static const char* s_cube_map_suffixes[] = { "posx", "negx", "posy", "negy", "posz", "negz" };
+
+    // 翻转标志只对调用线程生效, 多个线程可以同时解码
+    static DecodedImage DecodeImage(const std::string& filename, bool flip)
     {
-        int width = 0;
-        int height = 0;
+        DecodedImage image = { 0, 0, nullptr };
         int channels = 0;
-        stbi_set_flip_vertically_on_load(1);
-        unsigned char* data = stbi_load(filename.c_str(), &width, &height, &channels, 4);
-        GLuint texture = 0;
+        stbi_set_flip_vertically_on_load_thread(flip ? 1 : 0);
+        unsigned char* data = stbi_load(filename.c_str(), &image.width, &image.height, &channels, 4);
         if (data != nullptr)
         {
-            glGenTextures(1, &texture);
-            glBindTexture(GL_TEXTURE_2D, texture);
-            glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, width, height);
-            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, data);
+            image.pixels.reset(data, stbi_image_free);
+        }
+        return image;
+    }
 
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    static DecodedImage DecodeHdrImage(const std::string& filename)
+    {
+        DecodedImage image = { 0, 0, nullptr };
+        int channels = 0;
+        stbi_set_flip_vertically_on_load_thread(0);
+        float* data = stbi_loadf(filename.c_str(), &image.width, &image.height, &channels, 3);
+        if (data != nullptr)
+        {
+            image.pixels.reset(data, stbi_image_free);
+        }
+        return image;
+    }
 
-            stbi_image_free(data);
+    // 六个面在共享线程池上同时解码, 各自写入 faces 中自己的位置, 耗时取决于最慢的一个面;
+    // ParallelFor 的调用线程也参与解码, 在异步加载的工作线程中调用不会死锁
+    static DecodedCubeMap DecodeCubeMap(const std::string& base_name, const std::string& extension, bool hdr)
+    {
+        DecodedCubeMap faces;
+        ThreadPool::GetShared().ParallelFor(faces.size(), [&](size_t i)
+        {
+            std::string texture_name = base_name + "_" + s_cube_map_suffixes[i] + extension;
+            faces[i] = hdr ? DecodeHdrImage(texture_name) : DecodeImage(texture_name, false);
+        });
+        return faces;
+    }
+
+    // 少于这个像素数的级别不值得分给线程池
+    static const size_t s_min_parallel_pixels = 64 * 64;
+    // 线性值转换到 sRGB 时查找表的精度, 暗部每一级小于 8 位 sRGB 的一个单位
+    static const int s_linear_to_srgb_steps = 4096;
+
+    static float SrgbToLinear(float value)
+    {
+        return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+    }
+
+    static float LinearToSrgb(float value)
+    {
+        return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+    }
+
+    // 8 位分量和线性 float 之间的查找表, 第一次生成 mipmap 时创建
+    struct MipmapTables
+    {
+        float srgb_to_linear[256];
+        float unorm_to_float[256];
+        unsigned char linear_to_srgb[s_linear_to_srgb_steps];
+
+        MipmapTables()
+        {
+            for (int i = 0; i < 256; ++i)
+            {
+                unorm_to_float[i] = i / 255.0f;
+                srgb_to_linear[i] = SrgbToLinear(unorm_to_float[i]);
+            }
+            for (int i = 0; i < s_linear_to_srgb_steps; ++i)
+            {
+                linear_to_srgb[i] = static_cast<unsigned char>(LinearToSrgb(i / float(s_linear_to_srgb_steps - 1)) * 255.0f + 0.5f);
+            }
         }
+    };
 
-        return texture;
+    static const MipmapTables& GetMipmapTables()
+    {
+        static const MipmapTables tables;
+        return tables;
     }
 
-    GLuint Texture::LoadCubeMap(const std::string& base_name, const std::string& extension)
+    // 一个线性空间的 RGBA 像素, SSE 下四个分量一起计算
+#ifdef GLSL_SHADER_USE_SSE
+    typedef __m128 LinearPixel;
+
+    static LinearPixel MakePixel(float r, float g, float b, float a)
     {
-        GLuint texture = 0;
-        const char* suffixes[] = { "posx", "negx", "posy", "negy", "posz", "negz" };
-        GLint width = 0;
-        GLint height = 0;
-        int channels = 0;
+        return _mm_setr_ps(r, g, b, a);
+    }
 
-        std::string texture_name = base_name + "_" + suffixes[0] + extension;
-        stbi_set_flip_vertically_on_load(0);
-        unsigned char* data = stbi_load(texture_name.c_str(), &width, &height, &channels, 4);
-        if (data)
+    static LinearPixel LoadPixel(const float* source)
+    {
+        return _mm_loadu_ps(source);
+    }
+
+    static void StorePixel(float* destination, LinearPixel value)
+    {
+        _mm_storeu_ps(destination, value);
+    }
+
+    static LinearPixel AveragePixels(LinearPixel p0, LinearPixel p1, LinearPixel p2, LinearPixel p3)
+    {
+        return _mm_mul_ps(_mm_add_ps(_mm_add_ps(p0, p1), _mm_add_ps(p2, p3)), _mm_set1_ps(0.25f));
+    }
+
+    static LinearPixel AddWeighted(LinearPixel sum, LinearPixel value, float weight)
+    {
+        return _mm_add_ps(sum, _mm_mul_ps(value, _mm_set1_ps(weight)));
+    }
+
+    static void EncodePixel(LinearPixel value, unsigned char* destination, bool srgb, const MipmapTables& tables)
+    {
+        const float srgb_scale = float(s_linear_to_srgb_steps - 1);
+        __m128 scale = srgb ? _mm_setr_ps(srgb_scale, srgb_scale, srgb_scale, 255.0f) : _mm_set1_ps(255.0f);
+        __m128 clamped = _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+        __m128i quantized = _mm_cvtps_epi32(_mm_mul_ps(clamped, scale));
+        if (srgb)
         {
-            glGenTextures(1, &texture);
-            glBindTexture(GL_TEXTURE_CUBE_MAP, texture);
+            alignas(16) int32_t indices[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(indices), quantized);
+            destination[0] = tables.linear_to_srgb[indices[0]];
+            destination[1] = tables.linear_to_srgb[indices[1]];
+            destination[2] = tables.linear_to_srgb[indices[2]];
+            destination[3] = static_cast<unsigned char>(indices[3]);
+        }
+        else
+        {
+            quantized = _mm_packs_epi32(quantized, quantized);
+            quantized = _mm_packus_epi16(quantized, quantized);
+            int32_t packed = _mm_cvtsi128_si32(quantized);
+            std::memcpy(destination, &packed, sizeof(packed));
+        }
+    }
+#else
+    struct LinearPixel
+    {
+        float channels[4];
+    };
+
+    static LinearPixel MakePixel(float r, float g, float b, float a)
+    {
+        return { { r, g, b, a } };
+    }
+
+    static LinearPixel LoadPixel(const float* source)
+    {
+        return { { source[0], source[1], source[2], source[3] } };
+    }
+
+    static void StorePixel(float* destination, const LinearPixel& value)
+    {
+        std::memcpy(destination, value.channels, sizeof(value.channels));
+    }
 
-            glTexStorage2D(GL_TEXTURE_CUBE_MAP, 1, GL_RGBA8, width, height);
-            glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, data);
-            stbi_image_free(data);
-            data = nullptr;
+    static LinearPixel AveragePixels(const LinearPixel& p0, const LinearPixel& p1, const LinearPixel& p2, const LinearPixel& p3)
+    {
+        LinearPixel result;
+        for (int i = 0; i < 4; ++i)
+        {
+            result.channels[i] = ((p0.channels[i] + p1.channels[i]) + (p2.channels[i] + p3.channels[i])) * 0.25f;
+        }
+        return result;
+    }
+
+    static LinearPixel AddWeighted(LinearPixel sum, const LinearPixel& value, float weight)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            sum.channels[i] += value.channels[i] * weight;
+        }
+        return sum;
+    }
 
-            for (int i = 1; i < 6; ++i)
+    static void EncodePixel(const LinearPixel& value, unsigned char* destination, bool srgb, const MipmapTables& tables)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            float clamped = std::min(std::max(value.channels[i], 0.0f), 1.0f);
+            if (srgb && i < 3)
+            {
+                destination[i] = tables.linear_to_srgb[static_cast<int>(clamped * (s_linear_to_srgb_steps - 1) + 0.5f)];
+            }
+            else
             {
-                texture_name = base_name + "_" + suffixes[i] + extension;
-                data = stbi_load(texture_name.c_str(), &width, &height, &channels, 4);
-                if (data)
+                destination[i] = static_cast<unsigned char>(clamped * 255.0f + 0.5f);
+            }
+        }
+    }
+#endif
+
+    // 一个方向上目标像素 i 使用的源像素和权重. 偶数尺寸时是 2i, 2i + 1 各占一半;
+    // 大于 1 的奇数尺寸 2n + 1 缩小到 n 时每个目标像素覆盖 2 + 1/n 个源像素,
+    // 用 2i, 2i + 1, 2i + 2 三个像素, 权重 (n - i, n, i + 1) / (2n + 1), 所有源像素的贡献相同
+    struct DownsampleTaps
+    {
+        int index[3];
+        float weight[3];
+        int count;
+    };
+
+    static DownsampleTaps GetDownsampleTaps(int source_size, int i)
+    {
+        DownsampleTaps taps = {};
+        if (source_size == 1)
+        {
+            taps.index[0] = 0;
+            taps.weight[0] = 1.0f;
+            taps.count = 1;
+        }
+        else if (source_size % 2 == 0)
+        {
+            taps.index[0] = i * 2;
+            taps.index[1] = i * 2 + 1;
+            taps.weight[0] = 0.5f;
+            taps.weight[1] = 0.5f;
+            taps.count = 2;
+        }
+        else
+        {
+            int n = source_size / 2;
+            float scale = 1.0f / float(source_size);
+            taps.index[0] = i * 2;
+            taps.index[1] = i * 2 + 1;
+            taps.index[2] = i * 2 + 2;
+            taps.weight[0] = float(n - i) * scale;
+            taps.weight[1] = float(n) * scale;
+            taps.weight[2] = float(i + 1) * scale;
+            taps.count = 3;
+        }
+        return taps;
+    }
+
+    // 把 [y_begin, y_end) 行中的每个像素按 GetDownsampleTaps 的权重从源图像中取平均, 两个方向都是偶数时就是 2x2 平均;
+    // 结果同时写成线性 float 供下一级使用, 和编码后的 RGBA8 供上传
+    template <typename Source>
+    static void DownsampleRows
+    (
+        const Source& source,
+        int source_width,
+        int source_height,
+        int width,
+        size_t y_begin,
+        size_t y_end,
+        float* linear,
+        unsigned char* encoded,
+        bool srgb,
+        const MipmapTables& tables
+    )
+    {
+        bool is_even = source_width % 2 == 0 && source_height % 2 == 0;
+        for (size_t y = y_begin; y < y_end; ++y)
+        {
+            DownsampleTaps y_taps = GetDownsampleTaps(source_height, static_cast<int>(y));
+            for (int x = 0; x < width; ++x)
+            {
+                LinearPixel value;
+                if (is_even)
                 {
-                    glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, data);
+                    int x0 = x * 2;
+                    int y0 = static_cast<int>(y * 2);
+                    value = AveragePixels(source(x0, y0), source(x0 + 1, y0), source(x0, y0 + 1), source(x0 + 1, y0 + 1));
                 }
-                stbi_image_free(data);
-                data = nullptr;
+                else
+                {
+                    DownsampleTaps x_taps = GetDownsampleTaps(source_width, x);
+                    value = MakePixel(0.0f, 0.0f, 0.0f, 0.0f);
+                    for (int j = 0; j < y_taps.count; ++j)
+                    {
+                        for (int i = 0; i < x_taps.count; ++i)
+                        {
+                            value = AddWeighted(value, source(x_taps.index[i], y_taps.index[j]), x_taps.weight[i] * y_taps.weight[j]);
+                        }
+                    }
+                }
+
+                size_t offset = (y * width + x) * 4;
+                StorePixel(linear + offset, value);
+                EncodePixel(value, encoded + offset, srgb, tables);
             }
         }
+    }
 
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    // 把 [0, height) 行分成若干块交给 body, 像素足够多时在线程池上并行处理
+    static void ForEachRowBlock(int width, int height, const std::function<void(size_t, size_t)>& body)
+    {
+        size_t row_count = height;
+        if (size_t(width) * row_count < s_min_parallel_pixels)
+        {
+            body(0, row_count);
+            return;
+        }
 
-        return texture;
+        ThreadPool& pool = ThreadPool::GetShared();
+        size_t block_count = std::min<size_t>(row_count, (pool.GetThreadCount() + 1) * 4);
+        pool.ParallelFor(block_count, [&](size_t block)
+        {
+            body(row_count * block / block_count, row_count * (block + 1) / block_count);
+        });
     }
 
-    GLuint Texture::LoadHdrCubeMap(const std::string& base_name)
+    // 逐级下采样到 1x1, 级与级之间顺序进行, 每级内部按行并行;
+    // 中间结果保留为线性 float, 每级都从上一级的 float 数据计算, 不会累积 8 位量化误差
+    static MipChain BuildMipChain(const DecodedImage& image, bool srgb)
+    {
+        MipChain levels(1, image);
+        if (image.pixels == nullptr)
+        {
+            return levels;
+        }
+
+        const MipmapTables& tables = GetMipmapTables();
+        const float* rgb_table = srgb ? tables.srgb_to_linear : tables.unorm_to_float;
+        const unsigned char* base_pixels = static_cast<const unsigned char*>(image.pixels.get());
+
+        std::vector<float> previous;
+        std::vector<float> current;
+        int width = image.width;
+        int height = image.height;
+        while (width > 1 || height > 1)
+        {
+            int level_width = std::max(1, width / 2);
+            int level_height = std::max(1, height / 2);
+            current.resize(size_t(level_width) * level_height * 4);
+            std::shared_ptr<unsigned char> encoded(new unsigned char[current.size()], std::default_delete<unsigned char[]>());
+
+            ForEachRowBlock(level_width, level_height, [&](size_t y_begin, size_t y_end)
+            {
+                if (levels.size() == 1)
+                {
+                    auto source = [&](int x, int y)
+                    {
+                        const unsigned char* pixel = base_pixels + (size_t(y) * width + x) * 4;
+                        return MakePixel(rgb_table[pixel[0]], rgb_table[pixel[1]], rgb_table[pixel[2]], tables.unorm_to_float[pixel[3]]);
+                    };
+                    DownsampleRows(source, width, height, level_width, y_begin, y_end, current.data(), encoded.get(), srgb, tables);
+                }
+                else
+                {
+                    auto source = [&](int x, int y)
+                    {
+                        return LoadPixel(previous.data() + (size_t(y) * width + x) * 4);
+                    };
+                    DownsampleRows(source, width, height, level_width, y_begin, y_end, current.data(), encoded.get(), srgb, tables);
+                }
+            });
+
+            levels.push_back({ level_width, level_height, encoded });
+            previous.swap(current);
+            width = level_width;
+            height = level_height;
+        }
+
+        return levels;
+    }
+
+    static MipChain DecodeTexture(const std::string& filename, const TextureFormat& format)
+    {
+        DecodedImage image = DecodeImage(filename, true);
+        if (format.mipmaps == TextureFormat::MipmapSource::Cpu)
+        {
+            return BuildMipChain(image, format.srgb);
+        }
+        return MipChain(1, image);
+    }
+
+    static GLsizei GetMipmapLevelCount(int width, int height)
+    {
+        GLsizei level_count = 1;
+        while (width > 1 || height > 1)
+        {
+            width = std::max(1, width / 2);
+            height = std::max(1, height / 2);
+            ++level_count;
+        }
+        return level_count;
+    }
+
+    // 各向异性过滤在 4.6 中进入核心, 更早的上下文中忽略
+    static void SetMaxAnisotropy(GLenum target, GLfloat max_anisotropy)
+    {
+        if (GLAD_GL_VERSION_4_6 && max_anisotropy > 1.0f)
+        {
+            GLfloat limit = 1.0f;
+            glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &limit);
+            glTexParameterf(target, GL_TEXTURE_MAX_ANISOTROPY, std::min(max_anisotropy, limit));
+        }
+    }
+
+    static GLuint UploadTexture(const MipChain& levels, const TextureFormat& format)
     {
         GLuint texture = 0;
-        const char* suffixes[] = { "posx", "negx", "posy", "negy", "posz", "negz" };
-        GLint width = 0;
-        GLint height = 0;
-        int channels = 0;
+        if (levels[0].pixels != nullptr)
+        {
+            GLsizei level_count = format.mipmaps == TextureFormat::MipmapSource::None ? 1 : GetMipmapLevelCount(levels[0].width, levels[0].height);
 
-        std::string texture_name = base_name + "_" + suffixes[0] + ".hdr";
-        float* data = stbi_loadf(texture_name.c_str(), &width, &height, &channels, 3);
-        if (data)
+            glGenTextures(1, &texture);
+            glBindTexture(GL_TEXTURE_2D, texture);
+            glTexStorage2D(GL_TEXTURE_2D, level_count, GL_RGBA8, levels[0].width, levels[0].height);
+            for (size_t i = 0; i < levels.size(); ++i)
+            {
+                glTexSubImage2D(GL_TEXTURE_2D, static_cast<GLint>(i), 0, 0, levels[i].width, levels[i].height, GL_RGBA, GL_UNSIGNED_BYTE, levels[i].pixels.get());
+            }
+            if (format.mipmaps == TextureFormat::MipmapSource::Gpu)
+            {
+                glGenerateMipmap(GL_TEXTURE_2D);
+            }
+
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, level_count > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+            SetMaxAnisotropy(GL_TEXTURE_2D, format.max_anisotropy);
+        }
+
+        return texture;
+    }
+
+    // 第一个面决定纹理的大小, 第一个面解码失败时不创建纹理, 其它面解码失败时跳过
+    static GLuint UploadCubeMap(const DecodedCubeMap& faces, GLenum internal_format, GLenum format, GLenum type)
+    {
+        GLuint texture = 0;
+        if (faces[0].pixels != nullptr)
         {
             glGenTextures(1, &texture);
             glBindTexture(GL_TEXTURE_CUBE_MAP, texture);
-            glTexStorage2D(GL_TEXTURE_CUBE_MAP, 1, GL_RGB32F, width, height);
-            glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X, 0, 0, 0, width, height, GL_RGB, GL_FLOAT, data);
-            stbi_image_free(data);
-            data = nullptr;
+            glTexStorage2D(GL_TEXTURE_CUBE_MAP, 1, internal_format, faces[0].width, faces[0].height);
 
-            for (int i = 1; i < 6; ++i)
+            for (int i = 0; i < 6; ++i)
             {
-                texture_name = base_name + "_" + suffixes[i] + ".hdr";
-                data = stbi_loadf(texture_name.c_str(), &width, &height, NULL, 3);
-                glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, 0, 0, width, height, GL_RGB, GL_FLOAT, data);
-                stbi_image_free(data);
-                data = nullptr;
+                if (faces[i].pixels != nullptr)
+                {
+                    glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, 0, 0, faces[i].width, faces[i].height, format, type, faces[i].pixels.get());
+                }
             }
         }
 
@@ -109,4 +492,46 @@ namespace glsl_shader
 
         return texture;
     }
+
+    GLuint Texture::LoadTexture(const std::string& filename, const TextureFormat& format)
+    {
+        return UploadTexture(DecodeTexture(filename, format), format);
+    }
+
+    GLuint Texture::LoadCubeMap(const std::string& base_name, const std::string& extension)
+    {
+        return UploadCubeMap(DecodeCubeMap(base_name, extension, false), GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE);
+    }
+
+    GLuint Texture::LoadHdrCubeMap(const std::string& base_name)
+    {
+        return UploadCubeMap(DecodeCubeMap(base_name, ".hdr", true), GL_RGB32F, GL_RGB, GL_FLOAT);
+    }
+
+    std::shared_future<GLuint> Texture::LoadTextureAsync(AssetLoader& loader, const std::string& filename, const TextureFormat& format)
+    {
+        return loader.Load<GLuint>([filename, format]()
+        {
+            MipChain levels = DecodeTexture(filename, format);
+            return std::function<GLuint()>([levels, format]() { return UploadTexture(levels, format); });
+        });
+    }
+
+    std::shared_future<GLuint> Texture::LoadCubeMapAsync(AssetLoader& loader, const std::string& base_name, const std::string& extension)
+    {
+        return loader.Load<GLuint>([base_name, extension]()
+        {
+            DecodedCubeMap faces = DecodeCubeMap(base_name, extension, false);
+            return std::function<GLuint()>([faces]() { return UploadCubeMap(faces, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE); });
+        });
+    }
+
+    std::shared_future<GLuint> Texture::LoadHdrCubeMapAsync(AssetLoader& loader, const std::string& base_name)
+    {
+        return loader.Load<GLuint>([base_name]()
+        {
+            DecodedCubeMap faces = DecodeCubeMap(base_name, ".hdr", true);
+            return std::function<GLuint()>([faces]() { return UploadCubeMap(faces, GL_RGB32F, GL_RGB, GL_FLOAT); });
+        });
+    }
 }
\ No newline at end of file
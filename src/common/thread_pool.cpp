@@ -0,0 +1,125 @@
+﻿#include "common/thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+
+namespace glsl_shader
+{
+    ThreadPool::ThreadPool(unsigned int thread_count)
+        : m_is_stopping(false)
+    {
+        if (thread_count == 0)
+        {
+            thread_count = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        m_threads.reserve(thread_count);
+        for (unsigned int i = 0; i < thread_count; ++i)
+        {
+            m_threads.emplace_back(&ThreadPool::WorkerLoop, this);
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_is_stopping = true;
+        }
+        m_condition.notify_all();
+
+        for (std::thread& thread : m_threads)
+        {
+            thread.join();
+        }
+    }
+
+    void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& body)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+
+        // 晚启动的辅助任务可能在 ParallelFor 返回后才执行, 共享状态由它们共同持有
+        struct State
+        {
+            std::function<void(size_t)> body;
+            size_t count;
+            std::atomic<size_t> next;
+            std::atomic<size_t> finished;
+            std::mutex mutex;
+            std::condition_variable condition;
+        };
+
+        std::shared_ptr<State> state = std::make_shared<State>();
+        state->body = body;
+        state->count = count;
+        state->next = 0;
+        state->finished = 0;
+
+        std::function<void()> run = [state]()
+        {
+            for (size_t i = state->next++; i < state->count; i = state->next++)
+            {
+                state->body(i);
+                if (++state->finished == state->count)
+                {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    state->condition.notify_all();
+                }
+            }
+        };
+
+        size_t helper_count = std::min(count, m_threads.size() + 1) - 1;
+        for (size_t i = 0; i < helper_count; ++i)
+        {
+            Enqueue(run);
+        }
+
+        run();
+
+        // 只等待所有元素执行完, 不等待辅助任务开始
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->condition.wait(lock, [&state]() { return state->finished == state->count; });
+    }
+
+    unsigned int ThreadPool::GetThreadCount() const
+    {
+        return static_cast<unsigned int>(m_threads.size());
+    }
+
+    ThreadPool& ThreadPool::GetShared()
+    {
+        static ThreadPool s_shared_pool;
+        return s_shared_pool;
+    }
+
+    void ThreadPool::Enqueue(std::function<void()> task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_tasks.push_back(std::move(task));
+        }
+        m_condition.notify_one();
+    }
+
+    void ThreadPool::WorkerLoop()
+    {
+        for (;;)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_condition.wait(lock, [this]() { return m_is_stopping || !m_tasks.empty(); });
+                if (m_is_stopping && m_tasks.empty())
+                {
+                    return;
+                }
+                task = std::move(m_tasks.front());
+                m_tasks.pop_front();
+            }
+            task();
+        }
+    }
+}
\ No newline at end of file
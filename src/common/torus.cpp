@@ -5,15 +5,69 @@
 
 namespace glsl_shader
 {
-    Torus::Torus(GLfloat outer_radius, GLfloat inner_radius, GLuint sides_count, GLuint rings_count)
+    Torus::Torus(GLfloat outer_radius, GLfloat inner_radius, GLuint sides_count, GLuint rings_count, const VertexFormat& format)
+    {
+        MeshArrays arrays;
+        Generate(outer_radius, inner_radius, sides_count, rings_count, format.strips, arrays);
+        m_mesh.Init(&arrays.indices, &arrays.positions, &arrays.normals, &arrays.uvs, nullptr, format, format.strips ? GL_TRIANGLE_STRIP : GL_TRIANGLES);
+    }
+
+    Torus::Torus()
+    {
+
+    }
+
+    Torus::~Torus()
+    {
+        m_mesh.Terminate();
+    }
+
+    void Torus::Render()
+    {
+        m_mesh.Render();
+    }
+
+    const TriangleMesh& Torus::GetMesh() const
+    {
+        return m_mesh;
+    }
+
+    std::shared_future<std::shared_ptr<Torus>> Torus::LoadAsync
+    (
+        AssetLoader& loader,
+        GLfloat outer_radius,
+        GLfloat inner_radius,
+        GLuint sides_count,
+        GLuint rings_count,
+        const VertexFormat& format
+    )
+    {
+        return loader.Load<std::shared_ptr<Torus>>([outer_radius, inner_radius, sides_count, rings_count, format]()
+        {
+            std::shared_ptr<MeshArrays> arrays = std::make_shared<MeshArrays>();
+            Generate(outer_radius, inner_radius, sides_count, rings_count, format.strips, *arrays);
+            return std::function<std::shared_ptr<Torus>()>([arrays, format]()
+            {
+                std::shared_ptr<Torus> torus(new Torus());
+                torus->m_mesh.Init(&arrays->indices, &arrays->positions, &arrays->normals, &arrays->uvs, nullptr, format, format.strips ? GL_TRIANGLE_STRIP : GL_TRIANGLES);
+                return torus;
+            });
+        });
+    }
+
+    void Torus::Generate(GLfloat outer_radius, GLfloat inner_radius, GLuint sides_count, GLuint rings_count, bool strips, MeshArrays& arrays)
     {
         GLuint faces = sides_count * rings_count;
         int vertex_count = sides_count * (rings_count + 1);
 
-        std::vector<GLfloat> positions(3 * vertex_count);
-        std::vector<GLfloat> normals(3 * vertex_count);
-        std::vector<GLfloat> uvs(2 * vertex_count);
-        std::vector<GLuint> indices(6 * faces);
+        std::vector<GLfloat>& positions = arrays.positions;
+        std::vector<GLfloat>& normals = arrays.normals;
+        std::vector<GLfloat>& uvs = arrays.uvs;
+        std::vector<GLuint>& indices = arrays.indices;
+        positions.resize(3 * vertex_count);
+        normals.resize(3 * vertex_count);
+        uvs.resize(2 * vertex_count);
+        indices.clear();
 
         float ring_factor = glm::two_pi<float>() / rings_count;
         float side_factor = glm::two_pi<float>() / sides_count;
@@ -48,35 +102,47 @@ namespace glsl_shader
             }
         }
 
-        index = 0;
-        for (GLuint ring = 0; ring < rings_count; ring++)
+        if (strips)
         {
-            GLuint ring_start = ring * sides_count;
-            GLuint next_ring_start = (ring + 1) * sides_count;
-            for (GLuint side = 0; side < sides_count; ++side)
+            // 每个环一条三角形带, 首尾相接, 环之间插入重启索引
+            indices.reserve(rings_count * (2 * (sides_count + 1) + 1));
+            for (GLuint ring = 0; ring < rings_count; ring++)
             {
-                int next_side = (side + 1) % sides_count;
-
-                indices[index] = ring_start + side;
-                indices[index + 1] = next_ring_start + side;
-                indices[index + 2] = next_ring_start + next_side;
-                indices[index + 3] = ring_start + side;
-                indices[index + 4] = next_ring_start + next_side;
-                indices[index + 5] = ring_start + next_side;
-                index += 6;
+                GLuint ring_start = ring * sides_count;
+                GLuint next_ring_start = (ring + 1) * sides_count;
+                if (ring > 0)
+                {
+                    indices.push_back(TriangleMesh::RESTART_INDEX);
+                }
+                for (GLuint side = 0; side <= sides_count; ++side)
+                {
+                    GLuint wrapped_side = side % sides_count;
+                    indices.push_back(ring_start + wrapped_side);
+                    indices.push_back(next_ring_start + wrapped_side);
+                }
             }
         }
+        else
+        {
+            indices.resize(6 * faces);
+            index = 0;
+            for (GLuint ring = 0; ring < rings_count; ring++)
+            {
+                GLuint ring_start = ring * sides_count;
+                GLuint next_ring_start = (ring + 1) * sides_count;
+                for (GLuint side = 0; side < sides_count; ++side)
+                {
+                    int next_side = (side + 1) % sides_count;
 
-        m_mesh.Init(&indices, &positions, &normals, &uvs);
-    }
-
-    Torus::~Torus()
-    {
-        m_mesh.Terminate();
-    }
-
-    void Torus::Render()
-    {
-        m_mesh.Render();
+                    indices[index] = ring_start + side;
+                    indices[index + 1] = next_ring_start + side;
+                    indices[index + 2] = next_ring_start + next_side;
+                    indices[index + 3] = ring_start + side;
+                    indices[index + 4] = next_ring_start + next_side;
+                    indices[index + 5] = ring_start + next_side;
+                    index += 6;
+                }
+            }
+        }
     }
 }
\ No newline at end of file
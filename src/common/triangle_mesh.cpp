@@ -1,10 +1,142 @@
 ﻿#include "common/triangle_mesh.h"
+#include "common/geometry_arena.h"
+#include "common/mesh_optimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
 
 namespace glsl_shader
 {
+    // float 转 half, 舍入到最近的偶数, 超出范围的值变为无穷大
+    static GLushort FloatToHalf(float value)
+    {
+        uint32_t bits = 0;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        uint32_t sign = (bits >> 16) & 0x8000u;
+        uint32_t magnitude = bits & 0x7FFFFFFFu;
+
+        if (magnitude >= 0x7F800000u)
+        {
+            return static_cast<GLushort>(sign | 0x7C00u | (magnitude > 0x7F800000u ? 0x0200u : 0u));
+        }
+
+        if (magnitude >= 0x477FF000u)
+        {
+            return static_cast<GLushort>(sign | 0x7C00u);
+        }
+
+        if (magnitude < 0x38800000u)
+        {
+            // half 的非规格化数
+            if (magnitude < 0x33000000u)
+            {
+                return static_cast<GLushort>(sign);
+            }
+
+            uint32_t exponent = magnitude >> 23;
+            uint32_t mantissa = (magnitude & 0x007FFFFFu) | 0x00800000u;
+            uint32_t shift = 126u - exponent;
+            uint32_t half = mantissa >> shift;
+            uint32_t remainder = mantissa & ((1u << shift) - 1u);
+            uint32_t halfway = 1u << (shift - 1u);
+            if (remainder > halfway || (remainder == halfway && (half & 1u) != 0))
+            {
+                ++half;
+            }
+            return static_cast<GLushort>(sign | half);
+        }
+
+        uint32_t half = (magnitude - 0x38000000u) >> 13;
+        uint32_t remainder = magnitude & 0x1FFFu;
+        if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u) != 0))
+        {
+            ++half;
+        }
+        return static_cast<GLushort>(sign | half);
+    }
+
+    static GLint ToSnorm(float value, float max_value)
+    {
+        return static_cast<GLint>(std::lround(std::min(std::max(value, -1.0f), 1.0f) * max_value));
+    }
+
+    // GL_INT_2_10_10_10_REV: x 在最低位, w 只有 2 位
+    static GLuint PackSnorm2101010Rev(float x, float y, float z, float w)
+    {
+        return (static_cast<GLuint>(ToSnorm(x, 511.0f)) & 0x3FFu) |
+               ((static_cast<GLuint>(ToSnorm(y, 511.0f)) & 0x3FFu) << 10) |
+               ((static_cast<GLuint>(ToSnorm(z, 511.0f)) & 0x3FFu) << 20) |
+               ((static_cast<GLuint>(ToSnorm(w, 1.0f)) & 0x3u) << 30);
+    }
+
+    static GLushort ToUnorm16(float value)
+    {
+        return static_cast<GLushort>(std::lround(std::min(std::max(value, 0.0f), 1.0f) * 65535.0f));
+    }
+
+    template <typename T>
+    static void NarrowIndices(const GLuint* indices, size_t count, void* destination)
+    {
+        T* narrowed = static_cast<T*>(destination);
+        for (size_t i = 0; i < count; ++i)
+        {
+            narrowed[i] = indices[i] == TriangleMesh::RESTART_INDEX ? std::numeric_limits<T>::max() : static_cast<T>(indices[i]);
+        }
+    }
+
+    template <typename T>
+    static void WidenIndices(const void* source, size_t count, std::pmr::vector<GLuint>& indices)
+    {
+        const T* narrowed = static_cast<const T*>(source);
+        indices.resize(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            indices[i] = narrowed[i] == std::numeric_limits<T>::max() ? TriangleMesh::RESTART_INDEX : static_cast<GLuint>(narrowed[i]);
+        }
+    }
+
+    VertexFormat::VertexFormat()
+        : interleaved(false),
+          position(PositionType::Float),
+          normal(NormalType::Float),
+          uv(UvType::Float),
+          optimize(false),
+          strips(false),
+          arena(nullptr)
+    {
+
+    }
+
+    VertexFormat VertexFormat::Compact(bool half_positions)
+    {
+        VertexFormat format;
+        format.interleaved = true;
+        format.position = half_positions ? PositionType::Half : PositionType::Float;
+        format.normal = NormalType::Packed;
+        format.uv = UvType::Half;
+        return format;
+    }
+
+    const GLuint TriangleMesh::RESTART_INDEX;
+
     TriangleMesh::TriangleMesh()
         : m_vao(0),
-          m_vertex_count(0)
+          m_vertex_count(0),
+          m_index_buffer(0),
+          m_index_type(GL_UNSIGNED_INT),
+          m_index_size(sizeof(GLuint)),
+          m_mode(GL_TRIANGLES),
+          m_attribute_buffers{ 0, 0, 0, 0 },
+          m_vertex_size(0),
+          m_vertex_buffer_size(0),
+          m_dequantize_transform(1.0f),
+          m_arena(nullptr),
+          m_base_vertex(0),
+          m_first_index(0)
     {
 
     }
@@ -20,7 +152,9 @@ namespace glsl_shader
         std::vector<GLfloat>* positions,
         std::vector<GLfloat>* normals,
         std::vector<GLfloat>* uvs,
-        std::vector<GLfloat>* tangents
+        std::vector<GLfloat>* tangents,
+        const VertexFormat& format,
+        GLenum mode
     )
     {
         if (indices == nullptr || positions == nullptr || normals == nullptr)
@@ -28,92 +162,449 @@ namespace glsl_shader
             return;
         }
 
+        // 优化器只处理三角形列表
+        if (format.optimize && mode == GL_TRIANGLES)
+        {
+            MeshOptimizer::Optimize(*indices, *positions, *normals, uvs, tangents);
+        }
+
+        MeshView view =
+        {
+            positions->size() / 3,
+            positions->data(),
+            normals->data(),
+            uvs != nullptr ? uvs->data() : nullptr,
+            tangents != nullptr ? tangents->data() : nullptr,
+            indices->size(),
+            GL_UNSIGNED_INT,
+            indices->data()
+        };
+        Init(view, format, mode);
+    }
+
+    void TriangleMesh::Init(const MeshView& view, const VertexFormat& format, GLenum mode, std::pmr::memory_resource* scratch)
+    {
+        if (view.indices == nullptr || view.positions == nullptr || view.normals == nullptr)
+        {
+            return;
+        }
+
         Terminate();
 
-        m_vertex_count = static_cast<GLuint>(indices->size());
+        m_vertex_count = static_cast<GLuint>(view.index_count);
+        m_mode = mode;
+
+        size_t vertex_count = view.vertex_count;
+        VertexAttribute attributes[ATTRIBUTE_COUNT] = {};
+        if (scratch == nullptr)
+        {
+            scratch = std::pmr::get_default_resource();
+        }
+        std::pmr::vector<unsigned char> vertex_data(scratch);
+
+        // 分配到几何缓冲时使用缓冲的格式, 所有属性都占位, 缺少的属性填 0
+        GeometryArena* arena = format.arena;
+        if (arena != nullptr)
+        {
+            m_format = arena->GetVertexFormat();
+            m_vertex_size = BuildVertexLayout(m_format, true, true, vertex_count, attributes);
+            EncodeVertices(m_format, attributes, view, vertex_data);
 
-        GLuint index_buffer_object = 0;
-        GLuint position_buffer_object = 0;
-        GLuint normal_buffer_object = 0;
-        GLuint uv_buffer_object = 0;
-        GLuint tangent_buffer_object = 0;
-        glGenBuffers(1, &index_buffer_object);
-        m_buffers.push_back(index_buffer_object);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer_object);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices->size() * sizeof(GLuint), indices->data(), GL_STATIC_DRAW);
+            // 几何缓冲只接受 32 位索引
+            std::pmr::vector<GLuint> wide_indices(scratch);
+            const GLuint* arena_indices = static_cast<const GLuint*>(view.indices);
+            if (view.index_type != GL_UNSIGNED_INT)
+            {
+                if (view.index_type == GL_UNSIGNED_BYTE)
+                {
+                    WidenIndices<GLubyte>(view.indices, view.index_count, wide_indices);
+                }
+                else
+                {
+                    WidenIndices<GLushort>(view.indices, view.index_count, wide_indices);
+                }
+                arena_indices = wide_indices.data();
+            }
 
-        glGenBuffers(1, &position_buffer_object);
-        m_buffers.push_back(position_buffer_object);
-        glBindBuffer(GL_ARRAY_BUFFER, position_buffer_object);
-        glBufferData(GL_ARRAY_BUFFER, positions->size() * sizeof(GLfloat), positions->data(), GL_STATIC_DRAW);
+            // 空间不足时抛出异常, 网格不会悄悄退回独立缓冲
+            arena->Allocate(vertex_data.data(), vertex_count, arena_indices, view.index_count, m_base_vertex, m_first_index);
+            m_arena = arena;
+            m_vao = arena->GetVAO();
+            m_index_buffer = arena->GetIndexBuffer();
+            m_index_type = GL_UNSIGNED_INT;
+            m_index_size = sizeof(GLuint);
+            m_vertex_buffer_size = m_vertex_size * vertex_count;
+            m_attribute_buffers[ATTRIBUTE_POSITION] = arena->GetVertexBuffer();
+            m_attribute_buffers[ATTRIBUTE_NORMAL] = arena->GetVertexBuffer();
+            m_attribute_buffers[ATTRIBUTE_UV] = view.uvs != nullptr ? arena->GetVertexBuffer() : 0;
+            m_attribute_buffers[ATTRIBUTE_TANGENT] = view.tangents != nullptr ? arena->GetVertexBuffer() : 0;
+            return;
+        }
 
-        glGenBuffers(1, &normal_buffer_object);
-        m_buffers.push_back(normal_buffer_object);
-        glBindBuffer(GL_ARRAY_BUFFER, normal_buffer_object);
-        glBufferData(GL_ARRAY_BUFFER, normals->size() * sizeof(GLfloat), normals->data(), GL_STATIC_DRAW);
+        m_format = format;
+        m_vertex_size = BuildVertexLayout(format, view.uvs != nullptr, view.tangents != nullptr, vertex_count, attributes);
+        m_vertex_buffer_size = m_vertex_size * vertex_count;
 
-        if (uvs != nullptr)
+        // 独立缓冲的属性全部是 float 时布局与源数据相同, 不需要编码
+        const void* sources[ATTRIBUTE_COUNT] = { view.positions, view.normals, view.uvs, view.tangents };
+        bool direct = !format.interleaved;
+        for (int index = 0; index < ATTRIBUTE_COUNT; ++index)
         {
-            glGenBuffers(1, &uv_buffer_object);
-            m_buffers.push_back(uv_buffer_object);
-            glBindBuffer(GL_ARRAY_BUFFER, uv_buffer_object);
-            glBufferData(GL_ARRAY_BUFFER, uvs->size() * sizeof(GLfloat), uvs->data(), GL_STATIC_DRAW);
+            direct = direct && (!attributes[index].enabled || attributes[index].type == GL_FLOAT);
+        }
+        if (!direct)
+        {
+            EncodeVertices(format, attributes, view, vertex_data);
         }
 
-        if (tangents != nullptr)
+        // 已经压缩过的索引直接上传, 32 位索引按最大索引重新选择类型
+        std::pmr::vector<unsigned char> index_data(scratch);
+        const void* index_source = view.indices;
+        m_index_type = view.index_type;
+        if (m_index_type == GL_UNSIGNED_INT)
         {
-            glGenBuffers(1, &tangent_buffer_object);
-            m_buffers.push_back(tangent_buffer_object);
-            glBindBuffer(GL_ARRAY_BUFFER, tangent_buffer_object);
-            glBufferData(GL_ARRAY_BUFFER, tangents->size() * sizeof(GLfloat), tangents->data(), GL_STATIC_DRAW);
+            m_index_type = SelectIndexType(static_cast<const GLuint*>(view.indices), view.index_count);
+            if (m_index_type != GL_UNSIGNED_INT)
+            {
+                index_data.resize(view.index_count * GetIndexTypeSize(m_index_type));
+                ConvertIndices(static_cast<const GLuint*>(view.indices), view.index_count, m_index_type, index_data.data());
+                index_source = index_data.data();
+            }
+        }
+        m_index_size = GetIndexTypeSize(m_index_type);
+
+        glGenBuffers(1, &m_index_buffer);
+        m_buffers.push_back(m_index_buffer);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_index_buffer);
+        glBufferStorage(GL_ELEMENT_ARRAY_BUFFER, view.index_count * m_index_size, index_source, 0);
+
+        if (format.interleaved)
+        {
+            GLuint vertex_buffer_object = 0;
+            glGenBuffers(1, &vertex_buffer_object);
+            m_buffers.push_back(vertex_buffer_object);
+            glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_object);
+            glBufferStorage(GL_ARRAY_BUFFER, vertex_data.size(), vertex_data.data(), 0);
+
+            for (int index = 0; index < ATTRIBUTE_COUNT; ++index)
+            {
+                m_attribute_buffers[index] = attributes[index].enabled ? vertex_buffer_object : 0;
+            }
+        }
+        else
+        {
+            for (int index = 0; index < ATTRIBUTE_COUNT; ++index)
+            {
+                const VertexAttribute& attribute = attributes[index];
+                if (!attribute.enabled)
+                {
+                    continue;
+                }
+
+                const void* source = direct ? sources[index] : vertex_data.data() + attribute.offset;
+                GLuint buffer_object = 0;
+                glGenBuffers(1, &buffer_object);
+                m_buffers.push_back(buffer_object);
+                glBindBuffer(GL_ARRAY_BUFFER, buffer_object);
+                glBufferStorage(GL_ARRAY_BUFFER, attribute.bytes * vertex_count, source, 0);
+                m_attribute_buffers[index] = buffer_object;
+            }
         }
 
         glGenVertexArrays(1, &m_vao);
         glBindVertexArray(m_vao);
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer_object);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_index_buffer);
 
-        glBindBuffer(GL_ARRAY_BUFFER, position_buffer_object);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
-        glEnableVertexAttribArray(0);
+        for (int index = 0; index < ATTRIBUTE_COUNT; ++index)
+        {
+            const VertexAttribute& attribute = attributes[index];
+            if (!attribute.enabled)
+            {
+                continue;
+            }
 
-        glBindBuffer(GL_ARRAY_BUFFER, normal_buffer_object);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, 0);
-        glEnableVertexAttribArray(1);
+            GLsizei stride = format.interleaved ? m_vertex_size : 0;
+            size_t offset = format.interleaved ? attribute.offset : 0;
+            glBindBuffer(GL_ARRAY_BUFFER, m_attribute_buffers[index]);
+            glVertexAttribPointer(index, attribute.size, attribute.type, attribute.normalized, stride, reinterpret_cast<const void*>(offset));
+            glEnableVertexAttribArray(index);
+        }
+
+        glBindVertexArray(0);
+    }
 
-        if (uvs != nullptr)
+    GLsizei TriangleMesh::BuildVertexLayout
+    (
+        const VertexFormat& format,
+        bool has_uvs,
+        bool has_tangents,
+        size_t vertex_count,
+        VertexAttribute attributes[ATTRIBUTE_COUNT]
+    )
+    {
+        for (int index = 0; index < ATTRIBUTE_COUNT; ++index)
         {
-            glBindBuffer(GL_ARRAY_BUFFER, uv_buffer_object);
-            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, 0);
-            glEnableVertexAttribArray(2);
+            attributes[index] = VertexAttribute{ false, 0, GL_FLOAT, GL_FALSE, 0, 0 };
         }
 
-        if (tangents != nullptr)
+        attributes[ATTRIBUTE_POSITION] = format.position == VertexFormat::PositionType::Half ?
+            VertexAttribute{ true, 4, GL_HALF_FLOAT, GL_FALSE, 8, 0 } :
+            VertexAttribute{ true, 3, GL_FLOAT, GL_FALSE, 12, 0 };
+
+        attributes[ATTRIBUTE_NORMAL] = format.normal == VertexFormat::NormalType::Packed ?
+            VertexAttribute{ true, 4, GL_INT_2_10_10_10_REV, GL_TRUE, 4, 0 } :
+            VertexAttribute{ true, 3, GL_FLOAT, GL_FALSE, 12, 0 };
+
+        if (has_uvs)
         {
-            glBindBuffer(GL_ARRAY_BUFFER, tangent_buffer_object);
-            glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, 0, 0);
-            glEnableVertexAttribArray(3);
+            switch (format.uv)
+            {
+            case VertexFormat::UvType::Half:
+                attributes[ATTRIBUTE_UV] = VertexAttribute{ true, 2, GL_HALF_FLOAT, GL_FALSE, 4, 0 };
+                break;
+            case VertexFormat::UvType::Unorm16:
+                attributes[ATTRIBUTE_UV] = VertexAttribute{ true, 2, GL_UNSIGNED_SHORT, GL_TRUE, 4, 0 };
+                break;
+            default:
+                attributes[ATTRIBUTE_UV] = VertexAttribute{ true, 2, GL_FLOAT, GL_FALSE, 8, 0 };
+                break;
+            }
         }
 
-        glBindVertexArray(0);
+        if (has_tangents)
+        {
+            attributes[ATTRIBUTE_TANGENT] = format.normal == VertexFormat::NormalType::Packed ?
+                VertexAttribute{ true, 4, GL_INT_2_10_10_10_REV, GL_TRUE, 4, 0 } :
+                VertexAttribute{ true, 4, GL_FLOAT, GL_FALSE, 16, 0 };
+        }
+
+        GLsizei vertex_size = 0;
+        for (int index = 0; index < ATTRIBUTE_COUNT; ++index)
+        {
+            VertexAttribute& attribute = attributes[index];
+            if (attribute.enabled)
+            {
+                attribute.offset = format.interleaved ? vertex_size : vertex_size * vertex_count;
+                vertex_size += attribute.bytes;
+            }
+        }
+
+        return vertex_size;
+    }
+
+    GLenum TriangleMesh::SelectIndexType(const GLuint* indices, size_t count)
+    {
+        GLuint max_index = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (indices[i] != RESTART_INDEX)
+            {
+                max_index = std::max(max_index, indices[i]);
+            }
+        }
+
+        if (max_index < 0xFF)
+        {
+            return GL_UNSIGNED_BYTE;
+        }
+        if (max_index < 0xFFFF)
+        {
+            return GL_UNSIGNED_SHORT;
+        }
+        return GL_UNSIGNED_INT;
+    }
+
+    GLsizei TriangleMesh::GetIndexTypeSize(GLenum type)
+    {
+        switch (type)
+        {
+        case GL_UNSIGNED_BYTE:  return sizeof(GLubyte);
+        case GL_UNSIGNED_SHORT: return sizeof(GLushort);
+        default:                return sizeof(GLuint);
+        }
+    }
+
+    void TriangleMesh::ConvertIndices(const GLuint* indices, size_t count, GLenum type, void* destination)
+    {
+        switch (type)
+        {
+        case GL_UNSIGNED_BYTE:  NarrowIndices<GLubyte>(indices, count, destination); break;
+        case GL_UNSIGNED_SHORT: NarrowIndices<GLushort>(indices, count, destination); break;
+        default:                NarrowIndices<GLuint>(indices, count, destination); break;
+        }
+    }
+
+    void TriangleMesh::EncodeVertices
+    (
+        const VertexFormat& format,
+        const VertexAttribute attributes[ATTRIBUTE_COUNT],
+        const MeshView& view,
+        std::pmr::vector<unsigned char>& vertex_data
+    )
+    {
+        size_t vertex_count = view.vertex_count;
+        const GLfloat* positions = view.positions;
+
+        // 位置量化到 [-1, 1], 所有轴使用同一个缩放, 保证法线矩阵不受影响
+        glm::vec3 center(0.0f);
+        float scale = 1.0f;
+        m_dequantize_transform = glm::mat4(1.0f);
+        if (format.position == VertexFormat::PositionType::Half && vertex_count > 0)
+        {
+            glm::vec3 min_position(positions[0], positions[1], positions[2]);
+            glm::vec3 max_position = min_position;
+            for (size_t i = 0; i < vertex_count; ++i)
+            {
+                glm::vec3 p(positions[i * 3], positions[i * 3 + 1], positions[i * 3 + 2]);
+                min_position = glm::min(min_position, p);
+                max_position = glm::max(max_position, p);
+            }
+
+            center = 0.5f * (min_position + max_position);
+            glm::vec3 extent = 0.5f * (max_position - min_position);
+            scale = std::max(extent.x, std::max(extent.y, extent.z));
+            if (scale <= 0.0f)
+            {
+                scale = 1.0f;
+            }
+
+            m_dequantize_transform = glm::mat4(scale);
+            m_dequantize_transform[3] = glm::vec4(center, 1.0f);
+        }
+
+        GLsizei vertex_size = 0;
+        for (int index = 0; index < ATTRIBUTE_COUNT; ++index)
+        {
+            vertex_size += attributes[index].enabled ? attributes[index].bytes : 0;
+        }
+
+        vertex_data.assign(vertex_size * vertex_count, 0);
+        for (int index = 0; index < ATTRIBUTE_COUNT; ++index)
+        {
+            const VertexAttribute& attribute = attributes[index];
+            if (!attribute.enabled || (index == ATTRIBUTE_UV && view.uvs == nullptr))
+            {
+                continue;
+            }
+
+            size_t stride = format.interleaved ? vertex_size : attribute.bytes;
+            unsigned char* destination = vertex_data.data() + attribute.offset;
+
+            for (size_t i = 0; i < vertex_count; ++i, destination += stride)
+            {
+                switch (index)
+                {
+                case ATTRIBUTE_POSITION:
+                {
+                    const GLfloat* p = positions + i * 3;
+                    if (attribute.type == GL_HALF_FLOAT)
+                    {
+                        GLushort packed[4] =
+                        {
+                            FloatToHalf((p[0] - center.x) / scale),
+                            FloatToHalf((p[1] - center.y) / scale),
+                            FloatToHalf((p[2] - center.z) / scale),
+                            FloatToHalf(1.0f)
+                        };
+                        std::memcpy(destination, packed, sizeof(packed));
+                    }
+                    else
+                    {
+                        std::memcpy(destination, p, 3 * sizeof(GLfloat));
+                    }
+                    break;
+                }
+                case ATTRIBUTE_NORMAL:
+                {
+                    const GLfloat* n = view.normals + i * 3;
+                    if (attribute.type == GL_INT_2_10_10_10_REV)
+                    {
+                        GLuint packed = PackSnorm2101010Rev(n[0], n[1], n[2], 0.0f);
+                        std::memcpy(destination, &packed, sizeof(packed));
+                    }
+                    else
+                    {
+                        std::memcpy(destination, n, 3 * sizeof(GLfloat));
+                    }
+                    break;
+                }
+                case ATTRIBUTE_UV:
+                {
+                    const GLfloat* uv = view.uvs + i * 2;
+                    if (attribute.type == GL_HALF_FLOAT)
+                    {
+                        GLushort packed[2] = { FloatToHalf(uv[0]), FloatToHalf(uv[1]) };
+                        std::memcpy(destination, packed, sizeof(packed));
+                    }
+                    else if (attribute.type == GL_UNSIGNED_SHORT)
+                    {
+                        GLushort packed[2] = { ToUnorm16(uv[0]), ToUnorm16(uv[1]) };
+                        std::memcpy(destination, packed, sizeof(packed));
+                    }
+                    else
+                    {
+                        std::memcpy(destination, uv, 2 * sizeof(GLfloat));
+                    }
+                    break;
+                }
+                case ATTRIBUTE_TANGENT:
+                {
+                    // 缺少切线时与未启用属性的默认值 (0, 0, 0, 1) 一致
+                    static const GLfloat default_tangent[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+                    const GLfloat* t = view.tangents != nullptr ? view.tangents + i * 4 : default_tangent;
+                    if (attribute.type == GL_INT_2_10_10_10_REV)
+                    {
+                        GLuint packed = PackSnorm2101010Rev(t[0], t[1], t[2], t[3]);
+                        std::memcpy(destination, &packed, sizeof(packed));
+                    }
+                    else
+                    {
+                        std::memcpy(destination, t, 4 * sizeof(GLfloat));
+                    }
+                    break;
+                }
+                }
+            }
+        }
     }
 
     void TriangleMesh::Terminate()
     {
+        // 几何缓冲中的网格不拥有缓冲和 VAO, 几何缓冲只追加不回收, 占用的空间在几何缓冲 Terminate 时才释放
         if (!m_buffers.empty())
         {
             glDeleteBuffers(static_cast<GLsizei>(m_buffers.size()), m_buffers.data());
             m_buffers.clear();
         }
 
-        if (m_vao != 0)
+        if (m_vao != 0 && m_arena == nullptr)
         {
             glDeleteVertexArrays(1, &m_vao);
-            m_vao = 0;
         }
+        m_vao = 0;
+
+        for (GLuint& buffer : m_attribute_buffers)
+        {
+            buffer = 0;
+        }
+        m_index_buffer = 0;
+        m_index_type = GL_UNSIGNED_INT;
+        m_index_size = sizeof(GLuint);
+        m_mode = GL_TRIANGLES;
+        m_vertex_size = 0;
+        m_vertex_buffer_size = 0;
+        m_arena = nullptr;
+        m_base_vertex = 0;
+        m_first_index = 0;
     }
 
-    void TriangleMesh::Render()
+    void TriangleMesh::Render() const
+    {
+        Render(m_mode);
+    }
+
+    void TriangleMesh::Render(GLenum mode) const
     {
         if (m_vao == 0)
         {
@@ -121,41 +612,156 @@ namespace glsl_shader
         }
 
         glBindVertexArray(m_vao);
-        glDrawElements(GL_TRIANGLES, m_vertex_count, GL_UNSIGNED_INT, 0);
+        Draw(mode);
         glBindVertexArray(0);
     }
 
-    GLuint TriangleMesh::GetVAO() const
+    void TriangleMesh::Draw() const
     {
-        return m_vao;
+        Draw(m_mode);
+    }
+
+    void TriangleMesh::Draw(GLenum mode) const
+    {
+        if (m_vao == 0)
+        {
+            return;
+        }
+
+        const void* first_index = reinterpret_cast<const void*>(static_cast<size_t>(m_first_index) * m_index_size);
+        if (mode == GL_TRIANGLE_STRIP)
+        {
+            glEnable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+        }
+
+        glDrawElementsBaseVertex(mode, m_vertex_count, m_index_type, first_index, m_base_vertex);
+
+        if (mode == GL_TRIANGLE_STRIP)
+        {
+            glDisable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+        }
     }
 
-    GLuint TriangleMesh::GetIndexBufferObject()
+    void TriangleMesh::RenderInstanced(GLsizei instance_count, GLuint base_instance) const
     {
-        return m_buffers[0];
+        RenderInstanced(instance_count, base_instance, m_mode);
     }
 
-    GLuint TriangleMesh::GetPositionBufferObject()
+    void TriangleMesh::RenderInstanced(GLsizei instance_count, GLuint base_instance, GLenum mode) const
     {
-        return m_buffers[1];
+        if (m_vao == 0)
+        {
+            return;
+        }
+
+        glBindVertexArray(m_vao);
+        DrawInstanced(instance_count, base_instance, mode);
+        glBindVertexArray(0);
     }
 
-    GLuint TriangleMesh::GetNormalBufferObject()
+    void TriangleMesh::DrawInstanced(GLsizei instance_count, GLuint base_instance) const
     {
-        return m_buffers[2];
+        DrawInstanced(instance_count, base_instance, m_mode);
     }
 
-    GLuint TriangleMesh::GetUvBufferObject()
+    void TriangleMesh::DrawInstanced(GLsizei instance_count, GLuint base_instance, GLenum mode) const
     {
-        if (m_buffers.size() >= 3)
+        if (m_vao == 0 || instance_count <= 0)
+        {
+            return;
+        }
+
+        const void* first_index = reinterpret_cast<const void*>(static_cast<size_t>(m_first_index) * m_index_size);
+        if (mode == GL_TRIANGLE_STRIP)
         {
-            return m_buffers[3];
+            glEnable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
         }
-        return 0;
+
+        glDrawElementsInstancedBaseVertexBaseInstance(mode, m_vertex_count, m_index_type, first_index, instance_count, m_base_vertex, base_instance);
+
+        if (mode == GL_TRIANGLE_STRIP)
+        {
+            glDisable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+        }
+    }
+
+    GLuint TriangleMesh::GetVAO() const
+    {
+        return m_vao;
+    }
+
+    GLuint TriangleMesh::GetIndexBufferObject() const
+    {
+        return m_index_buffer;
     }
 
-    GLuint TriangleMesh::GetVertexCount()
+    GLenum TriangleMesh::GetIndexType() const
+    {
+        return m_index_type;
+    }
+
+    size_t TriangleMesh::GetIndexBufferSize() const
+    {
+        return static_cast<size_t>(m_vertex_count) * m_index_size;
+    }
+
+    GLenum TriangleMesh::GetPrimitiveMode() const
+    {
+        return m_mode;
+    }
+
+    GLuint TriangleMesh::GetPositionBufferObject() const
+    {
+        return m_attribute_buffers[ATTRIBUTE_POSITION];
+    }
+
+    GLuint TriangleMesh::GetNormalBufferObject() const
+    {
+        return m_attribute_buffers[ATTRIBUTE_NORMAL];
+    }
+
+    GLuint TriangleMesh::GetUvBufferObject() const
+    {
+        return m_attribute_buffers[ATTRIBUTE_UV];
+    }
+
+    GLuint TriangleMesh::GetVertexCount() const
     {
         return m_vertex_count;
     }
+
+    const VertexFormat& TriangleMesh::GetVertexFormat() const
+    {
+        return m_format;
+    }
+
+    GLsizei TriangleMesh::GetVertexSize() const
+    {
+        return m_vertex_size;
+    }
+
+    size_t TriangleMesh::GetVertexBufferSize() const
+    {
+        return m_vertex_buffer_size;
+    }
+
+    const glm::mat4& TriangleMesh::GetDequantizeTransform() const
+    {
+        return m_dequantize_transform;
+    }
+
+    GeometryArena* TriangleMesh::GetGeometryArena() const
+    {
+        return m_arena;
+    }
+
+    GLint TriangleMesh::GetBaseVertex() const
+    {
+        return m_base_vertex;
+    }
+
+    GLuint TriangleMesh::GetFirstIndex() const
+    {
+        return m_first_index;
+    }
 }
\ No newline at end of file
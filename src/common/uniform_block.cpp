@@ -0,0 +1,248 @@
+﻿#include "common/uniform_block.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+
+namespace glsl_shader
+{
+    UniformBlock::UniformBlock()
+        : m_buffer(0),
+          m_binding(0),
+          m_dirty_begin(0),
+          m_dirty_end(0)
+    {
+
+    }
+
+    UniformBlock::~UniformBlock()
+    {
+        Terminate();
+    }
+
+    void UniformBlock::Init(GLSLProgram& program, const char* block_name, GLuint binding)
+    {
+        Terminate();
+
+        GLuint handle = program.GetHandle();
+        GLuint block_index = glGetProgramResourceIndex(handle, GL_UNIFORM_BLOCK, block_name);
+        if (block_index == GL_INVALID_INDEX)
+        {
+            throw GLSLProgramException(std::string("uniform block 不存在: ") + block_name);
+        }
+
+        GLenum block_properties[] = { GL_BUFFER_DATA_SIZE, GL_NUM_ACTIVE_VARIABLES };
+        GLint block_info[2] = { 0, 0 };
+        glGetProgramResourceiv(handle, GL_UNIFORM_BLOCK, block_index, 2, block_properties, 2, nullptr, block_info);
+        m_data.assign(block_info[0], 0);
+
+        std::vector<GLint> uniform_indices(block_info[1]);
+        GLenum block_index_property = GL_ACTIVE_VARIABLES;
+        glGetProgramResourceiv(handle, GL_UNIFORM_BLOCK, block_index, 1, &block_index_property, block_info[1], nullptr, uniform_indices.data());
+
+        GLenum properties[] = { GL_NAME_LENGTH, GL_TYPE, GL_OFFSET, GL_ARRAY_SIZE, GL_ARRAY_STRIDE, GL_MATRIX_STRIDE, GL_IS_ROW_MAJOR };
+        for (GLint uniform_index : uniform_indices)
+        {
+            GLint result[7] = { 0, 0, 0, 0, 0, 0, 0 };
+            glGetProgramResourceiv(handle, GL_UNIFORM, uniform_index, 7, properties, 7, nullptr, result);
+
+            std::string name(result[0], '\0');
+            glGetProgramResourceName(handle, GL_UNIFORM, uniform_index, result[0], nullptr, name.data());
+            name.resize(std::strlen(name.c_str()));
+
+            Member member;
+            member.type = result[1];
+            member.offset = result[2];
+            member.array_size = result[3];
+            member.array_stride = result[4];
+            member.matrix_stride = result[5];
+            member.is_row_major = result[6] != 0;
+            m_members[name] = member;
+        }
+
+        m_binding = binding;
+        glUniformBlockBinding(handle, block_index, binding);
+
+        glGenBuffers(1, &m_buffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+        glBufferData(GL_UNIFORM_BUFFER, m_data.size(), m_data.data(), GL_DYNAMIC_DRAW);
+        glBindBufferBase(GL_UNIFORM_BUFFER, m_binding, m_buffer);
+
+        m_dirty_begin = m_data.size();
+        m_dirty_end = 0;
+    }
+
+    void UniformBlock::Terminate()
+    {
+        if (m_buffer != 0)
+        {
+            glDeleteBuffers(1, &m_buffer);
+            m_buffer = 0;
+        }
+
+        m_data.clear();
+        m_members.clear();
+        m_dirty_begin = 0;
+        m_dirty_end = 0;
+    }
+
+    void UniformBlock::Set(const char* name, const glm::vec2& value)
+    {
+        Write(FindOffset(name, nullptr), &value, sizeof(glm::vec2));
+    }
+
+    void UniformBlock::Set(const char* name, const glm::vec3& value)
+    {
+        Write(FindOffset(name, nullptr), &value, sizeof(glm::vec3));
+    }
+
+    void UniformBlock::Set(const char* name, const glm::vec4& value)
+    {
+        Write(FindOffset(name, nullptr), &value, sizeof(glm::vec4));
+    }
+
+    void UniformBlock::Set(const char* name, const glm::mat3& value)
+    {
+        WriteMatrix<3, 3>(name, value);
+    }
+
+    void UniformBlock::Set(const char* name, const glm::mat4& value)
+    {
+        WriteMatrix<4, 4>(name, value);
+    }
+
+    void UniformBlock::Set(const char* name, float value)
+    {
+        Write(FindOffset(name, nullptr), &value, sizeof(value));
+    }
+
+    void UniformBlock::Set(const char* name, bool value)
+    {
+        // std140 中 bool 占 4 字节
+        GLint int_value = value ? 1 : 0;
+        Write(FindOffset(name, nullptr), &int_value, sizeof(int_value));
+    }
+
+    void UniformBlock::Set(const char* name, int value)
+    {
+        Write(FindOffset(name, nullptr), &value, sizeof(value));
+    }
+
+    void UniformBlock::Set(const char* name, GLuint value)
+    {
+        Write(FindOffset(name, nullptr), &value, sizeof(value));
+    }
+
+    void UniformBlock::Upload()
+    {
+        if (m_buffer == 0 || m_dirty_begin >= m_dirty_end)
+        {
+            return;
+        }
+
+        glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, m_dirty_begin, m_dirty_end - m_dirty_begin, m_data.data() + m_dirty_begin);
+
+        m_dirty_begin = m_data.size();
+        m_dirty_end = 0;
+    }
+
+    void UniformBlock::Bind()
+    {
+        glBindBufferBase(GL_UNIFORM_BUFFER, m_binding, m_buffer);
+    }
+
+    GLuint UniformBlock::GetBuffer() const
+    {
+        return m_buffer;
+    }
+
+    GLuint UniformBlock::GetBinding() const
+    {
+        return m_binding;
+    }
+
+    GLint UniformBlock::GetSize() const
+    {
+        return static_cast<GLint>(m_data.size());
+    }
+
+    bool UniformBlock::HasMember(const char* name)
+    {
+        return FindOffset(name, nullptr) >= 0;
+    }
+
+    GLint UniformBlock::FindOffset(const char* name, const Member** member)
+    {
+        std::unordered_map<std::string, Member>::iterator it = m_members.find(name);
+        if (it != m_members.end())
+        {
+            if (member != nullptr)
+            {
+                *member = &it->second;
+            }
+            return it->second.offset;
+        }
+
+        // 基础类型数组只反射出 "name[0]", 其余元素通过数组步长计算偏移
+        std::string element_name(name);
+        size_t bracket = element_name.rfind('[');
+        if (bracket == std::string::npos || element_name.back() != ']')
+        {
+            return -1;
+        }
+
+        int element = std::atoi(element_name.c_str() + bracket + 1);
+        it = m_members.find(element_name.substr(0, bracket) + "[0]");
+        if (it == m_members.end() || element < 0 || element >= it->second.array_size)
+        {
+            return -1;
+        }
+
+        if (member != nullptr)
+        {
+            *member = &it->second;
+        }
+        return it->second.offset + element * it->second.array_stride;
+    }
+
+    void UniformBlock::Write(GLint offset, const void* data, size_t size)
+    {
+        if (offset < 0 || offset + size > m_data.size())
+        {
+            return;
+        }
+
+        // 值没有变化时不标记为脏, 避免无意义的上传
+        unsigned char* destination = m_data.data() + offset;
+        if (std::memcmp(destination, data, size) == 0)
+        {
+            return;
+        }
+
+        std::memcpy(destination, data, size);
+        m_dirty_begin = std::min(m_dirty_begin, static_cast<size_t>(offset));
+        m_dirty_end = std::max(m_dirty_end, static_cast<size_t>(offset) + size);
+    }
+
+    template <int C, int R, typename M>
+    void UniformBlock::WriteMatrix(const char* name, const M& value)
+    {
+        const Member* member = nullptr;
+        GLint offset = FindOffset(name, &member);
+        if (offset < 0)
+        {
+            return;
+        }
+
+        // std140 中矩阵的每一列(或行)按 matrix_stride 对齐, 不能直接整体拷贝
+        for (int c = 0; c < C; ++c)
+        {
+            for (int r = 0; r < R; ++r)
+            {
+                GLint element_offset = member->is_row_major ? offset + r * member->matrix_stride + c * sizeof(GLfloat) : offset + c * member->matrix_stride + r * sizeof(GLfloat);
+                Write(element_offset, &value[c][r], sizeof(GLfloat));
+            }
+        }
+    }
+}
@@ -0,0 +1,49 @@
+﻿#include "common/obj_mesh.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+
+// 模型文件无法打开时输出错误并算作检查失败
+static bool CheckModel(const char* filename)
+{
+    try
+    {
+        return glsl_shader::ObjMesh::CheckAdjacency(filename);
+    }
+    catch (const std::runtime_error& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return false;
+    }
+}
+
+// 比较 LoadWithAdjacency 使用的线性时间邻接构建与原来逐对比较的实现,
+// 参数是要检查的模型, 没有参数时检查自带的模型; 有不同的索引时返回非零
+int main(int argc, char* argv[])
+{
+    const char* default_models[] =
+    {
+        "../../assets/models/bs_ears.obj",
+        "../../assets/models/pig_triangulated.obj",
+        "../../assets/models/spot_triangulated.obj"
+    };
+
+    bool passed = true;
+    if (argc > 1)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            passed = CheckModel(argv[i]) && passed;
+        }
+    }
+    else
+    {
+        for (const char* model : default_models)
+        {
+            passed = CheckModel(model) && passed;
+        }
+    }
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
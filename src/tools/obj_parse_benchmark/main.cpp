@@ -0,0 +1,52 @@
+﻿#include "common/obj_mesh.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+// 模型文件无法打开时输出错误, 继续测试其它模型
+static bool BenchmarkModel(const char* filename, unsigned int max_thread_count)
+{
+    try
+    {
+        glsl_shader::ObjMesh::BenchmarkParse(filename, max_thread_count);
+        return true;
+    }
+    catch (const std::runtime_error& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return false;
+    }
+}
+
+// 用 1 到 N 个线程分块解析模型, 输出耗时和吞吐量 (MB/s).
+// 用法: ObjParseBenchmark [模型文件...] [--threads N], 没有指定模型时使用 bs_ears.obj, N 默认为 CPU 核心数
+int main(int argc, char* argv[])
+{
+    unsigned int max_thread_count = 0;
+    int model_count = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::string(argv[i]) == "--threads" && i + 1 < argc)
+        {
+            max_thread_count = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else
+        {
+            argv[++model_count] = argv[i];
+        }
+    }
+
+    bool succeeded = true;
+    if (model_count == 0)
+    {
+        succeeded = BenchmarkModel("../../assets/models/bs_ears.obj", max_thread_count);
+    }
+    for (int i = 1; i <= model_count; ++i)
+    {
+        succeeded = BenchmarkModel(argv[i], max_thread_count) && succeeded;
+    }
+
+    return succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file